@@ -0,0 +1,5 @@
+// the board the emulator boots first, it plays the server
+#define EMU_NS board0
+#define EMU_FIRMWARE board0Firmware
+#define EMU_NAME "server"
+#include "firmware.h"
@@ -0,0 +1,5 @@
+// the board booting second, it plays the client
+#define EMU_NS board1
+#define EMU_FIRMWARE board1Firmware
+#define EMU_NAME "client"
+#include "firmware.h"
@@ -0,0 +1,571 @@
+#include "emu.h"
+
+#include <Arduino.h>
+#include <SSD1306.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include <esp_timer.h>
+#include <esp_sleep.h>
+#include <ucontext.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <deque>
+#include <vector>
+#include <string>
+
+/**********
+** Tasks and the virtual clock
+***********/
+struct EmuTask {
+  int board;
+  const char *name;
+  TaskFunction_t fn;
+  void *param;
+  ucontext_t context;
+  char *stack;
+  uint64_t wake; // EMU_FOREVER while waiting for a notification
+  uint32_t notified;
+};
+
+struct EmuTimer {
+  int board;
+  esp_timer_cb_t callback;
+  void *arg;
+  uint64_t deadline;
+};
+
+struct EmuBoard {
+  EmuFirmware *fw;
+  uint64_t mac;
+  uint64_t bootAt;
+  uint64_t random; // state of esp_random()
+  std::string serialLine; // printed, the line is not complete yet
+  std::vector<std::string> serialLines;
+  std::deque<uint8_t> serialIn;
+  SSD1306 *display;
+  bool accessPoint;
+  uint64_t joinAt; // the station is connected from then on, EMU_FOREVER: not joining
+  std::vector<std::pair<uint16_t, std::deque<int> > > listeners; // port and the connections to accept
+  uint64_t sleepUs; // esp_sleep_enable_timer_wakeup()
+  const char *halted;
+};
+
+EmuConfig emuConfig;
+uint64_t emuNow = 0;
+uint64_t emuRandom = 0; // the jitter
+uint32_t emuSwitchCount = 0;
+std::vector<EmuTask *> emuTasks;
+std::vector<EmuTimer *> emuTimers;
+EmuBoard emuBoards[EMU_MAX_BOARDS];
+int emuBoardCount = 0;
+EmuTask *emuCurrent = NULL; // the running task, NULL in the scheduler
+int emuCurrentBoard = -1; // also set while a timer callback runs
+ucontext_t emuScheduler;
+
+static uint64_t splitmix(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z>>30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z>>27)) * 0x94d049bb133111ebULL;
+  return z ^ (z>>31);
+}
+
+static EmuBoard *board() {
+  if (emuCurrentBoard<0) {
+    fprintf(stderr, "emu: a board function was called outside of the boards\n");
+    abort();
+  }
+  return &emuBoards[emuCurrentBoard];
+}
+
+static uint64_t boardTime() { return emuNow-board()->bootAt; }
+
+static bool onHost() { return emuCurrentBoard<0; } // called from a host test or tool
+
+// the stand-ins' own bookkeeping where the real thing does not allocate (the serial ring buffer,
+// lwIP's pbuf pools) does not count for the calling task (allocstats counts by task)
+struct EmuUntracked {
+  EmuTask *task;
+  EmuUntracked() : task(emuCurrent) { emuCurrent = NULL; }
+  ~EmuUntracked() { emuCurrent = task; }
+};
+
+static uint64_t hostTime() { // us since the first call
+  static uint64_t start = 0;
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t now = (uint64_t)ts.tv_sec*1000000+ts.tv_nsec/1000;
+  if (!start) start = now;
+  return now-start;
+}
+
+static void switchToScheduler() {
+  EmuTask *task = emuCurrent;
+  emuSwitchCount++;
+  swapcontext(&task->context, &emuScheduler);
+}
+
+static void sleepUs(uint64_t us) {
+  emuCurrent->wake = emuNow+us;
+  switchToScheduler();
+}
+
+static uint64_t nextDue(const EmuTask *except) {
+  uint64_t due = EMU_FOREVER;
+  for (size_t i=0; i<emuTasks.size(); i++) if (emuTasks[i]!=except) due = std::min(due, emuTasks[i]->wake);
+  for (size_t i=0; i<emuTimers.size(); i++) due = std::min(due, emuTimers[i]->deadline);
+  return due;
+}
+
+static void readClock() { // reading the clock takes a bit, so busy waits get somewhere
+  emuNow += EMU_CLOCK_READ_US;
+  if (emuCurrent && nextDue(emuCurrent)<emuNow) sleepUs(0); // the others catch up first
+}
+
+static void taskMain() {
+  EmuTask *task = emuCurrent;
+  task->fn(task->param);
+  fprintf(stderr, "emu: task %s returned\n", task->name); // FreeRTOS tasks must not
+  abort();
+}
+
+static EmuTask *createTask(int board, const char *name, TaskFunction_t fn, void *param, uint64_t start) {
+  EmuTask *task = new EmuTask();
+  task->board = board; task->name = name; task->fn = fn; task->param = param;
+  task->stack = (char *)malloc(EMU_STACK_SIZE);
+  task->wake = start;
+  task->notified = 0;
+  getcontext(&task->context);
+  task->context.uc_stack.ss_sp = task->stack;
+  task->context.uc_stack.ss_size = EMU_STACK_SIZE;
+  task->context.uc_link = NULL;
+  makecontext(&task->context, taskMain, 0);
+  emuTasks.push_back(task);
+  return task;
+}
+
+static void boardMain(void *param) { // the Arduino loop task
+  EmuFirmware *fw = (EmuFirmware *)param;
+  fw->setup();
+  for (;;) fw->loop();
+}
+
+void emuInit(const EmuConfig *config) {
+  emuConfig = *config;
+  emuRandom = config->seed;
+}
+
+int emuAddBoard(EmuFirmware *fw, uint64_t mac, uint64_t bootAt) {
+  int b = emuBoardCount++;
+  EmuBoard *board = &emuBoards[b];
+  board->fw = fw;
+  board->mac = mac;
+  board->bootAt = bootAt;
+  board->random = emuConfig.seed ^ (mac * 0x9e3779b97f4a7c15ULL);
+  board->display = NULL;
+  board->accessPoint = false;
+  board->joinAt = EMU_FOREVER;
+  board->sleepUs = 0;
+  board->halted = NULL;
+  createTask(b, "loopTask", boardMain, fw, bootAt);
+  return b;
+}
+
+bool emuRun(uint64_t until, bool (*done)()) {
+  while (!done()) {
+    EmuTask *task = NULL;
+    EmuTimer *timer = NULL;
+    for (size_t i=0; i<emuTasks.size(); i++) if (!task || emuTasks[i]->wake<task->wake) task = emuTasks[i];
+    for (size_t i=0; i<emuTimers.size(); i++) if (!timer || emuTimers[i]->deadline<timer->deadline) timer = emuTimers[i];
+    uint64_t due = std::min(task ? task->wake : EMU_FOREVER, timer ? timer->deadline : EMU_FOREVER);
+    if (due>until) return false;
+    emuNow = std::max(emuNow, due);
+    if (timer && timer->deadline==due) { // the esp_timer task
+      timer->deadline = EMU_FOREVER;
+      emuCurrentBoard = timer->board;
+      timer->callback(timer->arg);
+    } else {
+      emuCurrent = task;
+      emuCurrentBoard = task->board;
+      swapcontext(&emuScheduler, &task->context);
+      emuCurrent = NULL;
+    }
+    emuCurrentBoard = -1;
+  }
+  return true;
+}
+
+uint64_t emuTime() { return emuNow; }
+uint32_t emuSwitches() { return emuSwitchCount; }
+
+void emuSerialInput(int b, const char *text) {
+  while (*text) emuBoards[b].serialIn.push_back(*text++);
+}
+
+const char *emuSerialLine(int b, const char *prefix) {
+  std::vector<std::string> &lines = emuBoards[b].serialLines;
+  for (size_t i=lines.size(); i>0; i--)
+    if (lines[i-1].compare(0, strlen(prefix), prefix)==0) return lines[i-1].c_str();
+  return NULL;
+}
+
+SSD1306 *emuDisplay(int b) { return emuBoards[b].display; }
+const char *emuHalted(int b) { return emuBoards[b].halted; }
+
+/**********
+** Arduino core, ESP-IDF and FreeRTOS
+***********/
+HardwareSerial Serial(0);
+HardwareSerial Serial2(2);
+EspClass ESP;
+
+uint32_t micros() { if (onHost()) return hostTime(); readClock(); return boardTime(); }
+uint32_t millis() { if (onHost()) return hostTime()/1000; readClock(); return boardTime()/1000; }
+void delay(uint32_t ms) { if (onHost()) usleep(ms*1000); else sleepUs((uint64_t)ms*1000); }
+void delayMicroseconds(uint32_t us) { if (onHost()) usleep(us); else sleepUs(us); }
+
+uint16_t touchRead(uint8_t pin) { // low is touched
+  int8_t steer = board()->fw->steer();
+  bool touched = pin==T6 ? steer<0 : pin==T2 ? steer>0 : false;
+  return touched ? 20 : 120;
+}
+
+uint32_t esp_random() {
+  static uint64_t hostRandom = 0;
+  return (uint32_t)splitmix(onHost() ? &hostRandom : &board()->random);
+}
+
+long random(long howbig) { return howbig ? esp_random() % howbig : 0; }
+long random(long howsmall, long howbig) { return howsmall<howbig ? howsmall+random(howbig-howsmall) : howsmall; }
+
+uint64_t EspClass::getEfuseMac() { return board()->mac; }
+
+void EspClass::restart() {
+  board()->halted = "ESP.restart()";
+  for (;;) sleepUs(EMU_FOREVER-emuNow); // never scheduled again
+}
+
+String IPAddress::toString() const {
+  char buf[16];
+  uint32_t ip = *this;
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", ip&0xff, (ip>>8)&0xff, (ip>>16)&0xff, ip>>24);
+  return String(buf);
+}
+
+size_t Print::printf(const char *fmt, ...) {
+  char buf[512];
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  return write((const uint8_t *)buf, std::min(len, (int)sizeof(buf)-1));
+}
+
+size_t Stream::readBytes(uint8_t *buf, size_t len) {
+  size_t got = 0;
+  while (got<len && available()>0) buf[got++] = read();
+  return got;
+}
+
+int HardwareSerial::available() { return port==0 && !onHost() ? board()->serialIn.size() : 0; }
+int HardwareSerial::availableForWrite() { return 256; }
+
+int HardwareSerial::read() {
+  if (port!=0 || onHost()) return -1;
+  std::deque<uint8_t> &in = board()->serialIn;
+  if (in.empty()) return -1;
+  int c = in.front();
+  in.pop_front();
+  return c;
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len) {
+  if (port!=0) return len; // the cable goes nowhere
+  if (onHost()) return fwrite(buf, 1, len, stdout);
+  EmuUntracked untracked;
+  EmuBoard *b = board();
+  for (size_t i=0; i<len; i++) {
+    if (buf[i]=='\r') continue;
+    if (buf[i]!='\n') { b->serialLine += (char)buf[i]; continue; }
+    if (emuConfig.verbose) printf("[%s %9.3f] %s\n", b->fw->name, emuNow/1e6, b->serialLine.c_str());
+    b->serialLines.push_back(b->serialLine);
+    b->serialLine.clear();
+  }
+  return len;
+}
+
+const uint8_t ArialMT_Plain_10[] = { 0x0a, 0x0d, 0x20, 0xe0 }; // the header only, text is not drawn
+
+bool SSD1306::init() {
+  buffer = (uint8_t *)calloc(EMU_DISPLAY_WIDTH*EMU_DISPLAY_HEIGHT/8, 1);
+  if (!onHost()) board()->display = this;
+  return true;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+  EmuTask *task = createTask(emuCurrentBoard, name, fn, param, emuNow);
+  if (handle) *handle = (TaskHandle_t)task;
+  return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) { sleepUs((uint64_t)ticks*portTICK_PERIOD_MS*1000); }
+
+void vTaskDelete(TaskHandle_t task) {
+  for (;;) sleepUs(EMU_FOREVER-emuNow); // never scheduled again
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return (TaskHandle_t)emuCurrent; }
+
+struct EmuSemaphore {
+  UBaseType_t count;
+  UBaseType_t max;
+};
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial) {
+  SemaphoreHandle_t sem = new EmuSemaphore();
+  sem->count = initial;
+  sem->max = max;
+  return sem;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  if (sem->count>=sem->max) return pdFALSE;
+  sem->count++;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  for (TickType_t waited=0; !sem->count; waited++) {
+    if (ticks!=portMAX_DELAY && waited>=ticks) return pdFALSE;
+    vTaskDelay(1);
+  }
+  sem->count--;
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) { delete sem; }
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle) {
+  EmuTask *task = (EmuTask *)handle;
+  task->notified++;
+  if (task->wake==EMU_FOREVER) task->wake = emuNow;
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+  while (!emuCurrent->notified) sleepUs(ticks==portMAX_DELAY ? EMU_FOREVER-emuNow : (uint64_t)ticks*1000);
+  uint32_t count = emuCurrent->notified;
+  emuCurrent->notified = clearOnExit ? 0 : count-1;
+  return count;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle) {
+  EmuTimer *timer = new EmuTimer();
+  timer->board = emuCurrentBoard;
+  timer->callback = args->callback;
+  timer->arg = args->arg;
+  timer->deadline = EMU_FOREVER;
+  emuTimers.push_back(timer);
+  *handle = timer;
+  return 0;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t us) {
+  timer->deadline = emuNow+us;
+  return 0;
+}
+
+int64_t esp_timer_get_time() { if (onHost()) return hostTime(); readClock(); return boardTime(); }
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t us) { board()->sleepUs = us; return 0; }
+esp_err_t esp_light_sleep_start() { sleepUs(board()->sleepUs); return 0; }
+
+/**********
+** WiFi and TCP
+**   a connection is two byte pipes; a write arrives as a whole, in order, after the
+**   latency plus jitter of the run
+***********/
+struct EmuChunk {
+  uint64_t arrival;
+  std::vector<uint8_t> data;
+  size_t read;
+};
+
+struct EmuConnection {
+  std::deque<EmuChunk> pipe[2]; // pipe[side]: what side reads
+  uint64_t lastArrival[2];
+  bool open[2];
+};
+
+std::vector<EmuConnection> emuConnections;
+
+WiFiClass WiFi;
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+  EmuBoard *b = board();
+  if (!(mode & WIFI_AP)) b->accessPoint = false;
+  if (!(mode & WIFI_STA)) b->joinAt = EMU_FOREVER;
+  return true;
+}
+
+bool WiFiClass::softAP(const char *ssid, const char *password) { board()->accessPoint = true; return true; }
+void WiFiClass::begin(const char *ssid, const char *password) { board()->joinAt = emuNow+EMU_WIFI_JOIN_US; }
+bool WiFiClass::enableAP(bool enable) { if (!enable) board()->accessPoint = false; return true; }
+bool WiFiClass::enableSTA(bool enable) { if (!enable) board()->joinAt = EMU_FOREVER; return true; }
+
+static bool outage() { return emuNow>=emuConfig.outageAt && emuNow-emuConfig.outageAt<emuConfig.outageUs; }
+
+static int accessPoint() { // the board a station joins
+  if (outage()) return -1;
+  for (int b=0; b<emuBoardCount; b++) if (emuBoards[b].accessPoint) return b;
+  return -1;
+}
+
+wl_status_t WiFiClass::status() {
+  EmuBoard *b = board();
+  return accessPoint()>=0 && b->joinAt<=emuNow ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+void WiFiServer::begin() {
+  if (onHost()) { // on the loopback interface, non-blocking like lwIP's accept in the library
+    if (fd>=0) return; // listening already
+    signal(SIGPIPE, SIG_IGN); // lwIP has no SIGPIPE, a peer gone shows up as a failed send
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr))<0 || listen(fd, SOMAXCONN)<0) {
+      perror("emu: WiFiServer::begin");
+      abort();
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return;
+  }
+  board = emuCurrentBoard;
+  emuBoards[board].listeners.push_back(std::make_pair(port, std::deque<int>()));
+}
+
+WiFiClient WiFiServer::available() {
+  if (fd>=0) {
+    int s = accept(fd, NULL, NULL);
+    return s>=0 ? WiFiClient(s, EMU_HOST_SOCKET) : WiFiClient();
+  }
+  if (board<0) return WiFiClient();
+  std::vector<std::pair<uint16_t, std::deque<int> > > &listeners = emuBoards[board].listeners;
+  for (size_t i=0; i<listeners.size(); i++) {
+    if (listeners[i].first!=port || listeners[i].second.empty()) continue;
+    int conn = listeners[i].second.front();
+    listeners[i].second.pop_front();
+    return WiFiClient(conn, 1);
+  }
+  return WiFiClient();
+}
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+  stop();
+  int server = accessPoint();
+  if (server<0 || WiFi.status()!=WL_CONNECTED) return 0;
+  std::vector<std::pair<uint16_t, std::deque<int> > > &listeners = emuBoards[server].listeners;
+  for (size_t i=0; i<listeners.size(); i++) {
+    if (listeners[i].first!=port) continue;
+    EmuConnection c;
+    c.lastArrival[0] = c.lastArrival[1] = 0;
+    c.open[0] = c.open[1] = true;
+    emuConnections.push_back(c);
+    conn = emuConnections.size()-1;
+    side = 0;
+    listeners[i].second.push_back(conn);
+    return 1;
+  }
+  return 0; // refused
+}
+
+uint8_t WiFiClient::connected() {
+  if (side==EMU_HOST_SOCKET && conn>=0) { // gone once the peer's FIN (0) or an error is next
+    char c;
+    int n = recv(conn, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n>0 || (n<0 && (errno==EAGAIN || errno==EWOULDBLOCK));
+  }
+  return conn>=0 && emuConnections[conn].open[0] && emuConnections[conn].open[1];
+}
+
+int WiFiClient::available() {
+  if (conn<0) return 0;
+  if (side==EMU_HOST_SOCKET) {
+    int n = 0;
+    return ioctl(conn, FIONREAD, &n)<0 ? 0 : n;
+  }
+  std::deque<EmuChunk> &pipe = emuConnections[conn].pipe[side];
+  int avail = 0;
+  for (size_t i=0; i<pipe.size() && pipe[i].arrival<=emuNow; i++) avail += pipe[i].data.size()-pipe[i].read;
+  return avail;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t len) {
+  if (conn<0) return -1;
+  if (side==EMU_HOST_SOCKET) {
+    int n = recv(conn, buf, len, MSG_DONTWAIT);
+    return n>0 ? n : -1;
+  }
+  std::deque<EmuChunk> &pipe = emuConnections[conn].pipe[side];
+  size_t got = 0;
+  while (got<len && !pipe.empty() && pipe.front().arrival<=emuNow) {
+    EmuChunk &chunk = pipe.front();
+    size_t n = std::min(len-got, chunk.data.size()-chunk.read);
+    memcpy(buf+got, chunk.data.data()+chunk.read, n);
+    got += n;
+    chunk.read += n;
+    if (chunk.read==chunk.data.size()) pipe.pop_front();
+  }
+  return got ? (int)got : -1;
+}
+
+int WiFiClient::read() {
+  uint8_t c;
+  return read(&c, 1)==1 ? c : -1;
+}
+
+size_t WiFiClient::write(const uint8_t *buf, size_t len) {
+  if (side==EMU_HOST_SOCKET) {
+    int n = conn>=0 ? send(conn, buf, len, MSG_NOSIGNAL) : -1;
+    return n>0 ? n : 0;
+  }
+  if (!connected()) return 0;
+  if (outage()) return len; // lost in the air, the sender can not tell
+  EmuUntracked untracked;
+  EmuConnection &c = emuConnections[conn];
+  uint64_t jitter = emuConfig.jitterUs ? splitmix(&emuRandom) % emuConfig.jitterUs : 0;
+  uint64_t arrival = std::max(emuNow+emuConfig.latencyUs+jitter, c.lastArrival[1-side]); // TCP keeps the order
+  c.lastArrival[1-side] = arrival;
+  EmuChunk chunk;
+  chunk.arrival = arrival;
+  chunk.data.assign(buf, buf+len);
+  chunk.read = 0;
+  c.pipe[1-side].push_back(chunk);
+  return len;
+}
+
+void emuCutLinks() {
+  for (size_t i=0; i<emuConnections.size(); i++) { // what was still in flight is gone as well
+    EmuConnection &c = emuConnections[i];
+    c.open[0] = c.open[1] = false;
+    c.pipe[0].clear();
+    c.pipe[1].clear();
+  }
+}
+
+void WiFiClient::stop() {
+  if (conn>=0 && side==EMU_HOST_SOCKET) close(conn);
+  else if (conn>=0) emuConnections[conn].open[side] = false;
+  conn = -1;
+}
@@ -0,0 +1,64 @@
+#ifndef __EMU_H__
+#define __EMU_H__
+
+#include <stdint.h>
+
+/**********
+** Host emulator of the boards
+**   runs the unmodified setup()/loop() of several boards in one process on a virtual clock:
+**   every task of every board is a coroutine, the scheduler always resumes the one due
+**   first and moves the clock to its time; a task only gives up the CPU when it waits
+**   (delay, vTaskDelay, a task notification) or reads the clock, so code runs in no time
+**   at all except EMU_CLOCK_READ_US for every micros()/millis() (busy waits end)
+**
+**   the boards share the clock, their micros() count from their own boot; TCP connections
+**   deliver every write in order after latency + jitter, a station joins the WiFi of the
+**   board running the access point EMU_WIFI_JOIN_US after WiFi.begin(); an outage loses
+**   every write and keeps the stations out while it lasts, a cut resets the connections
+**
+**   firmware code called outside of the boards (from a host test or tool) runs on the
+**   host instead: the real clock, Serial on stdout and servers on loopback sockets
+***********/
+#define EMU_CLOCK_READ_US 1
+#define EMU_WIFI_JOIN_US 300000
+#define EMU_STACK_SIZE (256*1024) // of every task, the host's printf wants more than RECEIVER_STACK
+#define EMU_MAX_BOARDS 2
+#define EMU_FOREVER UINT64_MAX
+
+// one board's copy of the firmware (see emu/firmware.h)
+struct EmuFirmware {
+  const char *name;
+  void (*setup)();
+  void (*loop)();
+  uint32_t serverID; // the efuse MAC the firmware plays the server on
+  int8_t (*steer)(); // the autopilot on the touch pads: -1 up, 0 none, 1 down
+  bool (*gameOver)(); // the win/lose screen is up
+  void (*score)(uint8_t *self, uint8_t *other);
+};
+typedef struct EmuFirmware EmuFirmware;
+
+struct EmuConfig {
+  uint32_t latencyUs; // one way, of every TCP write
+  uint32_t jitterUs; // added uniformly on top of it
+  uint64_t seed; // of the jitter and of each board's esp_random()
+  bool verbose; // echo the boards' serial output
+  uint64_t outageAt; // the WiFi goes dark at this virtual time (us) ...
+  uint64_t outageUs; // ... for this long: writes are lost, stations can not join (0: never)
+};
+typedef struct EmuConfig EmuConfig;
+
+class SSD1306;
+
+void emuInit(const EmuConfig *config);
+int emuAddBoard(EmuFirmware *fw, uint64_t mac, uint64_t bootAt); // boots at the virtual time bootAt (us)
+bool emuRun(uint64_t until, bool (*done)()); // false if the virtual time ran out first
+uint64_t emuTime(); // the virtual time in us
+uint32_t emuSwitches(); // task switches so far
+void emuCutLinks(); // resets every TCP connection between the boards, both ends see it closed right away
+
+void emuSerialInput(int board, const char *text); // typed into the board's USB serial
+const char *emuSerialLine(int board, const char *prefix); // the last line the board printed starting so, or NULL
+SSD1306 *emuDisplay(int board); // NULL before display.init()
+const char *emuHalted(int board); // why the board stopped (ESP.restart()), or NULL
+
+#endif //__EMU_H__
@@ -0,0 +1,181 @@
+/**
+* Host emulator
+* Two boards play networked matches against each other on a virtual clock, the server
+* booting first; prints how it went and the metrics of both boards
+*
+*   .pio/build/native/program [--matches 2] [--latency 2000] [--jitter 1000] [--seed 1]
+*                             [--stagger 700] [--limit 3600] [--outage 30:5000]
+*                             [--screen] [--verbose]
+*
+* latency and jitter of the TCP writes are in us, stagger is how much later (ms) the client
+* boots, limit the virtual seconds the matches may take, outage takes the WiFi down at the
+* given virtual second for the given ms; exits with 1 if they did not end
+* in time, a board restarted, the two boards disagree on the score (unless the outage
+* made them fall back to local games) or a board counted trouble its link was not given:
+* without an outage no lost links, resumes or fallbacks, and without latency and jitter
+* either no late or dropped direction changes; also prints the server's goal line to
+* serve times, to measure the score commit under latency and jitter
+*
+*   .pio/build/native/program --bench > host.json
+*   .pio/build/native/program --tournament [--rallies 100000] [--workers 0]
+*
+* run the hot path benchmarks (src/benchmark.cpp) or the AI tournament (src/tournament.cpp,
+* rallies per setting, a thread per worker, 0: one per core) on the host's real clock instead
+*/
+#include "emu.h"
+#include <SSD1306.h>
+#include <chrono>
+#include <thread>
+
+#define EMU_SERVER 0
+#define EMU_CLIENT 1
+#define EMU_METRICS_TIME 5000000 // us the boards get to print their metrics
+
+extern EmuFirmware board0Firmware, board1Firmware;
+void hostBenchmarks(); // emu/host.cpp
+void hostTournament(uint32_t rallies, uint32_t workers);
+
+uint32_t matches = 2; // with a rematch in between
+uint32_t gameOvers[EMU_MAX_BOARDS]; // matches each board finished
+bool wasOver[EMU_MAX_BOARDS];
+uint8_t scores[EMU_MAX_BOARDS][2]; // self and other, of the last finished match
+EmuFirmware *firmwares[EMU_MAX_BOARDS] = { &board0Firmware, &board1Firmware };
+
+static bool matchesDone() {
+  bool done = true;
+  for (int b=0; b<EMU_MAX_BOARDS; b++) {
+    bool over = firmwares[b]->gameOver();
+    if (over && !wasOver[b]) {
+      gameOvers[b]++;
+      firmwares[b]->score(&scores[b][0], &scores[b][1]);
+      printf("%9.3f s  %s finished match %u: %u - %u\n", emuTime()/1e6, firmwares[b]->name, gameOvers[b], scores[b][0], scores[b][1]);
+    }
+    wasOver[b] = over;
+    if (gameOvers[b]<matches || emuHalted(b)) done = done && emuHalted(b)!=NULL;
+  }
+  return done;
+}
+
+const char *waitingFor; // the start of the serial line printed() waits for
+
+static bool printed() {
+  for (int b=0; b<EMU_MAX_BOARDS; b++) if (!emuSerialLine(b, waitingFor)) return false;
+  return true;
+}
+
+static void printScreen(int b) { // two pixel rows per line
+  SSD1306 *display = emuDisplay(b);
+  if (!display) return;
+  printf("%s screen:\n", firmwares[b]->name);
+  for (int y=0; y<EMU_DISPLAY_HEIGHT; y+=2) {
+    for (int x=0; x<EMU_DISPLAY_WIDTH; x++) {
+      bool top = display->buffer[x+(y/8)*EMU_DISPLAY_WIDTH] & (1<<(y%8));
+      bool bottom = display->buffer[x+((y+1)/8)*EMU_DISPLAY_WIDTH] & (1<<((y+1)%8));
+      fputs(top ? (bottom ? "█" : "▀") : (bottom ? "▄" : " "), stdout);
+    }
+    putchar('\n');
+  }
+}
+
+// a counter of a board's metrics line, 0 if it is not there
+static uint32_t metric(const char *line, const char *name) {
+  size_t len = strlen(name);
+  for (const char *p = line ? strstr(line, name) : NULL; p; p = strstr(p+1, name))
+    if (p>line && p[-1]==' ' && p[len]=='=') return strtoul(p+len+1, NULL, 10);
+  return 0;
+}
+
+static const char *option(int argc, char **argv, const char *name, const char *def) {
+  for (int i=1; i<argc-1; i++) if (!strcmp(argv[i], name)) return argv[i+1];
+  return def;
+}
+
+static bool flag(int argc, char **argv, const char *name) {
+  for (int i=1; i<argc; i++) if (!strcmp(argv[i], name)) return true;
+  return false;
+}
+
+int main(int argc, char **argv) {
+  if (flag(argc, argv, "--bench")) {
+    hostBenchmarks();
+    return 0;
+  }
+  if (flag(argc, argv, "--tournament")) {
+    uint32_t workers = atoi(option(argc, argv, "--workers", "0"));
+    hostTournament(atoi(option(argc, argv, "--rallies", "100000")), workers ? workers : std::max(1u, std::thread::hardware_concurrency()));
+    return 0;
+  }
+  EmuConfig config;
+  config.latencyUs = atoi(option(argc, argv, "--latency", "2000"));
+  config.jitterUs = atoi(option(argc, argv, "--jitter", "1000"));
+  config.seed = strtoull(option(argc, argv, "--seed", "1"), NULL, 0);
+  config.verbose = flag(argc, argv, "--verbose");
+  double outageAt = 0, outageMs = 0;
+  sscanf(option(argc, argv, "--outage", "0:0"), "%lf:%lf", &outageAt, &outageMs);
+  config.outageAt = outageAt*1e6;
+  config.outageUs = outageMs*1e3;
+  matches = atoi(option(argc, argv, "--matches", "2"));
+  uint64_t stagger = strtoull(option(argc, argv, "--stagger", "700"), NULL, 0)*1000;
+  uint64_t limit = strtoull(option(argc, argv, "--limit", "3600"), NULL, 0)*1000000;
+
+  emuInit(&config);
+  emuAddBoard(firmwares[EMU_SERVER], board0Firmware.serverID, 0);
+  emuAddBoard(firmwares[EMU_CLIENT], board1Firmware.serverID+1, stagger);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool finished = emuRun(limit, matchesDone);
+  double realMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+  uint64_t virtualUs = emuTime();
+
+  // the counters as a board sends them on the serial port, one after the other
+  const char *requests[2][2] = { { "M", "metrics v" }, { "L", "latency v" } };
+  for (int r=0; r<2; r++) {
+    for (int b=0; b<EMU_MAX_BOARDS; b++) emuSerialInput(b, requests[r][0]);
+    waitingFor = requests[r][1];
+    emuRun(emuTime()+EMU_METRICS_TIME, printed);
+  }
+  for (int b=0; b<EMU_MAX_BOARDS; b++) {
+    for (int r=0; r<2; r++) {
+      const char *line = emuSerialLine(b, requests[r][1]);
+      printf("%s %s\n", firmwares[b]->name, line ? line : "(nothing printed)");
+    }
+  }
+  // the server times the score handshake and the next serve from where it saw the ball cross the goal line
+  const char *serverMetrics = emuSerialLine(EMU_SERVER, "metrics v");
+  uint32_t serves = metric(serverMetrics, "serves");
+  if (serves) printf("goal line to serve at %u+%u us: %u serves, %.1f ms on average, %.1f ms at most\n",
+                     config.latencyUs, config.jitterUs, serves, metric(serverMetrics, "serve_us")/1e3/serves,
+                     metric(serverMetrics, "serve_max_us")/1e3);
+  if (flag(argc, argv, "--screen")) for (int b=0; b<EMU_MAX_BOARDS; b++) printScreen(b);
+  printf("%.3f s of virtual time in %.1f ms (%.0fx), %u task switches\n",
+         virtualUs/1e6, realMs, virtualUs/1e3/realMs, emuSwitches());
+
+  int status = 0;
+  bool fellBack = false;
+  // the link counters need an outage to move, the late ones latency or jitter
+  const char *healthy[] = { "links_lost", "resumes", "fallbacks", "late_msgs", "future_dropped" };
+  uint32_t checked = config.outageUs ? 0 : (config.latencyUs || config.jitterUs) ? 3 : 5;
+  for (int b=0; b<EMU_MAX_BOARDS; b++) {
+    if (emuHalted(b)) {
+      printf("%s halted: %s\n", firmwares[b]->name, emuHalted(b));
+      status = 1;
+    }
+    const char *line = emuSerialLine(b, "metrics v");
+    fellBack = fellBack || metric(line, "fallbacks");
+    for (uint32_t i=0; i<checked; i++) {
+      uint32_t value = metric(line, healthy[i]);
+      if (!value) continue;
+      printf("%s counted %s=%u on a link without %s\n", firmwares[b]->name, healthy[i], value, i<3 ? "an outage" : "impairments");
+      status = 1;
+    }
+  }
+  if (!finished) {
+    printf("the matches did not end within %llu s\n", (unsigned long long)(limit/1000000));
+    status = 1;
+  } else if (fellBack) {
+    printf("the boards fell back to local games, their scores are not compared\n");
+  } else if (scores[EMU_SERVER][0]!=scores[EMU_CLIENT][1] || scores[EMU_SERVER][1]!=scores[EMU_CLIENT][0]) {
+    printf("the boards disagree on the score\n");
+    status = 1;
+  }
+  return status;
+}
@@ -0,0 +1,80 @@
+/**********
+** One board's copy of the firmware
+**   every source of src/ is compiled into the namespace EMU_NS, so each board has its own
+**   globals while the stand-ins they call are shared; everything included from outside
+**   src/ comes first, its include guards keep it out of the namespace; EMU_FIRMWARE names
+**   what the emulator gets to run the board (see emu.h)
+***********/
+#include <Arduino.h>
+#include <SSD1306.h>
+#include <Wire.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_sleep.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <lwip/sockets.h>
+#include <atomic>
+#include <algorithm>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "emu.h"
+
+#define EMU_AIM_ERROR 9000 // the autopilot aims this much (1/1000 pixel) around the ball, the paddle reaches 6000
+#define EMU_LINGER_MAX 4000 // ms the autopilot may look at the win/lose screen before touching it
+
+namespace EMU_NS {
+#include "../src/main.cpp"
+#include "../src/allocstats.cpp"
+#include "../src/benchmark.cpp"
+#include "../src/blit.cpp"
+#include "../src/gamestate.cpp"
+#include "../src/helper.cpp"
+#include "../src/metrics.cpp"
+#include "../src/networkWiFi.cpp"
+#include "../src/pacerclock.cpp"
+#include "../src/serialframe.cpp"
+#include "../src/seriallink.cpp"
+#include "../src/spectator.cpp"
+#include "../src/tournament.cpp"
+#include "../src/wire.cpp"
+
+// the player: follows the ball coming at its paddle, aiming a bit off (drawn again for every ball)
+PongPRNG emuRng;
+int32_t emuAim = 0;
+bool emuComing = false;
+uint32_t emuLinger = 0; // drawn for every win/lose screen, so the boards touch it at different times
+bool emuOver = false;
+
+int8_t emuSteer() {
+  if (!emuRng.state) prngSeed(&emuRng, (uint32_t)ESP.getEfuseMac());
+  if (phase==PHASE_GAMEOVER) { // a touch starts the next match
+    if (!emuOver) emuLinger = prngRandom(&emuRng, 0, EMU_LINGER_MAX);
+    emuOver = true;
+    return millis()-phaseStart>=GAMEOVER_TIME+emuLinger ? 1 : 0;
+  }
+  emuOver = false;
+  PongGameState *state = curState();
+  bool coming = state->speedBallX<0;
+  if (coming && !emuComing) emuAim = prngRandom(&emuRng, -EMU_AIM_ERROR, EMU_AIM_ERROR+1);
+  emuComing = coming;
+  int32_t target = coming ? state->posBallY+emuAim : Arena::height*500;
+  int32_t diff = target-state->posSelf;
+  if (diff < -Arena::paddleMove) return -1;
+  if (diff > Arena::paddleMove) return 1;
+  return 0;
+}
+
+bool emuGameOver() { return phase==PHASE_GAMEOVER || (phase==PHASE_RESUME && resumePhase==PHASE_GAMEOVER); } // a resume does not end another match
+
+void emuScore(uint8_t *self, uint8_t *other) {
+  *self = curState()->scoreSelf;
+  *other = curState()->scoreOther;
+}
+}
+
+EmuFirmware EMU_FIRMWARE = { EMU_NAME, EMU_NS::setup, EMU_NS::loop, SERVERID, EMU_NS::emuSteer, EMU_NS::emuGameOver, EMU_NS::emuScore };
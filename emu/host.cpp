@@ -0,0 +1,21 @@
+// the firmware's copy for the host itself, called outside of the boards: the benchmarks and
+// the AI tournament on the real clock
+#define EMU_NS host
+#define EMU_FIRMWARE hostFirmware
+#define EMU_NAME "host"
+#define b2BENCHMARK
+#define b2TOURNAMENT
+#include "firmware.h"
+#include <thread>
+#include <vector>
+
+void hostBenchmarks() { host::runBenchmarks(); }
+
+void hostTournament(uint32_t rallies, uint32_t workers) { // a thread per worker instead of a task per core
+  host::tournamentStart(rallies);
+  uint32_t start = millis();
+  std::vector<std::thread> threads;
+  for (uint32_t i=0; i<workers; i++) threads.push_back(std::thread(host::tournamentPlay, false));
+  for (uint32_t i=0; i<workers; i++) threads[i].join();
+  host::tournamentReport(workers, millis()-start);
+}
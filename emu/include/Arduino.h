@@ -0,0 +1,113 @@
+#ifndef __EMU_ARDUINO_H__
+#define __EMU_ARDUINO_H__
+
+/**********
+** Stand-in of the Arduino core for the host emulator
+**   only what the firmware uses; the clock is virtual (see emu/emu.h), every call acts on
+**   the board whose task is running; called outside of the boards (host tests and tools)
+**   the clock is the real one and Serial prints to stdout
+***********/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_system.h"
+
+#define PI 3.1415926535897932384626433832795
+#define IRAM_ATTR
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define T2 2 // touch pins, as on the ESP32
+#define T6 6
+#define SERIAL_8N1 0x800001c
+
+class String {
+  public:
+    String(const char *s = "") : s(s) {}
+    String(int v) : s(std::to_string(v)) {}
+    String(unsigned v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+    const char *c_str() const { return s.c_str(); }
+    unsigned length() const { return s.size(); }
+    String operator+(const String &o) const { return String((s + o.s).c_str()); }
+  private:
+    std::string s;
+};
+
+class IPAddress {
+  public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) { bytes[0] = a; bytes[1] = b; bytes[2] = c; bytes[3] = d; }
+    String toString() const;
+    operator uint32_t() const { return bytes[0] | bytes[1]<<8 | bytes[2]<<16 | (uint32_t)bytes[3]<<24; }
+  private:
+    uint8_t bytes[4];
+};
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(const uint8_t *buf, size_t len) = 0;
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+    size_t print(const String &s) { return print(s.c_str()); }
+    size_t print(const IPAddress &ip) { return print(ip.toString()); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t print(unsigned long v) { return printf("%lu", v); }
+    size_t print(int v) { return print((long)v); }
+    size_t print(unsigned v) { return print((unsigned long)v); }
+    template<class T> size_t println(const T &v) { return print(v) + print("\r\n"); }
+    size_t println() { return print("\r\n"); }
+    size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual size_t readBytes(uint8_t *buf, size_t len);
+};
+
+class HardwareSerial : public Stream {
+  public:
+    HardwareSerial(int port) : port(port) {}
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1) {}
+    void end() {}
+    void setRxBufferSize(size_t size) {}
+    int available();
+    int availableForWrite();
+    int read();
+    using Print::write;
+    size_t write(const uint8_t *buf, size_t len);
+    operator bool() const { return true; }
+  private:
+    int port; // 0: the USB serial of the board, 2: the cable (not connected in the emulator)
+};
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;
+
+class EspClass {
+  public:
+    uint64_t getEfuseMac();
+    void restart() __attribute__((noreturn));
+    uint32_t getFreeHeap() { return 0; }
+};
+extern EspClass ESP;
+
+uint32_t micros(); // unsigned long on the ESP32 is 32 bits, so they wrap the same way here
+uint32_t millis();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+uint16_t touchRead(uint8_t pin);
+long random(long howbig); // from esp_random(), like the ESP32 core
+long random(long howsmall, long howbig);
+
+#endif //__EMU_ARDUINO_H__
@@ -0,0 +1,99 @@
+#ifndef __EMU_SSD1306_H__
+#define __EMU_SSD1306_H__
+
+/**********
+** Stand-in of the SSD1306 library for the host emulator
+**   the framebuffer is real (page ordered, 128x64), text is not rendered; the filled shapes
+**   and drawXbm are the library's own code (OLEDDisplay.cpp, in white only), so host tests can hold
+**   other ways of drawing against them
+***********/
+#include "Arduino.h"
+
+#define EMU_DISPLAY_WIDTH 128
+#define EMU_DISPLAY_HEIGHT 64
+
+enum OLEDDISPLAY_TEXT_ALIGNMENT { TEXT_ALIGN_LEFT, TEXT_ALIGN_RIGHT, TEXT_ALIGN_CENTER, TEXT_ALIGN_CENTER_BOTH };
+extern const uint8_t ArialMT_Plain_10[];
+
+class SSD1306 {
+  public:
+    SSD1306(uint8_t address, uint8_t sda, uint8_t scl) : buffer(NULL), frames(0) {}
+    bool init(); // allocates the framebuffer, like the library
+    void clear() { memset(buffer, 0, EMU_DISPLAY_WIDTH*EMU_DISPLAY_HEIGHT/8); }
+    void display() { frames++; }
+    void setFont(const uint8_t *font) {}
+    void setTextAlignment(OLEDDISPLAY_TEXT_ALIGNMENT align) {}
+    void drawString(int16_t x, int16_t y, const String &text) {}
+
+    void setPixel(int16_t x, int16_t y) {
+      if (x>=0 && x<EMU_DISPLAY_WIDTH && y>=0 && y<EMU_DISPLAY_HEIGHT) buffer[x+(y/8)*EMU_DISPLAY_WIDTH] |= 1<<(y&7);
+    }
+
+    void drawHorizontalLine(int16_t x, int16_t y, int16_t length) {
+      if (y<0 || y>=EMU_DISPLAY_HEIGHT) return;
+      if (x<0) { length+=x; x=0; }
+      if (x+length>EMU_DISPLAY_WIDTH) length=EMU_DISPLAY_WIDTH-x;
+      if (length<=0) return;
+      uint8_t *bufferPtr=buffer+(y>>3)*EMU_DISPLAY_WIDTH+x;
+      uint8_t drawBit=1<<(y&7);
+      while (length--) *bufferPtr++ |= drawBit;
+    }
+
+    void drawVerticalLine(int16_t x, int16_t y, int16_t length) {
+      if (x<0 || x>=EMU_DISPLAY_WIDTH) return;
+      if (y<0) { length+=y; y=0; }
+      if (y+length>EMU_DISPLAY_HEIGHT) length=EMU_DISPLAY_HEIGHT-y;
+      if (length<=0) return;
+      uint8_t yOffset=y&7, drawBit;
+      uint8_t *bufferPtr=buffer+(y>>3)*EMU_DISPLAY_WIDTH+x;
+      if (yOffset) { // the partial first page
+        yOffset=8-yOffset;
+        drawBit=~(0xFF>>yOffset);
+        if (length<yOffset) drawBit&=0xFF>>(yOffset-length);
+        *bufferPtr |= drawBit;
+        if (length<yOffset) return;
+        length-=yOffset;
+        bufferPtr+=EMU_DISPLAY_WIDTH;
+      }
+      while (length>=8) { // whole pages
+        *bufferPtr=0xFF;
+        bufferPtr+=EMU_DISPLAY_WIDTH;
+        length-=8;
+      }
+      if (length>0) *bufferPtr |= (1<<(length&7))-1;
+    }
+
+    void fillRect(int16_t xMove, int16_t yMove, int16_t width, int16_t height) {
+      for (int16_t x=xMove; x<xMove+width; x++) drawVerticalLine(x, yMove, height);
+    }
+
+    void fillCircle(int16_t x0, int16_t y0, int16_t radius) {
+      int16_t x=0, y=radius, dp=1-radius;
+      do {
+        if (dp<0) dp=dp+2*(++x)+3;
+        else dp=dp+2*(++x)-2*(--y)+5;
+        drawHorizontalLine(x0-x, y0-y, 2*x);
+        drawHorizontalLine(x0-x, y0+y, 2*x);
+        drawHorizontalLine(x0-y, y0-x, 2*y);
+        drawHorizontalLine(x0-y, y0+x, 2*y);
+      } while (x<y);
+      drawHorizontalLine(x0-radius, y0, 2*radius);
+    }
+
+    void drawXbm(int16_t xMove, int16_t yMove, int16_t width, int16_t height, const uint8_t *xbm) {
+      int16_t widthInXbm=(width+7)/8;
+      uint8_t data=0;
+      for (int16_t y=0; y<height; y++) {
+        for (int16_t x=0; x<width; x++) {
+          if (x&7) data>>=1; // move a bit
+          else data=pgm_read_byte(xbm+(x/8)+y*widthInXbm); // read new data every 8 bit
+          if (data&0x01) setPixel(xMove+x, yMove+y);
+        }
+      }
+    }
+
+    uint8_t *buffer;
+    uint32_t frames; // display() calls
+};
+
+#endif //__EMU_SSD1306_H__
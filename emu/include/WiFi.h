@@ -0,0 +1,40 @@
+#ifndef __EMU_WIFI_H__
+#define __EMU_WIFI_H__
+
+/**********
+** Stand-in of the ESP32 WiFi library for the host emulator
+**   a station joins once another board runs the access point, its TCP connections go to
+**   that board (see emu/emu.h for the link model); a server begun outside of the boards
+**   listens on a real loopback socket
+***********/
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+typedef enum { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 } wl_status_t;
+
+class WiFiClass {
+  public:
+    bool mode(wifi_mode_t mode);
+    bool softAP(const char *ssid, const char *password);
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+    void begin(const char *ssid, const char *password);
+    wl_status_t status();
+    IPAddress localIP() { return IPAddress(192, 168, 4, 2); }
+    bool enableAP(bool enable);
+    bool enableSTA(bool enable);
+};
+extern WiFiClass WiFi;
+
+class WiFiServer {
+  public:
+    WiFiServer(uint16_t port) : port(port), board(-1), fd(-1) {}
+    void begin();
+    WiFiClient available(); // a connection waiting to be accepted, or a false one
+  private:
+    uint16_t port;
+    int board; // listening on
+    int fd; // the listening socket on the host
+};
+
+#endif //__EMU_WIFI_H__
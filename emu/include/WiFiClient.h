@@ -0,0 +1,29 @@
+#ifndef __EMU_WIFICLIENT_H__
+#define __EMU_WIFICLIENT_H__
+
+#include "Arduino.h"
+
+#define EMU_HOST_SOCKET 2 // the side of a real socket, accepted outside of the boards
+
+// one end of an emulated TCP connection, copies share it like the library's
+class WiFiClient : public Stream {
+  public:
+    WiFiClient(int conn = -1, int side = 0) : conn(conn), side(side) {}
+    int connect(const char *host, uint16_t port);
+    uint8_t connected();
+    operator bool() const { return conn>=0; }
+    int available();
+    int read();
+    int read(uint8_t *buf, size_t len);
+    using Print::write;
+    size_t write(const uint8_t *buf, size_t len);
+    void stop();
+    int setNoDelay(bool noDelay) { return 0; }
+    IPAddress remoteIP() const { return side ? IPAddress(192, 168, 4, 2) : IPAddress(192, 168, 4, 1); }
+    int fd() const { return side==EMU_HOST_SOCKET ? conn : -1; } // an emulated connection has no socket to hand to lwip
+  private:
+    int conn; // index into the emulator's connections, -1: none (the socket of EMU_HOST_SOCKET)
+    int side; // 0: the connecting end, 1: the accepted one, EMU_HOST_SOCKET
+};
+
+#endif //__EMU_WIFICLIENT_H__
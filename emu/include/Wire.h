@@ -0,0 +1 @@
+// the I2C bus of the display, nothing of it is used on the host
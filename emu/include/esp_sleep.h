@@ -0,0 +1,9 @@
+#ifndef __EMU_ESP_SLEEP_H__
+#define __EMU_ESP_SLEEP_H__
+
+#include "esp_timer.h"
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t us);
+esp_err_t esp_light_sleep_start(); // advances the clock by the wakeup time
+
+#endif //__EMU_ESP_SLEEP_H__
@@ -0,0 +1,8 @@
+#ifndef __EMU_ESP_SYSTEM_H__
+#define __EMU_ESP_SYSTEM_H__
+
+#include <stdint.h>
+
+uint32_t esp_random(); // seeded per board (and once on the host), a run is reproducible
+
+#endif //__EMU_ESP_SYSTEM_H__
@@ -0,0 +1,22 @@
+#ifndef __EMU_ESP_TIMER_H__
+#define __EMU_ESP_TIMER_H__
+
+#include <stdint.h>
+
+typedef struct EmuTimer *esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void *arg);
+typedef enum { ESP_TIMER_TASK } esp_timer_dispatch_t;
+typedef struct {
+  esp_timer_cb_t callback;
+  void *arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char *name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+typedef int esp_err_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t us); // the callback runs on the virtual clock
+int64_t esp_timer_get_time();
+
+#endif //__EMU_ESP_TIMER_H__
@@ -0,0 +1,18 @@
+#ifndef __EMU_FREERTOS_H__
+#define __EMU_FREERTOS_H__
+
+#include <stdint.h>
+
+typedef struct EmuTask *TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portTICK_PERIOD_MS 1
+#define portMAX_DELAY 0xffffffffUL
+#define pdMS_TO_TICKS(ms) (ms)
+
+#endif //__EMU_FREERTOS_H__
@@ -0,0 +1,17 @@
+#ifndef __EMU_FREERTOS_SEMPHR_H__
+#define __EMU_FREERTOS_SEMPHR_H__
+
+/**********
+** Stand-in of the FreeRTOS counting semaphores for the host emulator
+**   a task taking an empty one polls it every tick
+***********/
+#include "FreeRTOS.h"
+
+typedef struct EmuSemaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+#endif //__EMU_FREERTOS_SEMPHR_H__
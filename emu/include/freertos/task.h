@@ -0,0 +1,21 @@
+#ifndef __EMU_FREERTOS_TASK_H__
+#define __EMU_FREERTOS_TASK_H__
+
+/**********
+** Stand-in of the FreeRTOS tasks for the host emulator
+**   tasks are coroutines of the emulator's scheduler, they switch only when they wait
+**   (a delay, a notification or reading the clock), both cores are one
+***********/
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *param);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task); // only the calling one (NULL)
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks);
+
+#endif //__EMU_FREERTOS_TASK_H__
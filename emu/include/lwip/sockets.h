@@ -0,0 +1,8 @@
+#ifndef __EMU_LWIP_SOCKETS_H__
+#define __EMU_LWIP_SOCKETS_H__
+
+// the spectators' socket calls: on the host's sockets, an emulated connection has none (fd() is -1)
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#endif //__EMU_LWIP_SOCKETS_H__
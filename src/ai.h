@@ -0,0 +1,116 @@
+#ifndef __AI_H__
+#define __AI_H__
+
+#include <Arduino.h>
+#include "b2debug.h"
+#include "arena.h"
+#include "gamestate.h"
+#include "helper.h"
+#include "prng.h"
+
+// AI state
+struct PongAI {
+  bool hasPred;
+  int32_t predElapsed;
+  int32_t predSpeedX;
+  int32_t predSpeedY;
+  int32_t predExactX;
+  int32_t predExactY;
+  int32_t predPosY;
+  int32_t aiError; // error factor (depends on how far the ball is)
+  int32_t aiReaction; // time "to estimate"
+  int32_t aiForesee; // foresee capability
+  PongPRNG rng; // source of the prediction error
+};
+typedef struct PongAI PongAI;
+
+inline void initAI(PongAI *ai, int32_t aiError = 80, int32_t aiReaction = 500000, int32_t aiForesee = 1000000) {
+  ai->hasPred = false;
+  ai->predElapsed = 0;
+  ai->aiError = aiError;
+  ai->aiReaction = aiReaction; // default: half of a second
+  ai->aiForesee = aiForesee; // default: one second
+  prngSeed(&ai->rng, 1);
+}
+
+inline void seedAI(PongAI *ai, uint32_t seed) {
+  prngSeed(&ai->rng, seed);
+}
+
+template<class A>
+bool predict(PongAI *ai, int32_t deltaTime, PongGameState *state) {
+  // only re-predict if the ball changed direction, or its been some amount of time since last prediction
+  if (ai->hasPred && // we have earlier prediction
+			((ai->predSpeedX * state->speedBallX) > 0) && // no direction change since then
+			((ai->predSpeedY * state->speedBallY) > 0) && // no direction change since then
+			(ai->predElapsed < ai->aiReaction)) { // and we are not yet recalibrating
+		ai->predElapsed += deltaTime; // some time elapsed
+		return true;
+	}
+
+  int32_t interceptTime = deltaTime;
+	int32_t intX = (A::width-A::paddleWidth)*1000;
+	int32_t intY;
+  bool intercept = checkVCollision(intX, -10000000, 10000000,
+																	 state->posBallX, state->posBallY, state->speedBallX, state->speedBallY,
+																	 ai->aiForesee, &interceptTime); 
+	if (intercept) {
+		intY = state->posBallY+interceptTime*state->speedBallY/1000;
+		dbgf5(b2DEBUG_AIPRED, "ball: (%d;%d) ballspeed: (%d;%d) intercept: y=%d", state->posBallX, state->posBallY, state->speedBallX, state->speedBallY, intY);
+
+    int32_t t = A::wallTop; //this.minY + ball.radius;
+    int32_t b = A::wallBottom; //this.maxY + this.height - ball.radius;
+
+		while ((intY < t) || (intY > b)) {
+			if (intY < t) {
+				intY = t + (t - intY);
+			} else if (intY > b) {
+				intY = t + (b - t) - (intY - b);
+			}
+		}
+		ai->hasPred = true;
+		dbgf(b2DEBUG_AIPRED," intercept adjusted: y=%d", intY);
+	} else {
+		ai->hasPred = false;
+	}
+
+	if (ai->hasPred) {
+		ai->predElapsed = 0;
+		ai->predSpeedX = state->speedBallX;
+		ai->predSpeedY = state->speedBallY;
+		ai->predExactX = intX;
+		ai->predExactY = intY;
+		int32_t closeness = (ai->predSpeedX < 0 ? state->posBallX - A::wallLength : (A::width-A::paddleWidth)*1000 - state->posBallX) / A::width;
+		int32_t error = ai->aiError * closeness;
+		ai->predPosY = ai->predExactY + prngRandom(&ai->rng, -error, error);
+		dbgf5(b2DEBUG_AIPRED," prediction: exact=(%d;%d) y=%d closeness=%d error=%d\n", ai->predExactX, ai->predExactY, ai->predPosY, closeness, error);
+	}
+	return ai->hasPred;
+}
+
+template<class A>
+void calcAI(PongAI *ai, PongGameState *state, PongGameState *pState) {
+	// calc deltaTime
+	int32_t deltaTime = A::frameTime;
+	// don't do any AI thing if ball is over the other side of the paddle
+	if (((pState->posBallX < (A::width-A::paddleWidth)*1000) && (pState->speedBallX < 0)) ||
+			((pState->posBallX > A::wallLength) && (pState->speedBallX > 0))) {
+		state->dirOther=0;
+		return;
+	}
+  // predict the ball position
+	predict<A>(ai, deltaTime, pState);
+	// handle prediction to movement conversion
+	if (ai->hasPred) {
+		if (ai->predPosY < pState->posOther - 5000) {
+			state->dirOther=-1;
+		} else if (ai->predPosY > pState->posOther + 5000) {
+			state->dirOther=1;
+		} else {
+			state->dirOther=0;
+		}
+		dbgf3(b2DEBUG_AIMOVE, "predicted pos: %d, paddle pos: %d, AI move dir: %d\n", ai->predPosY, pState->posOther, state->dirOther);
+	} else state->dirOther = 0; // no prediction no move
+}
+
+#endif //__AI_H__
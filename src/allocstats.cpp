@@ -0,0 +1,45 @@
+#include "allocstats.h"
+
+#ifdef b2DEBUG_ALLOC
+#include <Arduino.h>
+#include <assert.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+volatile uint32_t allocCount = 0;
+uint32_t allocFrames = 0;
+bool allocSkip = false;
+TaskHandle_t allocTask = NULL;
+
+extern "C" {
+  void *__real_malloc(size_t size);
+  void *__real_calloc(size_t n, size_t size);
+  void *__real_realloc(void *ptr, size_t size);
+
+  void *__wrap_malloc(size_t size) {
+    if (allocTask && xTaskGetCurrentTaskHandle()==allocTask) allocCount++;
+    return __real_malloc(size);
+  }
+  void *__wrap_calloc(size_t n, size_t size) {
+    if (allocTask && xTaskGetCurrentTaskHandle()==allocTask) allocCount++;
+    return __real_calloc(n, size);
+  }
+  void *__wrap_realloc(void *ptr, size_t size) {
+    if (allocTask && xTaskGetCurrentTaskHandle()==allocTask) allocCount++;
+    return __real_realloc(ptr, size);
+  }
+}
+
+void allocTrackTask() { allocTask=xTaskGetCurrentTaskHandle(); }
+void allocFrameStart() { allocCount=0; allocSkip=false; }
+uint32_t allocFrameCount() { return allocCount; }
+void allocFrameSkip() { allocSkip=true; }
+
+void allocFrameCheck() {
+  uint32_t n=allocCount;
+  if (allocFrames<ALLOC_WARMUP_FRAMES) { allocFrames++; return; }
+  if (allocSkip) return;
+  if (n) Serial.printf("Frame allocated %d times\n", n);
+  assert(n==0);
+}
+#endif
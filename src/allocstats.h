@@ -0,0 +1,26 @@
+#ifndef __ALLOCSTATS_H__
+#define __ALLOCSTATS_H__
+
+#include <stdint.h>
+
+/**********
+** Heap use instrumentation of the game loop
+**   enabled with b2DEBUG_ALLOC, which also needs the malloc family wrapped by the linker:
+**   -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc (see the lolin32_alloc environment)
+***********/
+#ifdef b2DEBUG_ALLOC
+#define ALLOC_WARMUP_FRAMES 3 // the first frames after boot may still set things up
+
+void allocTrackTask(); // count the allocations made from the calling task only
+void allocFrameStart();
+uint32_t allocFrameCount(); // allocations since allocFrameStart()
+void allocFrameSkip(); // this frame is not steady state (reconnecting goes through the WiFi stack)
+void allocFrameCheck(); // asserts that the frame did not allocate
+#else
+#define allocTrackTask()
+#define allocFrameStart()
+#define allocFrameSkip()
+#define allocFrameCheck()
+#endif
+
+#endif //__ALLOCSTATS_H__
@@ -0,0 +1,45 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stdint.h>
+
+/**********
+** Compile-time arena configuration
+**   every size is given in pixels, the simulation works in 1/1000 pixels
+**   so the derived bounds below are already scaled
+***********/
+template<int32_t Width, int32_t Height, int32_t PaddleWidth, int32_t PaddleHeight, int32_t BallRadius,
+         int32_t MoveSpeed = Height, int32_t FrameTime = 33333>
+struct PongArena {
+  static constexpr int32_t width = Width;
+  static constexpr int32_t height = Height;
+  static constexpr int32_t paddleWidth = PaddleWidth;
+  static constexpr int32_t paddleHeight = PaddleHeight;
+  static constexpr int32_t ballRadius = BallRadius;
+  static constexpr int32_t moveSpeed = MoveSpeed; // pixels per second
+  static constexpr int32_t frameTime = FrameTime; // microseconds
+
+  // paddle movement in one frame and the range of the paddle center
+  static constexpr int32_t paddleMove = FrameTime * MoveSpeed / 1000;
+  static constexpr int32_t paddleMin = PaddleHeight * 1000 / 2;
+  static constexpr int32_t paddleMax = (Height - PaddleHeight / 2) * 1000;
+  // collision segments of the ball center
+  static constexpr int32_t wallTop = BallRadius * 1000;
+  static constexpr int32_t wallBottom = (Height - BallRadius) * 1000;
+  static constexpr int32_t wallLength = Width * 1000;
+  static constexpr int32_t paddleSelfX = (PaddleWidth + BallRadius) * 1000;
+  static constexpr int32_t paddleOtherX = (Width - PaddleWidth - BallRadius) * 1000;
+  static constexpr int32_t paddleReach = PaddleHeight * 500 + BallRadius * 1000; // half paddle plus ball radius
+  // scoring lines
+  static constexpr int32_t goalSelf = -BallRadius * 1000; // the whole ball left the arena, mirrors goalOther
+  static constexpr int32_t goalOther = (Width + BallRadius) * 1000;
+
+  static_assert(Width > 2 * PaddleWidth + 2 * BallRadius, "arena is too narrow");
+  static_assert(Height > PaddleHeight && Height > 2 * BallRadius, "arena is too low");
+};
+
+// the arenas of the supported displays
+typedef PongArena<128, 64, 3, 8, 2> SSD1306Arena; // 128x64 OLED (default)
+typedef PongArena<128, 32, 2, 6, 1> SSD1306ShortArena; // 128x32 OLED
+
+#endif //__ARENA_H__
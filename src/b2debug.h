@@ -11,6 +11,8 @@
 // debug mask
 //#define b2DEBUG (b2DEBUG_WIFI | b2DEBUG_SCORE)
 //#define b2DEBUG_FPS 
+//#define b2BENCHMARK // run the hot path benchmarks at startup (see benchmark.h)
+//#define b2TOURNAMENT // sweep the AI settings in headless AI-vs-AI rallies at startup (see tournament.h)
 // debug macros
 #ifdef b2DEBUG
 #define dbgstart() Serial.begin(115200)
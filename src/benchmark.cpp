@@ -0,0 +1,286 @@
+#include "benchmark.h"
+#include "b2debug.h"
+
+#ifdef b2BENCHMARK
+#include <Arduino.h>
+#include "arena.h"
+#include "gamestate.h"
+#include "physics.h"
+#include "ai.h"
+#include "networkWiFi.h"
+#include "wire.h"
+#include "prng.h"
+#include "collision.h"
+#include "blit.h"
+
+#define BENCH_MIN_TIME 200000 // every benchmark runs for at least 0.2 seconds
+#define BENCH_BATCH 64 // operations between two clock reads
+#define BENCH_STREAM_MSGS 64 // messages in the parsed stream
+#define BENCH_PRNG_SEED 12345 // tools/prng.py prints the sequence every platform must produce from it
+#define BENCH_PRNG_COUNT 8
+#define BENCH_MAX_BALLS 1000
+#define BENCH_SEGMENTS 8
+#define BENCH_PEGS 56 // short two sided obstacles scattered over the arena, for a world with many segments
+
+typedef SSD1306Arena BenchArena;
+
+volatile int32_t benchSink; // keeps the compiler from dropping the measured code
+bool benchFirst;
+static CollisionWorld<BENCH_MAX_BALLS, BENCH_SEGMENTS+BENCH_PEGS> benchWorld; // too big for the stack
+
+template<class F>
+void bench(const char *name, int32_t param, F op) {
+  uint32_t iterations=0, start=micros(), elapsed;
+  do {
+    for (int i=0; i<BENCH_BATCH; i++) op();
+    iterations+=BENCH_BATCH;
+    elapsed=micros()-start;
+  } while (elapsed<BENCH_MIN_TIME);
+  Serial.printf("%s\n    {\"name\": \"%s\", \"param\": %d, \"iterations\": %u, \"ns_per_op\": %u}",
+                benchFirst?"":",", name, param, iterations, (uint32_t)((uint64_t)elapsed*1000/iterations));
+  benchFirst=false;
+}
+
+// op changes what it works on, so reset puts it back before every op; the time of the resets alone is taken off
+template<class R, class F>
+void benchReset(const char *name, int32_t param, R reset, F op) {
+  uint32_t iterations=0, start=micros(), elapsed, resets=0, resetElapsed;
+  do {
+    for (int i=0; i<BENCH_BATCH; i++) { reset(); op(); }
+    iterations+=BENCH_BATCH;
+    elapsed=micros()-start;
+  } while (elapsed<BENCH_MIN_TIME);
+  start=micros();
+  do {
+    for (int i=0; i<BENCH_BATCH; i++) reset();
+    resets+=BENCH_BATCH;
+    resetElapsed=micros()-start;
+  } while (resetElapsed<BENCH_MIN_TIME);
+  uint64_t ns=(uint64_t)elapsed*1000/iterations, resetNs=(uint64_t)resetElapsed*1000/resets;
+  Serial.printf("%s\n    {\"name\": \"%s\", \"param\": %d, \"iterations\": %u, \"ns_per_op\": %u}",
+                benchFirst?"":",", name, param, iterations, (uint32_t)(ns>resetNs ? ns-resetNs : 0));
+  benchFirst=false;
+}
+
+// a served ball half way between the paddles
+static void benchState(PongGameState *state, int32_t speedX, int32_t speedY) {
+  memset(state, 0, sizeof(PongGameState));
+  state->posSelf=BenchArena::height*500;
+  state->posOther=BenchArena::height*500;
+  state->posBallX=BenchArena::width*500;
+  state->posBallY=BenchArena::height*500;
+  state->speedBallX=speedX;
+  state->speedBallY=speedY;
+}
+
+// fills the history ring with a rally, like the game loop does
+static void benchHistory(int32_t speedX, int32_t speedY) {
+  initBuffer();
+  bufferAdd();
+  benchState(curState(), speedX, speedY);
+  curState()->frameID=0;
+  for (int i=1; i<GAMESTATE_BUFFER_SIZE; i++) {
+    PongGameState *pState=curState();
+    PongGameState *state=copyLatestState();
+    state->dirSelf=(i/10)%3-1;
+    state->dirOther=(i/7)%3-1;
+    recalcFrame<BenchArena>(state, pState);
+  }
+}
+
+// the frames from frameID to the latest one, saved and put back around each rollback
+static PongGameState benchSaved[GAMESTATE_BUFFER_SIZE];
+
+static uint32_t benchSave(uint32_t frameID) {
+  uint32_t n=0;
+  for (uint32_t idx=getStateIdxWithID(frameID); idx!=NO_FRAME; idx=nextState(idx)) benchSaved[n++]=*getState(idx);
+  return n;
+}
+
+static void benchRestore(uint32_t frameID, uint32_t n) {
+  uint32_t idx=getStateIdxWithID(frameID);
+  for (uint32_t i=0; i<n; i++, idx=nextState(idx)) *getState(idx)=benchSaved[i];
+}
+
+// a closed arena (walls behind the paddles) with a two sided obstacle in the middle, pegs and balls all over
+static void benchBalls(uint32_t balls, uint32_t pegs, PongPRNG *rng) {
+  const int32_t w=BenchArena::wallLength, top=BenchArena::wallTop, bottom=BenchArena::wallBottom, mid=BenchArena::height*500;
+  const PongSegment segs[BENCH_SEGMENTS] = {
+    { false, top, 0, w, -1, 0 }, { false, bottom, 0, w, 1, 0 },
+    { true, BenchArena::paddleSelfX, mid-BenchArena::paddleReach, mid+BenchArena::paddleReach, -1, 1 },
+    { true, BenchArena::paddleOtherX, mid-BenchArena::paddleReach, mid+BenchArena::paddleReach, 1, -1 },
+    { true, 0, top, bottom, -1, 0 }, { true, w, top, bottom, 1, 0 },
+    { true, w/2, mid-8000, mid+8000, -1, 0 }, { true, w/2, mid-8000, mid+8000, 1, 0 },
+  };
+  benchWorld.clear();
+  for (int i=0; i<BENCH_SEGMENTS; i++) benchWorld.addSegment(segs[i]);
+  for (uint32_t i=0; i<pegs; i+=2) {
+    int32_t x=prngRandom(rng, 4000, w-4000), y=prngRandom(rng, top+2000, bottom-2000);
+    PongSegment left = { true, x, y-1500, y+1500, -1, 0 }, right = { true, x, y-1500, y+1500, 1, 0 };
+    benchWorld.addSegment(left);
+    benchWorld.addSegment(right);
+  }
+  for (uint32_t i=0; i<balls; i++) {
+    PongBall ball = { prngRandom(rng, 1000, w-1000), prngRandom(rng, top+1000, bottom-1000), prngRandom(rng, -450, 450), prngRandom(rng, -450, 450) };
+    benchWorld.addBall(ball);
+  }
+}
+
+static uint32_t benchStream(uint8_t *buf) { // a stream of C/P/Q/F messages as they arrive from the peer
+  uint32_t len=0, fid=1234, other=1200;
+  for (int i=0; i<BENCH_STREAM_MSGS; i++, fid++) {
+    switch (i%4) {
+      case 0: case 2:
+        buf[len++]='C'; memcpy(buf+len, &fid, 4); len+=4; buf[len++]=(int8_t)(i%3-1); memcpy(buf+len, &other, 4); memcpy(buf+len+4, &fid, 4); len+=8;
+        break;
+      case 1:
+        buf[len++]=(i%8==1)?'P':'Q'; memcpy(buf+len, &fid, 4); memcpy(buf+len+4, &other, 4); memcpy(buf+len+8, &fid, 4); len+=12;
+        break;
+      case 3:
+        buf[len++]='F'; memcpy(buf+len, &fid, 4); len+=4; buf[len++]=1;
+        break;
+    }
+  }
+  return len;
+}
+
+void runBenchmarks() {
+  Serial.begin(115200);
+  delay(100);
+  Serial.printf("{\n  \"version\": 1,\n  \"min_time_us\": %d,\n", BENCH_MIN_TIME);
+  PongPRNG rng;
+  prngSeed(&rng, BENCH_PRNG_SEED);
+  Serial.printf("  \"prng_sequence\": [");
+  for (int i=0; i<BENCH_PRNG_COUNT; i++) Serial.printf("%s%u", i?", ":"", prngNext(&rng));
+  Serial.printf("],\n  \"benchmarks\": [");
+  benchFirst=true;
+  PongGameState a, b;
+  int32_t t;
+
+  // collision narrowphase: a hit and a miss of the top wall and of the right paddle
+  bench("checkHCollision_hit", 0, [&]() { benchSink+=checkHCollision(0, 2000, 128000, 60000, 2500, 45, -45, 33333, &t); });
+  bench("checkHCollision_miss", 0, [&]() { benchSink+=checkHCollision(0, 2000, 128000, 60000, 30000, 45, -45, 33333, &t); });
+  bench("checkVCollision_hit", 0, [&]() { benchSink+=checkVCollision(123000, 28000, 36000, 122000, 32000, 45, 10, 33333, &t); });
+  bench("checkVCollision_miss", 0, [&]() { benchSink+=checkVCollision(123000, 28000, 36000, 60000, 32000, 45, 10, 33333, &t); });
+
+  // one frame of physics at a typical serve speed and at extreme ones
+  const int32_t speeds[] = { 45, 450, 4500 };
+  for (int i=0; i<3; i++) {
+    benchState(&b, speeds[i], speeds[i]*2/3);
+    bench("recalcFrame", speeds[i], [&]() { a.dirSelf=1; a.dirOther=-1; recalcFrame<BenchArena>(&a, &b); benchSink+=a.posBallX; });
+  }
+
+  // one frame of many balls: the sweep-and-prune broadphase against testing every ball with every segment,
+  // in the arena alone (CollisionWorld tests every pair itself there) and with pegs (_pegs)
+  const uint32_t ballCounts[] = { 1, 10, 100, 1000 };
+  for (uint32_t pegs=0; pegs<=BENCH_PEGS; pegs+=BENCH_PEGS) {
+    for (int i=0; i<4; i++) {
+      prngSeed(&rng, BENCH_PRNG_SEED);
+      benchBalls(ballCounts[i], pegs, &rng);
+      bench(pegs ? "collisionWorld_pegs" : "collisionWorld", ballCounts[i], [&]() { benchWorld.step(BenchArena::frameTime); benchSink+=benchWorld.ball(0)->x; });
+      prngSeed(&rng, BENCH_PRNG_SEED);
+      benchBalls(ballCounts[i], pegs, &rng);
+      bench(pegs ? "collisionBrute_pegs" : "collisionBrute", ballCounts[i], [&]() {
+        for (uint32_t j=0; j<benchWorld.ballCount(); j++) {
+          PongBall *ball=benchWorld.ball(j);
+          int32_t hit=firstHit(ball, benchWorld.segment(0), benchWorld.segmentCount(), BenchArena::frameTime, &t);
+          advanceBall(ball, ball, hit>=0 ? benchWorld.segment(hit) : NULL, t, BenchArena::frameTime);
+        }
+        benchSink+=benchWorld.ball(0)->x;
+      });
+    }
+  }
+
+  // rollback: a late direction change of the other paddle, applied to everything up to now;
+  // in the rally the ball moves away from the other paddle, in the return it reaches the paddle
+  // line 40 frames into the history (deeper rollbacks resimulate the ball from there); every
+  // rollback starts from the unpatched history, otherwise all but the first would find nothing to change
+  const int32_t depths[] = { 1, 2, 5, 10, 25, 50, 99 }; // the oldest state has no predecessor to replay from
+  for (int i=0; i<7; i++) {
+    benchHistory(-45, 30);
+    uint32_t fid=curState()->frameID+1-depths[i], saved=benchSave(fid);
+    benchReset("rollback", depths[i], [&]() { benchRestore(fid, saved); },
+               [&]() { rollbackOther<BenchArena>(fid, 1); benchSink+=curState()->posBallX; });
+  }
+  for (int i=0; i<7; i++) {
+    benchHistory(45, 30);
+    uint32_t fid=curState()->frameID+1-depths[i], saved=benchSave(fid);
+    benchReset("rollback_return", depths[i], [&]() { benchRestore(fid, saved); },
+               [&]() { rollbackOther<BenchArena>(fid, 1); benchSink+=curState()->posBallX; });
+  }
+  // the full replay of every frame it replaces
+  for (int i=0; i<7; i++) {
+    benchHistory(45, 30);
+    uint32_t fid=curState()->frameID+1-depths[i], saved=benchSave(fid);
+    benchReset("rollback_full", depths[i], [&]() { benchRestore(fid, saved); }, [&]() {
+      uint32_t idx=getStateIdxWithID(fid), pIdx=prevState(idx);
+      while (idx!=NO_FRAME) {
+        getState(idx)->dirOther=1;
+        recalcFrame<BenchArena>(getState(idx), getState(pIdx));
+        pIdx=idx;
+        idx=nextState(idx);
+      }
+      benchSink+=curState()->posBallX;
+    });
+  }
+
+  benchHistory(45, 30);
+  bench("copyLatestState", 0, [&]() { benchSink+=copyLatestState()->frameID; });
+
+  // AI: a full prediction (the ball just changed direction) and the cached one
+  PongAI ai;
+  initAI(&ai);
+  benchState(&b, 45, 30);
+  bench("predict", 0, [&]() { ai.hasPred=false; benchSink+=predict<BenchArena>(&ai, BenchArena::frameTime, &b); });
+  bench("predict", 1, [&]() { ai.predElapsed=0; benchSink+=predict<BenchArena>(&ai, BenchArena::frameTime, &b); });
+  benchState(&b, 45, 30);
+  b.posBallX=BenchArena::width*900;
+  bench("calcAI", 0, [&]() { ai.hasPred=false; calcAI<BenchArena>(&ai, &a, &b); benchSink+=a.dirOther; });
+
+  // the sprites of a frame (two paddles, the ball and two score digits) into a framebuffer (param: rows the paddles and the ball are moved down by)
+  static uint8_t fb[BenchArena::width*BenchArena::height/8];
+  PongSprite paddle, ball, digit;
+  const uint16_t eight[5]={ 0x1FF, 0x111, 0x111, 0x111, 0x1FF }; // the columns of an 8
+  makeRectSprite(&paddle, BenchArena::paddleWidth, BenchArena::paddleHeight);
+  makeCircleSprite(&ball, BenchArena::ballRadius);
+  makeSprite(&digit, eight, 5);
+  for (int16_t shift=0; shift<8; shift+=5) {
+    bench("blitSprites", shift, [&]() {
+      blitSprite(fb, BenchArena::width, BenchArena::height, 0, 20+shift, &paddle);
+      blitSprite(fb, BenchArena::width, BenchArena::height, BenchArena::width-BenchArena::paddleWidth, 36+shift, &paddle);
+      blitSprite(fb, BenchArena::width, BenchArena::height, 62, 24+shift, &ball);
+      blitSprite(fb, BenchArena::width, BenchArena::height, 54, 0, &digit);
+      blitSprite(fb, BenchArena::width, BenchArena::height, 69, 0, &digit);
+      benchSink+=fb[64];
+    });
+  }
+
+  // random numbers: the match generator against Arduino's (param: the range)
+  bench("prngRandom", 160, [&]() { benchSink+=prngRandom(&rng, -80, 80); });
+  bench("random", 160, [&]() { benchSink+=random(-80, 80); });
+
+  // wire encoding of the game state (param: encoded bytes)
+  uint8_t wire[WIRE_GAMESTATE_SIZE];
+  benchState(&b, 45, 30);
+  bench("encodeGameState", WIRE_GAMESTATE_SIZE, [&]() { b.frameID++; encodeGameState(wire, &b); benchSink+=wire[1]; });
+  bench("decodeGameState", WIRE_GAMESTATE_SIZE, [&]() { PongGameStateView(wire).decode(&a); benchSink+=a.posBallX; });
+
+  // protocol: decode a stream of C/P/Q/F messages (reported per message)
+  uint8_t stream[BENCH_STREAM_MSGS*14];
+  uint32_t streamLen=benchStream(stream);
+  PongNetMsg msg;
+  uint32_t start=micros(), iterations=0, elapsed;
+  do {
+    for (uint32_t pos=0; pos<streamLen; iterations++) {
+      int32_t used=decodeNetMsg(stream+pos, streamLen-pos, &msg);
+      pos+=(used>0)?used:(used<0)?-used:streamLen;
+      benchSink+=msg.type;
+    }
+    elapsed=micros()-start;
+  } while (elapsed<BENCH_MIN_TIME);
+  Serial.printf(",\n    {\"name\": \"decodeNetMsg\", \"param\": %d, \"iterations\": %u, \"ns_per_op\": %u}",
+                BENCH_STREAM_MSGS, iterations, (uint32_t)((uint64_t)elapsed*1000/iterations));
+
+  Serial.printf("\n  ]\n}\n");
+}
+#endif
@@ -0,0 +1,15 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include "b2debug.h"
+
+/**********
+** Hot path benchmarks
+**   enabled with b2BENCHMARK (see b2debug.h), they run once at startup and print
+**   their results as JSON over serial; tools/benchcmp.py compares two such outputs
+***********/
+#ifdef b2BENCHMARK
+void runBenchmarks();
+#endif
+
+#endif //__BENCHMARK_H__
@@ -0,0 +1,79 @@
+#include "blit.h"
+
+void blitImage(uint8_t *fb, int16_t fbWidth, int16_t x, int16_t page, const PongImage *img) {
+  if (!img->rle) { // same layout as the framebuffer: one copy per page
+    for (uint8_t p=0; p<img->pages; p++)
+      memcpy(fb+(page+p)*fbWidth+x, img->data+p*img->width, img->width);
+    return;
+  }
+  // decompress straight into the framebuffer, wrapping to the next page at the end of the image width
+  uint8_t *dst=fb+page*fbWidth+x;
+  uint16_t col=0, i=0;
+  while (i<img->size) {
+    uint8_t ctrl=img->data[i++];
+    bool repeat=ctrl>=0x80;
+    uint8_t count=repeat?ctrl-0x80+2:ctrl+1;
+    while (count--) {
+      dst[col]=repeat?img->data[i]:img->data[i++];
+      if (++col==img->width) { col=0; dst+=fbWidth; }
+    }
+    if (repeat) i++;
+  }
+}
+
+void makeSprite(PongSprite *sprite, const uint16_t *cols, uint8_t width) {
+  sprite->width=width;
+  for (uint8_t shift=0; shift<8; shift++)
+    for (uint8_t c=0; c<width; c++) sprite->cols[shift][c]=cols[c]<<shift;
+}
+
+void makeRectSprite(PongSprite *sprite, uint8_t width, uint8_t height) {
+  uint16_t cols[SPRITE_MAX_WIDTH];
+  for (uint8_t c=0; c<width; c++) cols[c]=(1<<height)-1;
+  makeSprite(sprite, cols, width);
+}
+
+void makeCircleSprite(PongSprite *sprite, uint8_t radius) {
+  // the same midpoint walk as the library, every step fills four horizontal lines
+  uint16_t cols[SPRITE_MAX_WIDTH]={0};
+  int16_t x=0, y=radius, dp=1-radius;
+  auto line=[&](int16_t from, int16_t row, int16_t length) { // relative to the center
+    for (int16_t c=from; c<from+length; c++) cols[c+radius]|=1<<(row+radius);
+  };
+  do {
+    if (dp<0) dp=dp+2*(++x)+3;
+    else dp=dp+2*(++x)-2*(--y)+5;
+    line(-x, -y, 2*x);
+    line(-x, y, 2*x);
+    line(-y, -x, 2*y);
+    line(-y, x, 2*y);
+  } while (x<y);
+  line(-radius, 0, 2*radius);
+  makeSprite(sprite, cols, 2*radius);
+}
+
+void makeDigitSprite(PongSprite *sprite, uint8_t segments, uint8_t width, uint8_t height) {
+  uint16_t top=(1<<(height/2+1))-1, bottom=top<<(height/2); // the rows of the upper and lower vertical segments
+  uint16_t cols[SPRITE_MAX_WIDTH];
+  for (uint8_t c=0; c<width; c++)
+    cols[c]=((segments & 0x01) ? 1 : 0) | ((segments & 0x08) ? 1<<(height-1) : 0) | ((segments & 0x40) ? 1<<(height/2) : 0); // a, d, g
+  if (segments & 0x02) cols[width-1]|=top; // b: top right
+  if (segments & 0x04) cols[width-1]|=bottom; // c: bottom right
+  if (segments & 0x10) cols[0]|=bottom; // e: bottom left
+  if (segments & 0x20) cols[0]|=top; // f: top left
+  makeSprite(sprite, cols, width);
+}
+
+void blitSprite(uint8_t *fb, int16_t fbWidth, int16_t fbHeight, int16_t x, int16_t y, const PongSprite *sprite) {
+  int16_t page=y>>3, pages=fbHeight/8; // y>>3 rounds down, also above the screen
+  const uint16_t *cols=sprite->cols[y&7];
+  int16_t from=x<0 ? -x : 0, to=std::min<int16_t>(sprite->width, fbWidth-x);
+  if (page>=0 && page<pages) {
+    int16_t base=page*fbWidth+x;
+    for (int16_t c=from; c<to; c++) fb[base+c]|=cols[c];
+  }
+  if (page+1>=0 && page+1<pages) {
+    int16_t base=(page+1)*fbWidth+x;
+    for (int16_t c=from; c<to; c++) fb[base+c]|=cols[c]>>8;
+  }
+}
@@ -0,0 +1,28 @@
+#ifndef __BLIT_H__
+#define __BLIT_H__
+
+#include <Arduino.h>
+#include "img/image.h"
+
+// copies a page ordered image into an SSD1306 framebuffer (fbWidth bytes per page) at column x and page (y/8)
+void blitImage(uint8_t *fb, int16_t fbWidth, int16_t x, int16_t page, const PongImage *img);
+
+// a small sprite with its columns pre-shifted for every row it can start at within a page,
+// so drawing it is one OR per column and page (bit n of a column is row n)
+#define SPRITE_MAX_WIDTH 8
+#define SPRITE_MAX_HEIGHT 9 // shifted down by 7 rows a column still fits in two pages
+struct PongSprite {
+  uint8_t width;
+  uint16_t cols[8][SPRITE_MAX_WIDTH]; // by y%8: the low byte goes to the page of y, the high byte to the one below
+};
+typedef struct PongSprite PongSprite;
+
+void makeSprite(PongSprite *sprite, const uint16_t *cols, uint8_t width);
+void makeRectSprite(PongSprite *sprite, uint8_t width, uint8_t height);
+void makeCircleSprite(PongSprite *sprite, uint8_t radius); // the pixels fillCircle of the display library sets, from (x-radius;y-radius)
+// a seven segment digit, segments bits a (top) to g (middle) clockwise like the usual tables, the vertical ones overlap by a row in the middle
+void makeDigitSprite(PongSprite *sprite, uint8_t segments, uint8_t width, uint8_t height);
+// ORs a sprite into an SSD1306 framebuffer (fbWidth x fbHeight pixels) with its top left corner at (x;y), clipped to the screen
+void blitSprite(uint8_t *fb, int16_t fbWidth, int16_t fbHeight, int16_t x, int16_t y, const PongSprite *sprite);
+
+#endif //__BLIT_H__
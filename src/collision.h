@@ -0,0 +1,199 @@
+#ifndef __COLLISION_H__
+#define __COLLISION_H__
+
+#include <Arduino.h>
+#include <algorithm>
+#include "helper.h"
+
+/**********
+** Collision layer
+**   balls against static or moving segments (walls, paddles, obstacles); a segment is hit
+**   from one side only, and when a ball could hit several in a frame the one listed first
+**   wins, whatever order they are found in, so every peer replays a frame the same way
+***********/
+struct PongBall {
+  int32_t x;
+  int32_t y;
+  int32_t speedX;
+  int32_t speedY;
+};
+typedef struct PongBall PongBall;
+
+struct PongSegment {
+  bool vertical;
+  int32_t pos; // x of a vertical, y of a horizontal segment
+  int32_t from; // extent along the other axis
+  int32_t to;
+  int8_t facing; // sign of the ball speed across the segment that hits it
+  int8_t dir; // movement of the segment along itself (paddles): speeds up or slows down the ball
+};
+typedef struct PongSegment PongSegment;
+
+// narrowphase: true if the ball reaches the segment within deltaTime, when is set to the time it does
+inline bool hitSegment(const PongBall *ball, const PongSegment *seg, int32_t deltaTime, int32_t *when) {
+  if (seg->vertical) {
+    if (seg->facing<0 ? ball->speedX>=0 : ball->speedX<=0) return false; // moving away or along
+    return checkVCollision(seg->pos, seg->from, seg->to, ball->x, ball->y, ball->speedX, ball->speedY, deltaTime, when);
+  }
+  if (seg->facing<0 ? ball->speedY>=0 : ball->speedY<=0) return false;
+  return checkHCollision(seg->from, seg->pos, seg->to, ball->x, ball->y, ball->speedX, ball->speedY, deltaTime, when);
+}
+
+// the first listed segment the ball hits in this frame, -1 if none
+inline int32_t firstHit(const PongBall *ball, const PongSegment *segs, uint32_t count, int32_t deltaTime, int32_t *when) {
+  for (uint32_t i=0; i<count; i++)
+    if (hitSegment(ball, &segs[i], deltaTime, when)) return i;
+  *when = deltaTime;
+  return -1;
+}
+
+// a moving paddle slows down the ball moving against it and speeds up the one moving with it
+inline int32_t paddleSpin(int32_t speed, int8_t dir) {
+  if (dir>0) return speed * (speed < 0 ? 0.5 : 1.5);
+  if (dir<0) return speed * (speed > 0 ? 0.5 : 1.5);
+  return speed;
+}
+
+// moves the ball through the frame bouncing off seg at when (seg NULL: no collision), next may be ball
+inline void advanceBall(const PongBall *ball, PongBall *next, const PongSegment *seg, int32_t when, int32_t deltaTime) {
+  int32_t speedX = ball->speedX, speedY = ball->speedY;
+  if (!seg) when = deltaTime;
+  else if (seg->vertical) { speedX = -speedX; speedY = paddleSpin(speedY, seg->dir); }
+  else { speedY = -speedY; speedX = paddleSpin(speedX, seg->dir); }
+  // move up to the collision, then the rest of the frame with the new speed
+  next->x = ball->x + ball->speedX * when / 1000;
+  next->y = ball->y + ball->speedY * when / 1000;
+  next->speedX = speedX;
+  next->speedY = speedY;
+  next->x += speedX * (deltaTime-when) / 1000;
+  next->y += speedY * (deltaTime-when) / 1000;
+}
+
+/**********
+** Many balls
+**   a sweep-and-prune broadphase along x: the swept boxes of the balls and the boxes of
+**   the segments are kept sorted by their left edge (insertion sort, nearly sorted from
+**   the previous frame) and only the ball-segment pairs overlapping in both axes reach
+**   the narrowphase; a world with few pairs per box skips the broadphase and tests them
+**   all, which is cheaper there; static storage, segments may be moved between frames
+***********/
+template<uint32_t MaxBalls, uint32_t MaxSegments>
+class CollisionWorld {
+  public:
+    CollisionWorld() { clear(); }
+
+    void clear() { balls = 0; segments = 0; boxes = 0; }
+    int32_t addBall(const PongBall &ball) {
+      if (balls==MaxBalls) return -1;
+      ballList[balls] = ball;
+      order[boxes++] = balls;
+      return balls++;
+    }
+    int32_t addSegment(const PongSegment &seg) { // the earlier added wins when a ball hits more
+      if (segments==MaxSegments) return -1;
+      segList[segments] = seg;
+      order[boxes++] = MaxBalls+segments;
+      return segments++;
+    }
+    PongBall *ball(uint32_t idx) { return &ballList[idx]; }
+    PongSegment *segment(uint32_t idx) { return &segList[idx]; }
+    uint32_t ballCount() const { return balls; }
+    uint32_t segmentCount() const { return segments; }
+
+    void step(int32_t deltaTime) { // moves every ball through one frame
+      if (balls*segments <= BROADPHASE_BOX_COST*boxes) { // so few pairs that testing them all is cheaper
+        for (uint32_t i=0; i<balls; i++) {
+          int32_t when, first = firstHit(&ballList[i], segList, segments, deltaTime, &when);
+          advanceBall(&ballList[i], &ballList[i], first>=0 ? &segList[first] : NULL, when, deltaTime);
+        }
+        return;
+      }
+      for (uint32_t i=0; i<balls; i++) hit[i] = -1;
+      bounds(deltaTime);
+      sort();
+      sweep(deltaTime);
+      for (uint32_t i=0; i<balls; i++)
+        advanceBall(&ballList[i], &ballList[i], hit[i]>=0 ? &segList[hit[i]] : NULL, hitTime[i], deltaTime);
+    }
+
+  private:
+    static const uint32_t BROADPHASE_BOX_COST = 8; // narrowphase tests the broadphase costs per box (bounds, sort and sweep)
+    static_assert(MaxBalls+MaxSegments <= 65535, "box indices are 16 bit");
+
+    void bounds(int32_t deltaTime) {
+      for (uint32_t i=0; i<balls; i++) {
+        const PongBall *b = &ballList[i];
+        // the narrowphase rounds the time down, so a ball may reach a bit further than its speed says
+        int32_t dx = b->speedX*deltaTime/1000, mx = abs(b->speedX)/1000+1;
+        int32_t dy = b->speedY*deltaTime/1000, my = abs(b->speedY)/1000+1;
+        minX[i] = std::min(b->x, b->x+dx)-mx; maxX[i] = std::max(b->x, b->x+dx)+mx;
+        minY[i] = std::min(b->y, b->y+dy)-my; maxY[i] = std::max(b->y, b->y+dy)+my;
+      }
+      for (uint32_t i=0; i<segments; i++) {
+        const PongSegment *s = &segList[i];
+        uint32_t box = MaxBalls+i;
+        if (s->vertical) { minX[box] = s->pos; maxX[box] = s->pos; minY[box] = s->from; maxY[box] = s->to; }
+        else { minX[box] = s->from; maxX[box] = s->to; minY[box] = s->pos; maxY[box] = s->pos; }
+      }
+    }
+    void sort() {
+      for (uint32_t i=1; i<boxes; i++) {
+        uint16_t box = order[i];
+        uint32_t j = i;
+        for (; j>0 && minX[order[j-1]]>minX[box]; j--) order[j] = order[j-1];
+        order[j] = box;
+      }
+    }
+    void sweep(int32_t deltaTime) { // pairs the boxes overlapping along x, in the order of their left edges
+      uint32_t activeBalls = 0, activeSegs = 0, ballsLeft = balls;
+      int32_t ballsEnd = INT32_MAX, segsEnd = INT32_MAX; // the leftmost right edge in each list
+      for (uint32_t i=0; i<boxes; i++) {
+        uint16_t box = order[i];
+        int32_t x = minX[box];
+        // a box is only dropped once one starts right of it, so most boxes leave nothing to prune
+        if (x>ballsEnd) activeBalls = prune(activeBallList, activeBalls, x, &ballsEnd);
+        if (x>segsEnd) activeSegs = prune(activeSegList, activeSegs, x, &segsEnd);
+        if (box<MaxBalls) {
+          for (uint32_t j=0; j<activeSegs; j++) pair(box, activeSegList[j]-MaxBalls, deltaTime);
+          activeBallList[activeBalls++] = box;
+          ballsEnd = std::min(ballsEnd, maxX[box]);
+          ballsLeft--;
+        } else {
+          if (!ballsLeft && !activeBalls) return; // no ball is left to meet the rest
+          for (uint32_t j=0; j<activeBalls; j++) pair(activeBallList[j], box-MaxBalls, deltaTime);
+          activeSegList[activeSegs++] = box;
+          segsEnd = std::min(segsEnd, maxX[box]);
+        }
+      }
+    }
+    uint32_t prune(uint16_t *list, uint32_t count, int32_t x, int32_t *end) { // drops the boxes ending left of x
+      uint32_t kept = 0;
+      *end = INT32_MAX;
+      for (uint32_t i=0; i<count; i++) {
+        if (maxX[list[i]]<x) continue;
+        *end = std::min(*end, maxX[list[i]]);
+        list[kept++] = list[i];
+      }
+      return kept;
+    }
+    void pair(uint32_t b, uint32_t s, int32_t deltaTime) {
+      if (hit[b]>=0 && hit[b]<(int32_t)s) return; // an earlier listed segment is hit already
+      if (maxY[b]<minY[MaxBalls+s] || minY[b]>maxY[MaxBalls+s]) return;
+      int32_t when;
+      if (hitSegment(&ballList[b], &segList[s], deltaTime, &when)) { hit[b] = s; hitTime[b] = when; }
+    }
+
+    PongBall ballList[MaxBalls];
+    PongSegment segList[MaxSegments];
+    uint32_t balls, segments, boxes;
+    // boxes: the balls are 0..MaxBalls-1, the segments MaxBalls..
+    int32_t minX[MaxBalls+MaxSegments], maxX[MaxBalls+MaxSegments];
+    int32_t minY[MaxBalls+MaxSegments], maxY[MaxBalls+MaxSegments];
+    uint16_t order[MaxBalls+MaxSegments];
+    uint16_t activeBallList[MaxBalls];
+    uint16_t activeSegList[MaxSegments];
+    int32_t hit[MaxBalls];
+    int32_t hitTime[MaxBalls];
+};
+
+#endif //__COLLISION_H__
@@ -0,0 +1,39 @@
+#ifndef __FIXEDQUEUE_H__
+#define __FIXEDQUEUE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**********
+** Fixed capacity FIFO for the game loop
+**   static storage, never allocates; front() returns NULL when empty
+***********/
+template<class T, uint32_t N>
+class FixedQueue {
+  public:
+    FixedQueue() : head(0), count(0) {}
+
+    bool push(const T &item) {
+      if (count==N) return false; // full, caller decides what to drop
+      items[(head+count) % N] = item;
+      count++;
+      return true;
+    }
+    T* front() { return count ? &items[head] : NULL; }
+    void pop() {
+      if (!count) return;
+      head = (head+1) % N;
+      count--;
+    }
+    void clear() { head = 0; count = 0; }
+    bool empty() const { return count==0; }
+    bool full() const { return count==N; }
+    uint32_t size() const { return count; }
+
+  private:
+    T items[N];
+    uint32_t head;
+    uint32_t count;
+};
+
+#endif //__FIXEDQUEUE_H__
@@ -0,0 +1,71 @@
+#ifndef __FRAMEPACER_H__
+#define __FRAMEPACER_H__
+
+#include <stdint.h>
+
+/**********
+** Frame pacing
+**   frames start on a fixed timeline; the idle part of a frame is spent in the clock's
+**   blocking sleep (the CPU halts) and only the last SpinTime microseconds are busy
+**   waited, so a frame starts at most a few microseconds after its tick as long as
+**   the sleep wakes up within SpinTime (later wakes are counted as lateWakes)
+**
+**   Clock is anything with uint32_t now() in microseconds and sleep(us) returning no
+**   later than us after the call, so the logic can run against a mock clock
+***********/
+struct PacerStats {
+  uint32_t frames;
+  uint32_t overruns; // frames that ended after the next tick, the timeline restarts from there
+  uint64_t idleUs; // time between the end of a frame's work and the start of the next one
+  uint64_t sleptUs; // ... of which spent in the clock's sleep
+  uint32_t jitterMaxUs; // frame start after its tick
+  uint64_t jitterUs; // sum of them
+  uint32_t lateWakes; // sleeps that woke after the frame's tick
+};
+typedef struct PacerStats PacerStats;
+
+template<class Clock, uint32_t FrameTime, uint32_t SpinTime = 200>
+class FramePacer {
+  public:
+    FramePacer(Clock &clock) : clock(clock), next(0) { resetStats(); }
+
+    void start() { next = clock.now(); }
+
+    // call when the frame's work is done, returns when the next frame is due
+    void wait() {
+      uint32_t end = clock.now();
+      stats.frames++;
+      next += FrameTime;
+      int32_t remaining = (int32_t)(next - end);
+      if (remaining <= 0) { // over our frame time -> no wait, and no catching up either
+        stats.overruns++;
+        next = end;
+        return;
+      }
+      if (remaining > (int32_t)SpinTime) {
+        clock.sleep(remaining - SpinTime);
+        uint32_t woke = clock.now();
+        stats.sleptUs += woke - end;
+        if ((int32_t)(woke - next) > 0) stats.lateWakes++;
+      }
+      uint32_t now;
+      while ((int32_t)(next - (now = clock.now())) > 0); // the rest precisely
+      uint32_t jitter = now - next;
+      stats.jitterUs += jitter;
+      if (jitter > stats.jitterMaxUs) stats.jitterMaxUs = jitter;
+      stats.idleUs += now - end;
+    }
+
+    const PacerStats *getStats() const { return &stats; }
+    void resetStats() {
+      stats.frames = 0; stats.overruns = 0; stats.idleUs = 0; stats.sleptUs = 0;
+      stats.jitterMaxUs = 0; stats.jitterUs = 0; stats.lateWakes = 0;
+    }
+
+  private:
+    Clock &clock;
+    uint32_t next; // tick of the next frame
+    PacerStats stats;
+};
+
+#endif //__FRAMEPACER_H__
@@ -5,7 +5,6 @@
 ** Circular buffer for game states
 **   
 ***********/
-#define GAMESTATE_BUFFER_SIZE 100 // that is ~3 seconds
 PongGameState gameStates[GAMESTATE_BUFFER_SIZE]; // a circular buffer for past game states with static initialization (array of the data itself not pointers)
 uint32_t oldestItem;
 uint32_t latestItem;
@@ -17,13 +16,14 @@ void initBuffer() {
   empty=true;
 }
 
-bool bufferEmpty() { return oldestItem==latestItem && empty; }
-bool bufferFull() { return oldestItem==latestItem && !empty; }
+bool bufferEmpty() { return empty; }
+bool bufferFull() { return !empty && (latestItem+1) % GAMESTATE_BUFFER_SIZE==oldestItem; }
 
 uint32_t bufferAdd() { // add new item and drop oldest if needed (don't bother with filling the item with data, only frameID)
   uint32_t fid = empty?0:gameStates[latestItem].frameID+1;
   latestItem=(latestItem+1) % GAMESTATE_BUFFER_SIZE; // advance the "head" pointer
-  if (latestItem==oldestItem) oldestItem=(oldestItem+1) % GAMESTATE_BUFFER_SIZE; // if buffer full then advance the "tail" pointer as well
+  if (empty) oldestItem=latestItem; // the first item is the oldest one as well (the slot before it holds a stale state)
+  else if (latestItem==oldestItem) oldestItem=(oldestItem+1) % GAMESTATE_BUFFER_SIZE; // if buffer full then advance the "tail" pointer as well
   empty=false; // if we added item, it will always become non-empty
   gameStates[latestItem].frameID=fid;
   return latestItem;
@@ -34,26 +34,26 @@ PongGameState* oldestState() { return &gameStates[oldestItem]; }
 PongGameState* getState(uint32_t idx) { return (idx>GAMESTATE_BUFFER_SIZE-1)?NULL:&gameStates[idx]; }
 
 uint32_t nextState(uint32_t idx) {
-  if (idx==latestItem || idx>GAMESTATE_BUFFER_SIZE-1) return -1; // only cases when it can't go one further
+  if (idx==latestItem || idx>GAMESTATE_BUFFER_SIZE-1) return NO_FRAME; // only cases when it can't go one further
   return (idx+1) % GAMESTATE_BUFFER_SIZE;
 }
 
 PongGameState* nextState(PongGameState* state) {
   uint32_t idx=getStateIdx(state);
   idx=nextState(idx);
-  if (idx==-1) return NULL;
+  if (idx==NO_FRAME) return NULL;
   return &gameStates[idx];
 }
 
 uint32_t prevState(uint32_t idx) {
-  if (idx==oldestItem || idx>GAMESTATE_BUFFER_SIZE-1) return -1; // only cases when it can't go one further
+  if (idx==oldestItem || idx>GAMESTATE_BUFFER_SIZE-1) return NO_FRAME; // only cases when it can't go one further
   return (idx>0)?(idx-1):(GAMESTATE_BUFFER_SIZE-1);
 }
 
 PongGameState* prevState(PongGameState* state) {
   uint32_t idx=getStateIdx(state);
   idx=prevState(idx);
-  if (idx==-1) return NULL;
+  if (idx==NO_FRAME) return NULL;
   return &gameStates[idx];
 }
 
@@ -62,28 +62,34 @@ uint32_t getStateIdx(PongGameState* state) {
   do {
     if (&gameStates[idx]==state) return idx;
     idx=nextState(idx);
-    if (idx==-1) return -1;
+    if (idx==NO_FRAME) return NO_FRAME;
   } while (idx<GAMESTATE_BUFFER_SIZE); // this will always be true because of modulo in nextState
-  return -1;
+  return NO_FRAME;
 }
 
 uint32_t getStateIdxWithID(uint32_t frameID) {
+  // frame ids follow each other in the buffer, so the slot can be computed from the oldest one
+  uint32_t offset=frameID-gameStates[oldestItem].frameID;
+  if (!empty && offset<GAMESTATE_BUFFER_SIZE) {
+    uint32_t idx=(oldestItem+offset) % GAMESTATE_BUFFER_SIZE;
+    if (gameStates[idx].frameID==frameID && (latestItem-oldestItem+GAMESTATE_BUFFER_SIZE) % GAMESTATE_BUFFER_SIZE>=offset) return idx;
+  }
   uint32_t idx=oldestItem;
   dbgf(b2DEBUG_GAMESTATE, "[[Starting from %d. ", idx);
   do {
     if (gameStates[idx].frameID==frameID) { dbgf(b2DEBUG_GAMESTATE, "RET(%d)]]", idx); return idx; }
     idx=nextState(idx);
     dbgf(b2DEBUG_GAMESTATE, "%d->", idx);
-    if (idx==-1) { dbgf(b2DEBUG_GAMESTATE, "RET(%d)]]", -1); return -1; }
+    if (idx==NO_FRAME) { dbgf(b2DEBUG_GAMESTATE, "RET(%d)]]", -1); return NO_FRAME; }
   } while (idx<GAMESTATE_BUFFER_SIZE); // this will always be true because of modulo in nextState
   dbgf(b2DEBUG_GAMESTATE, "RET(%d)]]", -1);
-  return -1;
+  return NO_FRAME;
 }
 
 PongGameState* getStateWithID(uint32_t frameID) {
   uint32_t idx=getStateIdxWithID(frameID);
   dbgf(b2DEBUG_GAMESTATE, "Returning state for idx %d\n", idx);
-  if (idx==-1) return NULL;
+  if (idx==NO_FRAME) return NULL;
   return &gameStates[idx];
 }
 
@@ -4,25 +4,31 @@
 
 #include <Arduino.h>
 
-// game state
+#define GAMESTATE_BUFFER_SIZE 100 // that is ~3 seconds
+#define NO_FRAME UINT32_MAX // the index (or frame id) of a state that is not in the buffer
+
+// game state (the 32 bit fields first and the bytes last, so there is no padding; see wire.h for the network format)
 struct PongGameState {
   uint32_t frameID;
-  uint8_t scoreSelf;
-  uint8_t scoreOther;
   int32_t posSelf;
-  int8_t dirSelf;
   int32_t posOther;
-  int8_t dirOther;
   int32_t posBallX;
   int32_t posBallY;
   int32_t speedBallX;
   int32_t speedBallY;
+  uint8_t scoreSelf;
+  uint8_t scoreOther;
+  int8_t dirSelf;
+  int8_t dirOther;
 };
 typedef struct PongGameState PongGameState;
+static_assert(sizeof(PongGameState)==32, "PongGameState should not have padding");
 
 struct PongDirChangeMsg {
   uint32_t frameID;
   int8_t direction;
+  uint32_t captureTime; // micros() of the sender when it read the touch
+  uint32_t sendTime; // ... and when it wrote the message
 };
 typedef struct PongDirChangeMsg PongDirChangeMsg;
 
@@ -0,0 +1,16 @@
+#ifndef __IMAGE_H__
+#define __IMAGE_H__
+
+#include <Arduino.h>
+
+// an image in SSD1306 page order (see tools/imgconv.py)
+struct PongImage {
+  uint16_t width;
+  uint8_t pages; // height in 8 pixel pages
+  bool rle; // data is RLE compressed
+  uint16_t size; // bytes of data
+  const uint8_t *data;
+};
+typedef struct PongImage PongImage;
+
+#endif //__IMAGE_H__
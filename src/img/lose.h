@@ -1,46 +0,0 @@
-#define lose_width 64
-#define lose_height 64
-static unsigned char lose_bits[] = {
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0xf0, 0x1f, 0xe0, 0x03, 0x7c, 0xe0, 0xc3, 0x7f,
-   0xf8, 0x1f, 0xf0, 0x03, 0x7c, 0xf0, 0xc3, 0xff, 0xfc, 0x1d, 0xf0, 0x07,
-   0xfc, 0xf0, 0xc3, 0x7f, 0x3e, 0x00, 0x70, 0x07, 0xfc, 0xf0, 0xc3, 0x01,
-   0x1e, 0x00, 0x70, 0x07, 0xfe, 0xf8, 0xc3, 0x01, 0x0f, 0x00, 0x78, 0x0f,
-   0xfe, 0xb8, 0xc3, 0x01, 0x0f, 0x00, 0x38, 0x0f, 0xde, 0xb9, 0xc3, 0x7f,
-   0x0f, 0x3f, 0x38, 0x0e, 0xde, 0x99, 0xc3, 0x7f, 0x0f, 0x3f, 0x3c, 0x1e,
-   0xce, 0x9d, 0xc3, 0x7f, 0x0f, 0x3c, 0xfc, 0x1f, 0xce, 0x9d, 0xc3, 0x01,
-   0x1f, 0x38, 0xfc, 0x1f, 0x8e, 0x8f, 0xc3, 0x01, 0x1e, 0x38, 0xfe, 0x3f,
-   0x8e, 0x8f, 0xc7, 0x01, 0x7e, 0x38, 0x1e, 0x3c, 0x8e, 0x8f, 0xc7, 0x01,
-   0xfc, 0x3f, 0x1e, 0x3c, 0x8e, 0x8f, 0xc7, 0xff, 0xf8, 0x3f, 0x0e, 0x38,
-   0x0e, 0x87, 0xc7, 0xff, 0xe0, 0x1f, 0x0e, 0x18, 0x0c, 0x07, 0xc3, 0x7f,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x3f, 0x60, 0x80,
-   0xe1, 0x3f, 0xfc, 0x03, 0xc0, 0xff, 0xf0, 0xc0, 0xf3, 0x3f, 0xfe, 0x0f,
-   0xe0, 0xff, 0xf1, 0xc0, 0xf3, 0x3f, 0xfe, 0x0f, 0xf0, 0xe1, 0xe3, 0xc1,
-   0xf1, 0x00, 0x1e, 0x1e, 0xf0, 0xc0, 0xe3, 0xe1, 0xf1, 0x00, 0x1e, 0x1e,
-   0x78, 0xc0, 0xe3, 0xe1, 0xf1, 0x00, 0x1e, 0x1e, 0x78, 0x80, 0xc7, 0xe1,
-   0xf0, 0x1f, 0x1e, 0x0e, 0x78, 0x80, 0xc7, 0xf3, 0xf0, 0x3f, 0xfe, 0x0f,
-   0x78, 0x80, 0xc7, 0xf3, 0xf0, 0x3f, 0xfe, 0x03, 0x78, 0x80, 0x87, 0x73,
-   0xf0, 0x00, 0xfe, 0x07, 0x78, 0xc0, 0x83, 0x73, 0xf0, 0x00, 0x1e, 0x0f,
-   0xf8, 0xc0, 0x83, 0x7f, 0xf0, 0x00, 0x1e, 0x0f, 0xf0, 0xe0, 0x03, 0x3f,
-   0xf0, 0x00, 0x1e, 0x0e, 0xf0, 0xf3, 0x01, 0x3f, 0xf0, 0x3f, 0x1e, 0x1e,
-   0xe0, 0xff, 0x00, 0x3f, 0xf0, 0x7f, 0x1e, 0x1e, 0x80, 0x7f, 0x00, 0x1e,
-   0xe0, 0x3f, 0x1c, 0x1c, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
@@ -0,0 +1,33 @@
+// generated by tools/imgconv.py from resources/lose.png, do not edit
+#include "image.h"
+
+const uint8_t lose_pages_data[] PROGMEM = {
+   0xbf, 0x00, 0x04, 0xc0, 0xe0, 0xf0, 0xf8, 0x78, 0x80, 0x38, 0x02, 0x3c,
+   0x1c, 0x3c, 0x80, 0x38, 0x85, 0x00, 0x00, 0xf0, 0x80, 0xf8, 0x00, 0x38,
+   0x80, 0xf8, 0x00, 0xe0, 0x84, 0x00, 0x00, 0x80, 0x83, 0xf8, 0x00, 0xe0,
+   0x81, 0x00, 0x01, 0x80, 0xf0, 0x83, 0xf8, 0x82, 0x00, 0x81, 0xf8, 0x84,
+   0x38, 0x01, 0x10, 0x3f, 0x81, 0xff, 0x00, 0xe0, 0x80, 0x80, 0x00, 0x00,
+   0x80, 0x0c, 0x00, 0x1c, 0x81, 0xfc, 0x81, 0x00, 0x01, 0xc0, 0xf8, 0x80,
+   0xff, 0x04, 0x7f, 0x71, 0x70, 0x73, 0x7f, 0x80, 0xff, 0x01, 0xf8, 0xc0,
+   0x81, 0x00, 0x81, 0xff, 0x0a, 0x07, 0x01, 0x1f, 0xff, 0xfe, 0xe0, 0xf8,
+   0xff, 0x1f, 0x03, 0x00, 0x81, 0xff, 0x00, 0xc0, 0x81, 0x00, 0x81, 0xff,
+   0x84, 0x0e, 0x81, 0x00, 0x00, 0x01, 0x80, 0x03, 0x86, 0x07, 0x00, 0x03,
+   0x81, 0x00, 0x81, 0x07, 0x00, 0x01, 0x83, 0x00, 0x00, 0x01, 0x80, 0x07,
+   0x00, 0x03, 0x81, 0x00, 0x00, 0x03, 0x80, 0x07, 0x81, 0x00, 0x00, 0x01,
+   0x81, 0x07, 0x00, 0x01, 0x81, 0x00, 0x00, 0x03, 0x80, 0x07, 0x00, 0x03,
+   0x81, 0x00, 0x87, 0x07, 0x00, 0x03, 0x83, 0x00, 0x01, 0x80, 0xc0, 0x85,
+   0xe0, 0x80, 0xc0, 0x00, 0x80, 0x81, 0x00, 0x00, 0xc0, 0x80, 0xe0, 0x00,
+   0xc0, 0x84, 0x00, 0x00, 0xc0, 0x80, 0xe0, 0x00, 0xc0, 0x80, 0x00, 0x00,
+   0xc0, 0x87, 0xe0, 0x81, 0x00, 0x00, 0xc0, 0x86, 0xe0, 0x80, 0xc0, 0x85,
+   0x00, 0x00, 0xfc, 0x81, 0xff, 0x01, 0x03, 0x01, 0x82, 0x00, 0x01, 0x01,
+   0x87, 0x81, 0xff, 0x00, 0x78, 0x80, 0x00, 0x01, 0x07, 0x3f, 0x80, 0xff,
+   0x00, 0xf0, 0x80, 0x00, 0x04, 0xf0, 0xfe, 0xff, 0x3f, 0x07, 0x81, 0x00,
+   0x82, 0xff, 0x83, 0x38, 0x00, 0x30, 0x81, 0x00, 0x82, 0xff, 0x81, 0x70,
+   0x04, 0xf0, 0xff, 0xdf, 0x9f, 0x07, 0x84, 0x00, 0x01, 0x01, 0x07, 0x80,
+   0x0f, 0x02, 0x1f, 0x1c, 0x3c, 0x80, 0x38, 0x05, 0x1c, 0x1e, 0x1f, 0x0f,
+   0x07, 0x03, 0x83, 0x00, 0x01, 0x01, 0x0f, 0x82, 0x1f, 0x01, 0x0f, 0x01,
+   0x83, 0x00, 0x00, 0x0f, 0x81, 0x1f, 0x84, 0x1c, 0x00, 0x08, 0x80, 0x00,
+   0x00, 0x0f, 0x81, 0x1f, 0x81, 0x00, 0x01, 0x01, 0x0f, 0x80, 0x1f, 0x00,
+   0x1c, 0xc1, 0x00,
+};
+const PongImage lose_pages = { 64, 8, true, sizeof(lose_pages_data), lose_pages_data };
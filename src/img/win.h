@@ -1,46 +0,0 @@
-#define win_width 64
-#define win_height 64
-const unsigned char win_bits[] = {
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0xfc, 0xff, 0xff, 0xff, 0xff, 0x3f, 0x00, 0x00, 0xfe, 0xff, 0xff,
-   0xff, 0xff, 0x7f, 0x00, 0x00, 0xfc, 0xff, 0xff, 0xff, 0xff, 0x3f, 0x00,
-   0x00, 0xfe, 0xff, 0xff, 0xff, 0xff, 0x7f, 0x00, 0x00, 0xff, 0xff, 0xff,
-   0xff, 0xff, 0xff, 0x00, 0xc0, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x03,
-   0xe0, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x07, 0xf8, 0xff, 0xff, 0x7f,
-   0xf0, 0xff, 0xff, 0x1f, 0xf8, 0xff, 0xff, 0x1f, 0xf0, 0xff, 0xff, 0x1f,
-   0xfc, 0xf8, 0xff, 0x07, 0xf0, 0xff, 0x1f, 0x3f, 0x7e, 0xf8, 0xff, 0x03,
-   0xf0, 0xff, 0x1f, 0x7e, 0x3e, 0xf8, 0xff, 0xc3, 0xf0, 0xff, 0x1f, 0x7c,
-   0x1f, 0xf8, 0xff, 0xf3, 0xf0, 0xff, 0x1f, 0xf8, 0x1f, 0xf0, 0xff, 0xff,
-   0xf0, 0xff, 0x0f, 0xf8, 0x1f, 0xf0, 0xff, 0xff, 0xf0, 0xff, 0x0f, 0xf8,
-   0x0f, 0xf0, 0xff, 0xff, 0xf0, 0xff, 0x0f, 0xf0, 0x0f, 0xe0, 0xff, 0xff,
-   0xf0, 0xff, 0x07, 0xf0, 0x1f, 0xe0, 0xff, 0xff, 0xf0, 0xff, 0x07, 0xf8,
-   0x1e, 0xe0, 0xff, 0xff, 0xf0, 0xff, 0x07, 0x78, 0x1e, 0xc0, 0xff, 0xff,
-   0xf0, 0xff, 0x03, 0x78, 0x3e, 0xc0, 0xff, 0xff, 0xf0, 0xff, 0x03, 0x7c,
-   0x7c, 0x80, 0xff, 0xff, 0xf0, 0xff, 0x01, 0x3e, 0xfc, 0x81, 0xff, 0xff,
-   0xf0, 0xff, 0x81, 0x3f, 0xf8, 0x87, 0xff, 0xff, 0xf0, 0xff, 0xe1, 0x1f,
-   0xf0, 0x1f, 0xff, 0xff, 0xf0, 0xff, 0xf8, 0x0f, 0xe0, 0x7f, 0xff, 0xff,
-   0xf0, 0xff, 0xfe, 0x07, 0x80, 0xff, 0xff, 0xff, 0xf0, 0xff, 0xff, 0x01,
-   0x00, 0xfe, 0xff, 0xff, 0xf0, 0xff, 0x7f, 0x00, 0x00, 0xf8, 0xff, 0xff,
-   0xf0, 0xff, 0x1f, 0x00, 0x00, 0xe0, 0xff, 0xff, 0xf0, 0xff, 0x07, 0x00,
-   0x00, 0x80, 0xff, 0xff, 0xf0, 0xff, 0x01, 0x00, 0x00, 0xc0, 0xff, 0xff,
-   0xff, 0xff, 0x03, 0x00, 0x00, 0xe0, 0xff, 0xff, 0xff, 0xff, 0x07, 0x00,
-   0x00, 0xe0, 0xef, 0xff, 0xff, 0xf7, 0x07, 0x00, 0x00, 0xe0, 0xcf, 0xff,
-   0xff, 0xf3, 0x07, 0x00, 0x00, 0xc0, 0x87, 0xff, 0xff, 0xe1, 0x03, 0x00,
-   0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfe,
-   0x7f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf8, 0x1f, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0xf0, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0,
-   0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x0f, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0xf0, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0,
-   0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x0f, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0xf0, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0,
-   0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xe0, 0x07, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x80, 0xff, 0xff, 0x01, 0x00, 0x00, 0x00, 0x00, 0xe0, 0xff,
-   0xff, 0x07, 0x00, 0x00, 0x00, 0x00, 0xe0, 0xff, 0xff, 0x07, 0x00, 0x00,
-   0x00, 0x00, 0xe0, 0xff, 0xff, 0x07, 0x00, 0x00, 0x00, 0x00, 0xe0, 0xff,
-   0xff, 0x07, 0x00, 0x00, 0x00, 0x00, 0xe0, 0xff, 0xff, 0x07, 0x00, 0x00,
-   0x00, 0x00, 0xe0, 0xff, 0xff, 0x07, 0x00, 0x00, 0x00, 0x00, 0xe0, 0xff,
-   0xff, 0x07, 0x00, 0x00, 0x00, 0x00, 0xe0, 0xff, 0xff, 0x07, 0x00, 0x00,
-   0x00, 0x00, 0xc0, 0xff, 0xff, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
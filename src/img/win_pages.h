@@ -0,0 +1,22 @@
+// generated by tools/imgconv.py from resources/cup.png, do not edit
+#include "image.h"
+
+const uint8_t win_pages_data[] PROGMEM = {
+   0x86, 0x00, 0x01, 0x80, 0xd0, 0xaa, 0xf8, 0x01, 0xd0, 0x80, 0x86, 0x00,
+   0x02, 0x80, 0xe0, 0xf0, 0x80, 0xfc, 0x02, 0x7e, 0x3f, 0x1f, 0x81, 0x0f,
+   0x8d, 0xff, 0x05, 0x1f, 0x0f, 0x8f, 0x87, 0xc7, 0xc3, 0x82, 0x03, 0x8f,
+   0xff, 0x81, 0x0f, 0x02, 0x1f, 0x3f, 0x7e, 0x80, 0xfc, 0x03, 0xf0, 0xe0,
+   0x80, 0x1f, 0x81, 0xff, 0x01, 0xf3, 0x80, 0x84, 0x00, 0x01, 0x07, 0x3f,
+   0x90, 0xff, 0x82, 0x00, 0x8c, 0xff, 0x01, 0x3f, 0x07, 0x84, 0x00, 0x01,
+   0x80, 0xf3, 0x81, 0xff, 0x00, 0x1f, 0x80, 0x00, 0x02, 0x03, 0x07, 0x0f,
+   0x80, 0x1f, 0x80, 0x3e, 0x80, 0x7c, 0x80, 0xf8, 0x80, 0xf0, 0x00, 0xe7,
+   0x8e, 0xff, 0x82, 0x00, 0x8a, 0xff, 0x00, 0xe7, 0x80, 0xf0, 0x80, 0xf8,
+   0x80, 0x7c, 0x80, 0x3e, 0x80, 0x1f, 0x02, 0x0f, 0x07, 0x03, 0x8d, 0x00,
+   0x01, 0x39, 0x7d, 0x82, 0x7f, 0x04, 0x3f, 0x0f, 0x1f, 0x3f, 0x7f, 0x86,
+   0xff, 0x82, 0xfc, 0x82, 0xff, 0x04, 0x7f, 0x3f, 0x1f, 0x0f, 0x3f, 0x82,
+   0x7f, 0x01, 0x7d, 0x39, 0xa4, 0x00, 0x80, 0x01, 0x00, 0x03, 0x86, 0xff,
+   0x00, 0x03, 0x80, 0x01, 0xac, 0x00, 0x80, 0xf0, 0x83, 0xf8, 0x00, 0xfb,
+   0x84, 0xff, 0x00, 0xfb, 0x83, 0xf8, 0x80, 0xf0, 0xa8, 0x00, 0x00, 0x0f,
+   0x92, 0x1f, 0x00, 0x0f, 0x93, 0x00,
+};
+const PongImage win_pages = { 64, 8, true, sizeof(win_pages_data), win_pages_data };
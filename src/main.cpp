@@ -7,32 +7,38 @@
 */
 #include "Arduino.h"
 #include "b2debug.h"
+#include "allocstats.h"
+#include "benchmark.h"
+#include "tournament.h"
+#include "metrics.h"
+#include "framepacer.h"
+#include "pacerclock.h"
 
 #include "helper.h"
 
 // display
 #include <Wire.h>  // Only needed for Arduino 1.6.5 and earlier
 #include "SSD1306.h" // alias for `#include "SSD1306Wire.h"`
-#include "img/win.h"
-#include "img/lose.h"
+#include "img/win_pages.h"
+#include "img/lose_pages.h"
+#include "blit.h"
 SSD1306  display(0x3c, 5, 4);
-#define SCREEN_WIDTH 128
-#define SCREEN_HEIGHT 64
-uint centerX = SCREEN_WIDTH/2;
-#define PADDLE_WIDTH 3
-#define PADDLE_HEIGHT 8
-#define BALL_RADIUS 2
-#define FRAME_TIME 33333 // 30 fps
+#include "arena.h"
+typedef SSD1306Arena Arena; // the geometry the game is compiled for
+#define FRAME_TIME Arena::frameTime // 30 fps
 
 // networking
 #define SERVERID 514108976
 bool isServer;
 bool isNetworked;
 #include "networkWiFi.h"
-#include <queue>
+#include "spectator.h"
+#include "fixedqueue.h"
+#define MAX_LEAD_FRAMES (GAMESTATE_BUFFER_SIZE-1) // the other board this far ahead can still roll back our changes
+#define DIRCHG_PER_FRAME 1 // commNetwork sends at most one direction change a frame
+#define FUTUREMSGS_SIZE (MAX_LEAD_FRAMES*DIRCHG_PER_FRAME) // direction changes arriving ahead of our frame counter
 
 // controls
-#define MOVE_SPEED (SCREEN_HEIGHT/1)
 #define TOUCHPIN_UP T6
 #define TOUCHPIN_DOWN T2
 #define TOUCH_SENSITIVITY 80
@@ -40,38 +46,81 @@ bool isNetworked;
 // game params
 #define SCORE_MAX 5
 #define SCORE_MINDIFF 2
+#define SCORE_ACK_TIMEOUT 90 // frames (3 seconds) the server waits for the client to confirm a score
 int8_t scoringSituation=0;
-uint32_t scoreCheckingStartFrame=0;
+uint32_t scoreCheckingStartFrame=0; // server: frame of the potential score being decided
+uint32_t scoreAckFrame=0; // client: frame of the potential score to acknowledge
+uint32_t scoreDetectTime=0;
+#define GAMEOVER_TIME 3000 // ms the win/lose screen stays before a touch restarts
+#define RESUME_GIVEUP 15000 // ms of reconnecting before falling back to a local game
+uint32_t matchSeed; // every serve follows from it, agreed at connect
+uint32_t roundNo=0; // rounds played in the match
+enum PongPhase {
+	PHASE_SERVE, // networked round start: the client waits for the server to start the round,
+	             // after a game over the server waits for the client's touch first
+	PHASE_PLAY,
+	PHASE_GAMEOVER, // win/lose screen, waiting for a touch
+	PHASE_RESUME // connection lost, reconnecting without losing the match
+};
+PongPhase phase=PHASE_SERVE;
+uint32_t phaseStart=0;
+PongPhase resumePhase=PHASE_PLAY; // the phase the link was lost in
+bool gameLost=false;
 #include "gamestate.h"
+#include "physics.h"
 
 // AI state
-bool hasPred = false;
-int32_t predElapsed = 0;
-int32_t predSpeedX;
-int32_t predSpeedY;
-int32_t predExactX;
-int32_t predExactY;
-int32_t predPosY;
-int32_t aiError = 80; // error factor (depends on how far the ball is)
-int32_t aiReaction = 500000; // half of a second "to estimate"
-int32_t aiForesee = 1000000; // one second foresee capability
+#include "ai.h"
+PongAI ai;
+
+// guessing the other paddle between its messages
+#include "predictor.h"
+#define PREDICT_LOG 32 // frames the guesses are kept for to count the misses
+OtherPredictor predictor;
+int8_t otherGuess[PREDICT_LOG]; // the direction the recent frames were made with, by frameID
+int8_t otherDir = 0; // the last direction received
+uint32_t otherConfirmed = 0; // the other side's inputs are known up to this frame
+uint32_t spectatorNext = 0; // the next confirmed frame to stream to the spectators
+
+// seven segment digits (no String and no heap allocation per frame)
+#define DIGIT_WIDTH 5
+#define DIGIT_HEIGHT 9
+#define DIGIT_ADVANCE (DIGIT_WIDTH+2)
+const uint8_t digitSegments[10] = { 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F }; // bits: a, b, c, d, e, f, g
+
+// everything moving on the screen is a sprite, ORed straight into the framebuffer
+PongSprite digitSprites[10], paddleSprite, ballSprite;
+
+void initSprites() {
+  for (uint8_t d=0; d<10; d++) makeDigitSprite(&digitSprites[d], digitSegments[d], DIGIT_WIDTH, DIGIT_HEIGHT);
+  makeRectSprite(&paddleSprite, Arena::paddleWidth, Arena::paddleHeight);
+  makeCircleSprite(&ballSprite, Arena::ballRadius);
+}
+
+void drawDigit(int16_t x, int16_t y, uint8_t digit) {
+  blitSprite(display.buffer, Arena::width, Arena::height, x, y, &digitSprites[digit]);
+}
+
+void drawNumber(int16_t x, int16_t y, uint32_t value, bool alignRight) {
+  uint8_t digits[10], n=0;
+  do { digits[n++]=value % 10; value/=10; } while (value);
+  if (alignRight) x-=n*DIGIT_ADVANCE-2;
+  while (n) { drawDigit(x, y, digits[--n]); x+=DIGIT_ADVANCE; }
+}
 
 void drawFrame(PongGameState *state) {
 	display.clear();
 
   // draw scores
-  display.setFont(ArialMT_Plain_10);
-  display.setTextAlignment(TEXT_ALIGN_RIGHT);
-  display.drawString(centerX-5,0,String(state->scoreSelf));
-  display.setTextAlignment(TEXT_ALIGN_LEFT);
-  display.drawString(centerX+5,0,String(state->scoreOther));
+  drawNumber(Arena::width/2-5,0,state->scoreSelf,true);
+  drawNumber(Arena::width/2+5,0,state->scoreOther,false);
 
   // draw paddles
-	display.fillRect(0,state->posSelf/1000-PADDLE_HEIGHT/2,PADDLE_WIDTH,PADDLE_HEIGHT);
-	display.fillRect(SCREEN_WIDTH-PADDLE_WIDTH,state->posOther/1000-PADDLE_HEIGHT/2,PADDLE_WIDTH,PADDLE_HEIGHT);
+	blitSprite(display.buffer, Arena::width, Arena::height, 0, state->posSelf/1000-Arena::paddleHeight/2, &paddleSprite);
+	blitSprite(display.buffer, Arena::width, Arena::height, Arena::width-Arena::paddleWidth, state->posOther/1000-Arena::paddleHeight/2, &paddleSprite);
 
 	// draw ball
-	display.fillCircle(state->posBallX/1000, state->posBallY/1000, BALL_RADIUS);
+	blitSprite(display.buffer, Arena::width, Arena::height, state->posBallX/1000-Arena::ballRadius, state->posBallY/1000-Arena::ballRadius, &ballSprite);
 
 	display.display();
 }
@@ -95,158 +144,172 @@ void getControls(PongGameState* state) {
 	if (t1<TOUCH_SENSITIVITY) { state->dirSelf--; }
 }
 
-void moveBall(PongGameState* state, PongGameState* pState, int32_t deltaTime) {
-	dbgf(b2DEBUG_MOVEBALL, "moveBall: dT=%d\n", deltaTime);
-	// collision detection
-  int32_t collisionTime = deltaTime, nextSpeedBallX = pState->speedBallX, nextSpeedBallY = pState->speedBallY;
-	if (pState->speedBallY < 0 && checkHCollision(0, BALL_RADIUS*1000, SCREEN_WIDTH*1000,
-	                                    pState->posBallX, pState->posBallY, pState->speedBallX, pState->speedBallY,
-																			deltaTime, &collisionTime)) { // collide with top
-    nextSpeedBallY=-pState->speedBallY;
-	} else if (pState->speedBallY > 0 && checkHCollision(0, (SCREEN_HEIGHT-BALL_RADIUS)*1000, SCREEN_WIDTH*1000,
-	                                    pState->posBallX, pState->posBallY, pState->speedBallX, pState->speedBallY,
-																			deltaTime, &collisionTime)) { // collide with bottom
-    nextSpeedBallY=-pState->speedBallY;
-	} else if (pState->speedBallX < 0 && checkVCollision((PADDLE_WIDTH+BALL_RADIUS)*1000, pState->posSelf-PADDLE_HEIGHT*500-BALL_RADIUS*1000, pState->posSelf+PADDLE_HEIGHT*500+BALL_RADIUS*1000,
-	                                             pState->posBallX, pState->posBallY, pState->speedBallX, pState->speedBallY,
-																							 deltaTime, &collisionTime)) { // collide with left paddle
-    nextSpeedBallX=-pState->speedBallX; 
-		// adjust for moving paddle
-		if (state->dirSelf>0)
-				nextSpeedBallY = nextSpeedBallY * (nextSpeedBallY < 0 ? 0.5 : 1.5);
-		else if (state->dirSelf<0)
-          nextSpeedBallY = nextSpeedBallY * (nextSpeedBallY > 0 ? 0.5 : 1.5);
-	} else if (pState->speedBallX > 0 && checkVCollision((SCREEN_WIDTH-PADDLE_WIDTH-BALL_RADIUS)*1000, pState->posOther-PADDLE_HEIGHT*500-BALL_RADIUS*1000, pState->posOther+PADDLE_HEIGHT*500+BALL_RADIUS*1000,
-	                                             pState->posBallX, pState->posBallY, pState->speedBallX, pState->speedBallY,
-																							 deltaTime, &collisionTime)) { // collide with right paddle
-    nextSpeedBallX=-pState->speedBallX; 
-		// adjust for moving paddle
-    if (state->dirOther>0)
-      nextSpeedBallY = nextSpeedBallY * (nextSpeedBallY < 0 ? 0.5 : 1.5);
-    else if (state->dirOther<0)
-      nextSpeedBallY = nextSpeedBallY * (nextSpeedBallY > 0 ? 0.5 : 1.5);
+// decides the potential score at the frame it was seen (server side)
+void commitScore(PongGameState *state) {
+	PongGameState *scoreState = getStateWithID(scoreCheckingStartFrame);
+	if (!scoreState) scoreState = state;
+	scoreCheckingStartFrame=0; // signal for future self that we restarted score checking
+	uint32_t handshake=micros()-scoreDetectTime;
+	metrics.scores++;
+	metrics.scoreUs+=handshake;
+	metricsMax(&metrics.scoreMaxUs, handshake);
+	int8_t scoring=checkScoreSituation<Arena>(scoreState);
+	if (scoring!=0) {
+		scoringSituation=scoring; // signal for checkScore to show win/lose screen
+		sendFinalScore(scoreState->frameID, scoring);
 	}
-	// move1
-	state->posBallX = pState->posBallX + pState->speedBallX * collisionTime / 1000;
-	state->posBallY = pState->posBallY + pState->speedBallY * collisionTime / 1000;
-	dbg(b2DEBUG_MOVEBALL, "move1:[speed=("); dbg(b2DEBUG_MOVEBALL, state->speedBallX); dbg(b2DEBUG_MOVEBALL, ";"); dbg(b2DEBUG_MOVEBALL, state->speedBallY); dbg(b2DEBUG_MOVEBALL, ") pos=("); dbg(b2DEBUG_MOVEBALL, state->posBallX); dbg(b2DEBUG_MOVEBALL, ";"); dbg(b2DEBUG_MOVEBALL, state->posBallY); dbg(b2DEBUG_MOVEBALL, ")] ");
-	// update ball speed according to collision 
-	state->speedBallX=nextSpeedBallX;
-	state->speedBallY=nextSpeedBallY;
-	// move2 (finish the move if collision happens mid-frame)
-	state->posBallX += state->speedBallX * (deltaTime-collisionTime) / 1000;
-	state->posBallY += state->speedBallY * (deltaTime-collisionTime) / 1000;
-	dbg(b2DEBUG_MOVEBALL, "move2:[speed=("); dbg(b2DEBUG_MOVEBALL, state->speedBallX); dbg(b2DEBUG_MOVEBALL, ";"); dbg(b2DEBUG_MOVEBALL, state->speedBallY); dbg(b2DEBUG_MOVEBALL, ") pos=("); dbg(b2DEBUG_MOVEBALL, state->posBallX); dbg(b2DEBUG_MOVEBALL, ";"); dbg(b2DEBUG_MOVEBALL, state->posBallY); dbgln(b2DEBUG_MOVEBALL, ")]");
+	dbgf2(b2DEBUG_SCORE, "Score at frame %d decided: %d\n", scoreState->frameID, scoring);
 }
 
-void recalcFrame(PongGameState* curState, PongGameState* pState) {
-	int32_t move;
-	// default frame time, we don't handle differences
-	int32_t deltaTime = FRAME_TIME; 
-	// move self
-	move = deltaTime * MOVE_SPEED / 1000;
-	dbgf(b2DEBUG_RECALCFRAME, "self move amount in this frame: %d\n", move);
-	curState->posSelf = pState->posSelf + curState->dirSelf * move; 
-	if (curState->posSelf<(PADDLE_HEIGHT*1000/2)) curState->posSelf=(PADDLE_HEIGHT*1000/2);
-	if (curState->posSelf>(SCREEN_HEIGHT-PADDLE_HEIGHT/2)*1000) curState->posSelf=(SCREEN_HEIGHT-PADDLE_HEIGHT/2)*1000;
-	dbgf(b2DEBUG_RECALCFRAME, "recalculated self position: %d\n", curState->posSelf);
-	// move other
-	move = deltaTime * MOVE_SPEED / 1000;
-	dbgf(b2DEBUG_RECALCFRAME, "other move amount in this frame: %d\n", move);
-	curState->posOther = pState->posOther + curState->dirOther * move; 
-	if (curState->posOther<(PADDLE_HEIGHT*1000/2)) curState->posOther=(PADDLE_HEIGHT*1000/2);
-	if (curState->posOther>(SCREEN_HEIGHT-PADDLE_HEIGHT/2)*1000) curState->posOther=(SCREEN_HEIGHT-PADDLE_HEIGHT/2)*1000;
-	dbgf(b2DEBUG_RECALCFRAME, "recalculated other position: %d\n", curState->posOther);
-	// move the ball
-	moveBall(curState, pState, deltaTime);
+FixedQueue<PongDirChangeMsg, FUTUREMSGS_SIZE> futureMsgs;
+static_assert(FUTUREMSGS_SIZE>=MAX_LEAD_FRAMES*DIRCHG_PER_FRAME, "every change of a board still in reach has to fit");
+uint32_t lastFrameSent = 0, lastFrameReceived = 0;
+
+// following our direction changes to the other board's display (see latencyRecord)
+#define TRACE_PENDING 4 // changes applied since the last drawn frame
+struct PongLatencyTrace {
+	uint32_t captured; // the sender's touch read, on our clock
+	uint32_t applied; // rolled into the history
+};
+PongLatencyTrace traces[TRACE_PENDING];
+uint8_t tracesPending = 0;
+uint32_t inputTime = 0; // when getControls read the touch of this frame
+int8_t lastDirRx = 0; // the direction of the last message taken, the changes are traced (not the keepalives)
+
+uint32_t traceApplied(uint32_t captured) { // returns the time it was applied
+	uint32_t now = micros();
+	if (tracesPending<TRACE_PENDING) {
+		traces[tracesPending].captured = captured;
+		traces[tracesPending++].applied = now;
+	}
+	return now;
 }
 
-int8_t checkScoreSituation(PongGameState *state) { // returns 1: we won a point, 0: no scoring, -1: we lost a point
-	if (state->posBallX>(SCREEN_WIDTH+BALL_RADIUS)*1000) {
-		return 1;
-	} else if (state->posBallX<-BALL_RADIUS) {
-		return -1;
-	} else {
-		return 0;
+void traceDrawn() {
+	uint32_t now = micros();
+	for (uint8_t i=0; i<tracesPending; i++) {
+		latencyRecord(LAT_DRAW, now-traces[i].applied);
+		latencyRecord(LAT_TOTAL, now-traces[i].captured);
+	}
+	tracesPending = 0;
+}
+
+// the other side's inputs are known up to frameID, where its direction is dir (before it, it held the
+// last one): counts the guesses made for these frames, returns the first one played wrong (NO_FRAME: none)
+uint32_t confirmOther(uint32_t frameID, int8_t dir) {
+	uint32_t wrong = NO_FRAME, last = std::min(frameID, curState()->frameID);
+	for (uint32_t f=otherConfirmed+1; f<=last; f++) {
+		int8_t actual = f<frameID ? otherDir : dir;
+		if (last-f<PREDICT_LOG) {
+			metrics.predFrames++;
+			if (otherGuess[f%PREDICT_LOG]!=actual) metrics.predMisses++;
+		}
+		uint32_t idx = getStateIdxWithID(f);
+		if (wrong==NO_FRAME && idx!=NO_FRAME && getState(idx)->dirOther!=actual) wrong = f;
+	}
+	if (frameID>otherConfirmed) {
+		otherConfirmed = frameID;
+		otherDir = dir;
 	}
+	return wrong;
 }
 
-std::queue<PongDirChangeMsg> futureMsgs;
-void commNetwork(PongGameState *state, PongGameState *pState) {
-	static uint32_t lastFrameSent = 0, lastFrameReceived = 0;
-	// send frameid + self direction if changed 
-	if (state->dirSelf != pState->dirSelf) {
-		sendDirChg(state);
+// the other paddle moves in dir from frame fid on: rolls back from the first frame played otherwise
+void handleDirChg(PongGameState *state, uint32_t fid, int8_t dir) {
+	int8_t held = otherDir;
+	uint32_t wrong = confirmOther(fid, dir);
+	if (wrong==NO_FRAME && getStateIdxWithID(fid)!=NO_FRAME) return; // the history has it already (a keepalive)
+	if (wrong!=NO_FRAME && wrong<fid) {
+		// a change was guessed that did not come
+		rollbackOther<Arena>(wrong, held);
+		if (dir==held) {
+			metricsRollback(state->frameID-wrong+1);
+			return;
+		}
+	}
+	// recalculate all frames from that id
+	if (rollbackOther<Arena>(fid, dir)) metricsRollback(state->frameID-std::min(wrong, fid)+1);
+	else { // this can happen in only one case: message arrived that late that it is out of buffer now
+		metrics.lateMsgs++;
+		for (int idx=0; idx<GAMESTATE_BUFFER_SIZE; idx++) dbgf(b2DEBUG_WIFI, "\t%d", getState(idx)->frameID);
+		// TODO: no calculation is possible on this side, request full game state
+		// TODO: do we do this on both sides or only client? -> server should have authority
+	}
+	dbgf2(b2DEBUG_WIFI, "Final new posself: %d, posother: %d. ", state->posSelf, state->posOther);
+	dbgln(b2DEBUG_WIFI, "");
+}
+
+bool commNetwork(PongGameState *state, PongGameState *pState) { // false if the other board got out of reach
+	// send frameid + self direction if changed (or as a keepalive if we were silent for long)
+	if (state->dirSelf != pState->dirSelf || state->frameID-lastFrameSent >= KEEPALIVE_FRAMES) {
+		uint32_t sent = sendDirChg(state, inputTime);
+		if (state->dirSelf != pState->dirSelf) latencyRecord(LAT_SEND, sent-inputTime);
 		lastFrameSent = state->frameID;
 	}
+	// drop what can not be handled while playing (e.g. an ACK that arrived after we stopped waiting for it)
+	if (isServer) discardNetMsgs(MSGMASK(MSG_DIRCHG) | MSGMASK(MSG_POTENTIALSCOREACK));
+	else discardNetMsgs(MSGMASK(MSG_DIRCHG) | MSGMASK(MSG_POTENTIALSCORE) | MSGMASK(MSG_FINALSCORE) | MSGMASK(MSG_ROUND));
+	// guess the other paddle's direction, a message rolls it back if it was wrong
+	state->dirOther = predictor.next<Arena>(pState, otherDir);
+	otherGuess[state->frameID%PREDICT_LOG] = state->dirOther;
 	// see if have buffered (future) frames we should handle already
-	while (futureMsgs.front().frameID<=state->frameID) {
-		PongDirChangeMsg msg = futureMsgs.front();
-		PongGameState *st = getStateWithID(msg.frameID);
-		if (!st) { // this can happen in only one case: message arrived that late that it is out of buffer now
-			for (int idx=0; idx<100/*GAMESTATE_BUFFER_SIZE*/; idx++) dbgf(b2DEBUG_WIFI, "\t%d", getState(idx)->frameID);
-			// TODO: no calculation is possible on this side, request full game state
-			// TODO: do we do this on both sides or only client? -> server should have authority
-		} 
-		PongGameState *pSt = prevState(st);
-		while (st) {
-			dbgf4(b2DEBUG_WIFI, "State pointer: %p (frameID: %d), prev state pointer: %p (frameID: %d). ", st, st?st->frameID:0, pSt, pSt?pSt->frameID:0);
-			st->dirOther = msg.direction; // we recalculate all frames until current (because we are using TCP connection which guarantees the order of packets, which in turn guarantees that we have not received any messages from a later frame than the current message)
-			recalcFrame(st, pSt);
-			dbgf2(b2DEBUG_WIFI, "New posself: %d, posother: %d. ", st->posSelf, st->posOther);
-			pSt = st;
-			st = nextState(st);
-		}
-		dbgf2(b2DEBUG_WIFI, "Final new posself: %d, posother: %d. ", state->posSelf, state->posOther);
-		dbgln(b2DEBUG_WIFI, "");
+	while (!futureMsgs.empty() && futureMsgs.front()->frameID<=state->frameID) {
+		PongDirChangeMsg msg = *futureMsgs.front();
+		// TCP keeps the order of the messages, so nothing from a later frame than this one was received yet
+		bool changed = msg.direction!=otherDir;
+		handleDirChg(state, msg.frameID, msg.direction);
+		if (changed) traceApplied(msg.captureTime); // waited for our frame, so no apply time
 		futureMsgs.pop();
 	}
-	// see if received other direction
-	uint32_t fid; int8_t dir;
-	if (acceptDirChg(&fid, &dir)) {
+	// see if received other direction (drain everything the receive task decoded since the last frame)
+	uint32_t fid, rxTime, captureTime, sendTime; int8_t dir;
+	while (acceptDirChg(&fid, &dir, &rxTime, &captureTime, &sendTime)) {
+		uint32_t accepted = micros();
+		int32_t offset = getClockOffset();
+		bool changed = dir!=lastDirRx;
+		if (changed) {
+			latencyRecord(LAT_WIRE, rxTime-(sendTime-offset));
+			latencyRecord(LAT_QUEUE, accepted-rxTime);
+		}
+		lastDirRx = dir;
 		lastFrameReceived = fid;
 		if (fid>state->frameID) {
 			// buffer future frames
 			PongDirChangeMsg msg;
 			msg.frameID=fid; msg.direction=dir;
-			futureMsgs.push(msg);
+			msg.captureTime=captureTime-offset; msg.sendTime=sendTime-offset;
+			if (!futureMsgs.push(msg)) {
+				// the other board is further ahead than the histories reach, only a resume brings them together again
+				dbgln(b2DEBUG_WIFI, "Future message buffer full, resuming the session");
+				metrics.futureDropped++;
+				return false;
+			}
+			metricsMax(&metrics.futureMax, futureMsgs.size());
 			dbgf2(b2DEBUG_WIFI, "Current frame is %d. Buffering frame %d", state->frameID, fid);
 		} else {
 			dbgf4(b2DEBUG_WIFI, "Current frame is %d. Recalculating from frame %d, posself: %d, posother: %d. ", state->frameID, fid, state->posSelf, state->posOther);
-			// if yes, recalculate all frames from that id
-			PongGameState *st = getStateWithID(fid);
-			if (!st) { // this can happen in only one case: message arrived that late that it is out of buffer now
-				for (int idx=0; idx<100/*GAMESTATE_BUFFER_SIZE*/; idx++) dbgf(b2DEBUG_WIFI, "\t%d", getState(idx)->frameID);
-				// TODO: no calculation is possible on this side, request full game state
-				// TODO: do we do this on both sides or only client? -> server should have authority
-			} 
-			PongGameState *pSt = prevState(st);
-			while (st) {
-				dbgf4(b2DEBUG_WIFI, "State pointer: %p (frameID: %d), prev state pointer: %p (frameID: %d). ", st, st?st->frameID:0, pSt, pSt?pSt->frameID:0);
-				st->dirOther = dir; // we recalculate all frames until current (because we are using TCP connection which guarantees the order of packets, which in turn guarantees that we have not received any messages from a later frame than the current message)
-				recalcFrame(st, pSt);
-				dbgf2(b2DEBUG_WIFI, "New posself: %d, posother: %d. ", st->posSelf, st->posOther);
-				pSt = st;
-				st = nextState(st);
-			}
-			dbgf2(b2DEBUG_WIFI, "Final new posself: %d, posother: %d. ", state->posSelf, state->posOther);
-			dbgln(b2DEBUG_WIFI, "");
+			handleDirChg(state, fid, dir);
+			if (changed) latencyRecord(LAT_APPLY, traceApplied(captureTime-offset)-accepted);
+			dbgf(b2DEBUG_WIFI, "Arrival to rollback: %d us\n", micros()-rxTime);
 		}
 	}
+	metrics.futureMsgs = futureMsgs.size();
 	if (!isServer) {
   	// if we are a client see if received score frame (server sends score frame from checkScore)
 		uint32_t fid, lastFrameHandled, lastFrameShouldReceive;
 		if (acceptPotentialScore(&fid, &lastFrameHandled, &lastFrameShouldReceive)) {
-			// check if all commands from client was handled on server and all commands from server was handled on client
 			// since we are on TCP which guarantees message order we can not have unhandled server messages on client
 			if (lastFrameShouldReceive>lastFrameReceived) {
-				// this is a real surprise, means server messages are out of order
-				// we should just crash / reboot here
-				ESP.restart();
-				delay(1000);
+				// this is a real surprise, the server decides anyway and the next round's start resyncs the scores
+				dbgf2(b2DEBUG_SCORE, "Server sent frame %d we have not seen (last received: %d)\n", lastFrameShouldReceive, lastFrameReceived);
 			}
-			// we can just send the acknowledge message because TCP guarantees message order
+			scoreAckFrame=fid; // acknowledge once we have sent all our inputs up to that frame
+			handleDirChg(state, std::min(fid, state->frameID), otherDir); // so are the server's, a change guessed since did not come
+		}
+		if (scoreAckFrame!=0 && state->frameID>=scoreAckFrame) {
+			// our direction changes up to now are already sent and TCP delivers them before the acknowledge
 			sendPotentialScoreAck(state->frameID, lastFrameReceived, lastFrameSent);
+			scoreAckFrame=0;
 		}
 		int8_t scoring;
 		if (acceptFinalScore(&fid, &scoring)) {
@@ -254,159 +317,266 @@ void commNetwork(PongGameState *state, PongGameState *pState) {
 			scoringSituation=-scoring; // need to reverse the roles in scoring direction
 		}
 	} else {
+		uint32_t fid, lastFrameHandled, lastFrameShouldReceive;
+		bool acked=acceptPotentialScoreAck(&fid, &lastFrameHandled, &lastFrameShouldReceive); // always drain, a late one must not block the queue
+		if (acked) handleDirChg(state, std::min(fid, state->frameID), otherDir); // the client sent all its changes up to then, a guessed one that did not come is undone
 		if (scoreCheckingStartFrame==0) {
-			int8_t scoring = checkScoreSituation(state);
+			int8_t scoring = checkScoreSituation<Arena>(state);
 			if (scoring!=0) {
-				// we have a potential scoring situation
+				// we have a potential scoring situation, it gets decided at this frame
 				sendPotentialScore(state->frameID, lastFrameReceived, lastFrameSent);
 				scoreCheckingStartFrame=state->frameID;
+				scoreDetectTime=micros();
 			}
-		} else {
-  		uint32_t fid, lastFrameHandled, lastFrameShouldReceive;
-			if (acceptPotentialScoreAck(&fid, &lastFrameHandled, &lastFrameShouldReceive)) {
-				scoreCheckingStartFrame=0; // signal for future self that we restarted score checking
-				int8_t scoring=checkScoreSituation(state);
-				if (scoring!=0) {
-					scoringSituation=scoring; // signal for checkScore to show win/lose screen
-					sendFinalScore(state->frameID, scoring);
-				}
-			} else {
-				if (state->frameID-scoreCheckingStartFrame > 90) { // 3 seconds timeout
-				  // on timeout we can safely assume that we lost connection so restart to fall back to local game
-					ESP.restart();
-					delay(1000);
-				}
-			}
+		} else if (acked && fid>=scoreCheckingStartFrame) {
+			// the client is past the score frame: all its inputs up to that frame are applied
+			commitScore(state);
+		} else if (state->frameID-scoreCheckingStartFrame > SCORE_ACK_TIMEOUT) {
+			// the acknowledge is late: decide with what we have, the next round's start resyncs the client's scores
+			dbgln(b2DEBUG_SCORE, "Score acknowledge timed out, deciding without it");
+			metrics.scoreTimeouts++;
+			commitScore(state);
 		}
 	}
+	return true;
 }
 
-bool predict(int32_t deltaTime, PongGameState *state) {
-  // only re-predict if the ball changed direction, or its been some amount of time since last prediction
-  if (hasPred && // we have earlier prediction
-			((predSpeedX * state->speedBallX) > 0) && // no direction change since then
-			((predSpeedY * state->speedBallY) > 0) && // no direction change since then
-			(predElapsed < aiReaction)) { // and we are not yet recalibrating
-		predElapsed += deltaTime; // some time elapsed
-		return true;
-	}
+/**********
+** Round and match flow
+**   every phase is a non-blocking step of loop(), so frames keep ticking and the
+**   network keeps being drained while we wait for the peer or for the player
+***********/
+void drawGameOver() { // the win or lose icon
+	const PongImage *img=gameLost?&lose_pages:&win_pages;
+	display.clear();
+	#ifdef b2DEBUG
+	  uint32_t blitStart=micros();
+	#endif
+	blitImage(display.buffer, Arena::width, (Arena::width - img->width)/2, (Arena::height/8 - img->pages)/2, img);
+	dbgf(b2DEBUG_SCORE, "Image blit took %d us\n", micros()-blitStart);
+	display.display();
+}
 
-  int32_t interceptTime = deltaTime;
-	int32_t intX = (SCREEN_WIDTH-PADDLE_WIDTH)*1000;
-	int32_t intY;
-  bool intercept = checkVCollision(intX, -10000000, 10000000,
-																	 state->posBallX, state->posBallY, state->speedBallX, state->speedBallY,
-																	 aiForesee, &interceptTime); 
-	if (intercept) {
-		intY = state->posBallY+interceptTime*state->speedBallY/1000;
-		dbgf5(b2DEBUG_AIPRED, "ball: (%d;%d) ballspeed: (%d;%d) intercept: y=%d", state->posBallX, state->posBallY, state->speedBallX, state->speedBallY, intY);
-
-    int32_t t = 0 + BALL_RADIUS*1000; //this.minY + ball.radius;
-    int32_t b = (SCREEN_HEIGHT - 0 - PADDLE_HEIGHT + PADDLE_HEIGHT - BALL_RADIUS) * 1000; //this.maxY + this.height - ball.radius;
-
-		while ((intY < t) || (intY > b)) {
-			if (intY < t) {
-				intY = t + (t - intY);
-			} else if (intY > b) {
-				intY = t + (b - t) - (intY - b);
-			}
-		}
-		hasPred = true;
-		dbgf(b2DEBUG_AIPRED," intercept adjusted: y=%d", intY);
-	} else {
-		hasPred = false;
-	}
+void setPhase(PongPhase newPhase) {
+	dbgf2(b2DEBUG_SCORE, "Phase %d -> %d\n", phase, newPhase);
+	phase=newPhase;
+	phaseStart=millis();
+	if (newPhase==PHASE_PLAY && isNetworked) refreshLink(); // the peer may only now start talking
+}
 
-	if (hasPred) {
-		predElapsed = 0;
-		predSpeedX = state->speedBallX;
-		predSpeedY = state->speedBallY;
-		predExactX = intX;
-		predExactY = intY;
-		int32_t closeness = (predSpeedX < 0 ? state->posBallX - (SCREEN_WIDTH*1000) : (SCREEN_WIDTH-PADDLE_WIDTH)*1000 - state->posBallX) / SCREEN_WIDTH;
-		int32_t error = aiError * closeness;
-		predPosY = predExactY + random(-error, error);
-		dbgf5(b2DEBUG_AIPRED," prediction: exact=(%d;%d) y=%d closeness=%d error=%d\n", predExactX, predExactY, predPosY, closeness, error);
-	}
+void linkLost() {
+	dbgln(b2DEBUG_WIFI, "Connection lost, trying to resume the session");
+	metrics.linksLost++;
+	allocFrameSkip();
+	dropLink();
+	resumePhase=phase;
+	setPhase(PHASE_RESUME);
+	displayMsg("Connection lost", "Resuming match...");
 }
 
-void calcAI(PongGameState *state, PongGameState *pState) {
-	// calc deltaTime
-	int32_t deltaTime = FRAME_TIME;
-	// don't do any AI thing if ball is over the other side of the paddle
-	if (((pState->posBallX < (SCREEN_WIDTH-PADDLE_WIDTH)*1000) && (pState->speedBallX < 0)) ||
-			((pState->posBallX > SCREEN_WIDTH*1000) && (pState->speedBallX > 0))) {
-		state->dirOther=0;
-		return;
-	}
-  // predict the ball position
-	predict(deltaTime, pState);
-	// handle prediction to movement conversion
-	if (hasPred) {
-		if (predPosY < pState->posOther - 5000) {
-			state->dirOther=-1;
-		} else if (predPosY > pState->posOther + 5000) {
-			state->dirOther=1;
-		} else {
-			state->dirOther=0;
-		}
-		dbgf3(b2DEBUG_AIMOVE, "predicted pos: %d, paddle pos: %d, AI move dir: %d\n", predPosY, pState->posOther, state->dirOther);
-	} else state->dirOther = 0; // no prediction no move
+// the serve of a round follows from the match seed, so both sides set it up without a state transfer
+void setupRound(uint32_t round, bool lost) { // lost: as the server (or the local player) sees it
+	PongPRNG rng;
+	prngSeed(&rng, prngMix(matchSeed ^ prngMix(round)));
+	int32_t angle = lost ? prngRandom(&rng, -30, 30) : prngRandom(&rng, 150, 210);
+	PongGameState *state=curState();
+	uint32_t frameID=state->frameID;
+	uint8_t scoreSelf=state->scoreSelf, scoreOther=state->scoreOther;
+	memset(state, 0, sizeof(PongGameState));
+	state->frameID=frameID;
+	state->scoreSelf=scoreSelf; state->scoreOther=scoreOther;
+	state->posSelf=Arena::height/2*1000;
+	state->posOther=Arena::height/2*1000;
+	serveBall<Arena>(state, angle);
 }
 
 void initRound(bool lost) {	
 	// clear the gamestate buffer and add our first frame while carrying on the scores
 	uint32_t scoreSelf = curState()->scoreSelf, scoreOther = curState()->scoreOther;
 	initBuffer(); 
+	futureMsgs.clear();
 	bufferAdd(); 
 	curState()->scoreSelf = scoreSelf; curState()->scoreOther = scoreOther;
 	// initialize the new round
 	scoringSituation=0;
+	scoreCheckingStartFrame=0;
+	scoreAckFrame=0;
+	lastFrameSent=0;
+	lastFrameReceived=0;
+	otherDir=0;
+	otherConfirmed=0;
+	spectatorNext=0;
+	lastDirRx=0;
+	tracesPending=0;
+	memset(otherGuess, 0, sizeof(otherGuess));
+	predictor.reset();
 	if (isServer || ! isNetworked) { // server or local
-		float angle;
-		if (lost)
-			angle=random(60)-30;
-		else
-			angle=random(60)+150;
-		PongGameState *state=curState();
-		state->speedBallX=45*cos(angle*PI/180);
-		state->speedBallY=45*sin(angle*PI/180);
-		state->posBallX=SCREEN_WIDTH*500;
-		state->posBallY=SCREEN_HEIGHT*500;
-		state->posOther = SCREEN_HEIGHT/2*1000;
+		setupRound(++roundNo, lost);
 		if (isNetworked) {
-			printGameState(state);
-			sendGameState(state);
-			waitMsg("ACK");
-			// handle latency (fast forward some frames)
-			PongGameState *curstate=curState();
-			for (int i=getReceivingLatency() / FRAME_TIME; i>0; i--) {
-				PongGameState* newstate=copyLatestState();
-				recalcFrame(newstate, curstate);
-				curstate=newstate;
+			printGameState(curState());
+			PongRoundMsg round = { roundNo, curState()->scoreSelf, curState()->scoreOther, lost };
+			sendRound(&round); // the client catches up by the time this takes to get there
+			if (scoreDetectTime) {
+				uint32_t serve=micros()-scoreDetectTime;
+				dbgf(b2DEBUG_SCORE, "Goal line to serve: %d us\n", serve);
+				metrics.serves++;
+				metrics.serveUs+=serve;
+				metricsMax(&metrics.serveMaxUs, serve);
+				scoreDetectTime=0;
 			}
 		}
-	} else { // client
-		waitGameState(curState());
-		sendMsg("ACK");
+		setPhase(PHASE_PLAY);
+	} else {
+		setPhase(PHASE_SERVE); // the client waits for the server to start the round
+	}
+}
+
+void serveRound() {
+	if (isServer) { // after a game over: serve once the client is ready too
+		discardNetMsgs(MSGMASK(MSG_READY));
+		if (acceptReady()) initRound(gameLost);
+		return;
+	}
+	discardNetMsgs(MSGMASK(MSG_ROUND));
+	PongRoundMsg round; uint32_t rxTime;
+	if (acceptRound(&round, &rxTime)) {
+		roundNo=round.round;
+		curState()->scoreSelf=round.scoreSelf; curState()->scoreOther=round.scoreOther; // the server has the say
+		setupRound(round.round, round.lost);
 		printGameState(curState());
 		reverseRoles(curState());
+		// the server started the round when it sent the message, catch up with it
+		uint32_t frames=(micros()-rxTime+getReceivingLatency()) / FRAME_TIME;
+		if (frames>GAMESTATE_BUFFER_SIZE-1) frames=GAMESTATE_BUFFER_SIZE-1;
+		for (; frames>0; frames--) {
+			PongGameState *pState=curState();
+			recalcFrame<Arena>(copyLatestState(), pState);
+		}
+		setPhase(PHASE_PLAY);
 	}
 }
 
+void resumeBetweenRounds(PongPhase back) { // the game over screen again, or waiting for the next round
+	if (back==PHASE_GAMEOVER) drawGameOver();
+	else displayMsg("Waiting for", "the next round...");
+	setPhase(back);
+}
+
+void resumeSession() {
+	allocFrameSkip();
+	if (millis()-phaseStart>RESUME_GIVEUP) {
+		dbgln(b2DEBUG_WIFI, "Could not resume, fallback to local game");
+		metrics.fallbacks++;
+		isNetworked=false;
+		initRound(false);
+		return;
+	}
+	uint8_t count, inputs[GAMESTATE_BUFFER_SIZE]; // both directions of each frame: (self+1) | (other+1)<<2 as the server sees it
+	if (isServer) {
+		if (!acceptReconnect()) return;
+		// the last frame we have the client's input for, and what we played since then
+		PongGameState *base = getStateWithID(lastFrameReceived);
+		if (!base) base = oldestState();
+		count = 0;
+		for (PongGameState *st = nextState(base); st; st = nextState(st))
+			inputs[count++] = (st->dirSelf+1) | ((st->dirOther+1)<<2);
+		sendResume(base, count, inputs, resumePhase==PHASE_PLAY);
+	} else {
+		if (!reconnect()) return;
+		PongGameState base;
+		bool playing;
+		if (!waitResume(&base, &count, inputs, &playing)) {
+			dropLink();
+			return;
+		}
+		if (!playing) {
+			// the server is between rounds: so are we, a round we were still in has ended without us
+			dbgf(b2DEBUG_WIFI, "Session resumed between rounds in %d ms\n", millis()-phaseStart);
+			metrics.resumes++;
+			resumeBetweenRounds(resumePhase==PHASE_GAMEOVER ? PHASE_GAMEOVER : PHASE_SERVE);
+			if (phase==PHASE_SERVE) sendReady(); // the server may be waiting for it, an earlier one died with the link
+			return;
+		}
+		// rebuild our history from the server's view
+		initBuffer();
+		futureMsgs.clear();
+		bufferAdd();
+		memcpy(curState(), &base, sizeof(PongGameState));
+		mirrorState<Arena>(curState());
+		for (int i=0; i<count; i++) {
+			PongGameState *pState = curState();
+			PongGameState *state = copyLatestState();
+			state->dirSelf = ((inputs[i]>>2) & 3) - 1;
+			state->dirOther = (inputs[i] & 3) - 1;
+			recalcFrame<Arena>(state, pState);
+		}
+		// the server's inputs came with the resume, the frames it played since are guessed
+		otherDir = curState()->dirOther;
+		otherConfirmed = curState()->frameID;
+		lastDirRx = otherDir;
+		memset(otherGuess, otherDir, sizeof(otherGuess));
+		// the server went on while the resume travelled here
+		for (int i=getReceivingLatency() / FRAME_TIME; i>0; i--) {
+			PongGameState *pState = curState();
+			recalcFrame<Arena>(copyLatestState(), pState);
+		}
+		lastFrameReceived = base.frameID;
+		lastFrameSent = base.frameID;
+	}
+	dbgf(b2DEBUG_WIFI, "Session resumed in %d ms\n", millis()-phaseStart);
+	metrics.resumes++;
+	if (isServer && resumePhase!=PHASE_PLAY) resumeBetweenRounds(resumePhase);
+	else setPhase(PHASE_PLAY);
+}
+
+bool touched() { // non-blocking, true if any of the pads is touched
+	uint16_t t1=0, t2=0;
+	for (int i=0; i<5; i++) { // we use the maximum of 5 measurements
+		t1=std::max(touchRead(TOUCHPIN_UP), t1);
+		t2=std::max(touchRead(TOUCHPIN_DOWN), t2);
+	}
+	dbgf3(b2DEBUG_SCORE, "touch1: %d; touch2: %d; sensi: %d\n", t1, t2, TOUCH_SENSITIVITY);
+	// below 10 its measurement error
+	return (t1>=10 && t1<=TOUCH_SENSITIVITY) || (t2>=10 && t2<=TOUCH_SENSITIVITY);
+}
+
+void gameOver() {
+	if (isNetworked) discardNetMsgs(MSGMASK(MSG_READY)); // keep the client's ready if it is faster to restart
+	// wait a fixed amount of time (because touch will be still on when we get here: player will still be controlling the paddle)
+	if (millis()-phaseStart<GAMEOVER_TIME) return;
+	// wait for touch
+	if (!touched()) return;
+	curState()->scoreSelf=0;
+	curState()->scoreOther=0;
+	if (isNetworked) {
+		allocFrameSkip(); // drawString allocates, it is not a frame of play
+		displayMsg("Waiting for", "the other player...");
+	}
+	// the server serves once both players are ready, so neither misses the start on the win/lose screen
+	if (isNetworked && isServer) {
+		setPhase(PHASE_SERVE);
+		return;
+	}
+	if (isNetworked) sendReady();
+	initRound(gameLost);
+}
+
 /*****************************************************************************************
  * Network scoring:                                                                      *
  *   Server                                   Client                                     *
  *    - sees a potential scoring situation                                               *
+ *      at frame S                                                                       *
  *    - sends a "potential score" message       - gets a potential score message         *
- *    - continues to process frames until       - checks if out of order and reboots to  *
- *      all frame messages are processed          fall back to local game                *
- *      and gets the "score acknowledge"        - sends "score acknowledge" message      *
- *      message                                                                          *
- *    - checks timeout and reboots to fall                                               *
- *      back to local game                                                               *
- *    - checks if score situation is still                                               *
- *      existing                                                                         *
+ *      stamped with S                                                                   *
+ *    - continues to process frames until       - continues to play until its own frame  *
+ *      it gets the "score acknowledge"           reaches S (all its inputs up to S are  *
+ *      message stamped with a frame >= S         sent by then)                          *
+ *                                              - sends "score acknowledge" message      *
+ *    - checks if score situation existed                                                *
+ *      at frame S (all client inputs up to                                              *
+ *      S are applied by now)                                                            *
+ *    - on timeout decides with what it has,                                             *
+ *      the next round's start resyncs                                                   *
  *    - sends a "final score" message          - if gets a final score message shows     *
  *    - shows win/lose scren or starts new       win/lose screen or starts new round     *
  *      round                                                                            *
@@ -414,90 +584,137 @@ void initRound(bool lost) {
 
 void checkScore(PongGameState *state) {
 	int8_t scoring=scoringSituation;
-	if (!isNetworked) scoring=checkScoreSituation(state); // if it is local we check the situation here
+	if (!isNetworked) scoring=checkScoreSituation<Arena>(state); // if it is local we check the situation here
 	if (scoring!=0) {
 		if (scoring<0) state->scoreOther++; else state->scoreSelf++;
 		dbgf2(b2DEBUG_SCORE, "Scored: %d vs %d\n", state->scoreSelf, state->scoreOther);
 		// check if game is over
-		int32_t h, w; const uint8_t *p=NULL;
+		const PongImage *img=NULL;
 		if (state->scoreSelf>=SCORE_MAX && state->scoreSelf>=state->scoreOther+SCORE_MINDIFF) {
-			h=win_height; w=win_width; p=win_bits;
+			img=&win_pages;
 		}
 		if (state->scoreOther>=SCORE_MAX && state->scoreOther>=state->scoreSelf+SCORE_MINDIFF) {
-			h=lose_height; w=lose_width; p=lose_bits;
+			img=&lose_pages;
 		}
-		if (p) {
+		if (img) {
 		  dbgf2(b2DEBUG_SCORE, "Game ended: %d vs %d\n", state->scoreSelf, state->scoreOther);
-			// display the icon
-			display.clear();
-			display.drawXbm((SCREEN_WIDTH - w)/2, (SCREEN_HEIGHT - h)/2, w, h, p);
-			display.display();
-			// wait a fixed amount of time (because touch will be still on when we get here: player will still be controlling the paddle)
-			delay(3000);
-			// wait for touch
-			uint16_t t1, t2, i;
-			do {
-				t1=0; i=0;
-				do {
-					t1=std::max(touchRead(TOUCHPIN_UP), t1);
-					i++;
-					dbgf(b2DEBUG_SCORE, "touch1: %d;", t1);
-				} while (t1<10 || i<5); // below 10 its measurement error, we measure the maximum of 5 measurements
-				t2=0; i=0;
-				do {
-					t2=std::max(touchRead(TOUCHPIN_DOWN), t2);
-					i++;
-					dbgf(b2DEBUG_SCORE, "touch2: %d;", t2);
-				} while (t2<10 || i<5); // below 10 its measurement error, we use the maximum of 5 measurements
-				dbgf3(b2DEBUG_SCORE, "touch1: %d; touch2: %d; sensi: %d\n", t1, t2, TOUCH_SENSITIVITY);
-				delay(1);
-			} while (t1>TOUCH_SENSITIVITY && t2>TOUCH_SENSITIVITY);
-			state->scoreSelf=0;
-			state->scoreOther=0;
+			gameLost=img==&lose_pages;
+			drawGameOver();
+			scoreDetectTime=0; // the next serve waits for the players, it is not timed
+			setPhase(PHASE_GAMEOVER);
+			return;
 		}
 		// restart game
 		initRound(scoring<0);
 	}
 }
 
+// frames up to otherConfirmed can not be rolled back anymore, each one is streamed once
+void publishSpectators() {
+	uint32_t last = std::min(otherConfirmed, curState()->frameID);
+	for (; spectatorNext<=last; spectatorNext++) {
+		PongGameState *confirmed = getStateWithID(spectatorNext);
+		if (confirmed) spectatorPublish(confirmed);
+	}
+	spectatorService();
+}
+
+EspPacerClock pacerClock;
+FramePacer<EspPacerClock, FRAME_TIME> pacer(pacerClock);
+
 void setup()
 {
 	// init board
 	dbgstart();
+	allocTrackTask();
+	metricsInit();
+	#ifdef b2BENCHMARK
+	  runBenchmarks();
+	#endif
+	#ifdef b2TOURNAMENT
+	  runTournament();
+	#endif
 	display.init();
+	initSprites();
+	initAI(&ai);
   isServer = ((uint32_t)ESP.getEfuseMac())==SERVERID;
 	// init network and bail out if connection fails
 	isNetworked=networkInit();
+	matchSeed=isNetworked?getMatchSeed():esp_random();
+	seedAI(&ai, matchSeed);
+	#ifndef b2SERIAL // spectators join the access point, there is none on a cable
+	  if (isNetworked && isServer) spectatorInit();
+	#endif
 	// init game
 	initRound(false);
+	pacerClock.begin();
+	pacer.start();
 }
 
-void loop()
-{
-	uint32_t st = micros();
+void playFrame() {
 	// get the state
 	PongGameState* previousState=curState();
 	// draw the latest gamestate on the display
   drawFrame(previousState); 
+	traceDrawn(); // the other side's changes rolled in last frame are on the screen now
 	// create a new gamestate
 	PongGameState* state=copyLatestState();
 	// get the controls >>modifies dirSelf
 	getControls(state); 
+	inputTime=micros();
 	// get the opponents move (and send ours) >>modifies dirOther
-	if (isNetworked) commNetwork(state, previousState); // if we got message from network for old frames we also recalculate from there
-	else calcAI(state, previousState);
+	bool inReach = true;
+	if (isNetworked) inReach = commNetwork(state, previousState); // if we got message from network for old frames we also recalculate from there
+	else calcAI<Arena>(&ai, state, previousState);
 	// recalculate the frame >>moves paddles and ball
-	recalcFrame(state, previousState);
+	recalcFrame<Arena>(state, previousState);
+	if (!inReach) {
+		linkLost(); // the resume starts from this frame
+		return;
+	}
 	// check the scoring state (and communicate to network opponent)
 	checkScore(state);
+	// stream the states that can not be rolled back anymore to the spectators
+	#ifndef b2SERIAL
+	  if (isNetworked && isServer) publishSpectators();
+	#endif
+}
+
+void loop()
+{
+	uint32_t st = micros();
+	allocFrameStart();
+	// the link is watched (and kept alive) in every phase, the peer may be in another one
+	if (isNetworked && phase!=PHASE_RESUME) {
+		if (linkAlive()) keepLinkAlive();
+		else linkLost();
+	}
+	switch (phase) {
+		case PHASE_SERVE: serveRound(); break;
+		case PHASE_PLAY: playFrame(); break;
+		case PHASE_GAMEOVER: gameOver(); break;
+		case PHASE_RESUME: resumeSession(); break;
+	}
+	metricsService(); // a requested snapshot goes out a bit every frame
 	uint32_t elapsed = micros() - st;
 	#ifdef b2DEBUG_FPS 
-	  display.setFont(ArialMT_Plain_10);
-	  display.setTextAlignment(TEXT_ALIGN_LEFT);
-	  display.drawString(0,0,String(1000000/elapsed)); // display fps
+	  drawNumber(0,0,1000000/elapsed,false); // display fps
 	  display.display();
 	  elapsed = micros() - st;
 	#endif
-	if (FRAME_TIME > elapsed) // we are over our frame time -> no wait
-    delayMicroseconds(FRAME_TIME-elapsed); // wait until frame should end
+	allocFrameCheck(); // in steady state the frame must not touch the heap
+	metrics.frames++;
+	if (elapsed > FRAME_TIME) {
+		metrics.overruns++;
+		metricsMax(&metrics.overrunMaxUs, elapsed-FRAME_TIME);
+	}
+	#ifdef b2LIGHTSLEEP
+	  pacerClock.lightSleep = !isNetworked; // light sleep would drop the WiFi link
+	#endif
+	pacer.wait(); // sleep until the frame should end
+	const PacerStats *ps = pacer.getStats();
+	metrics.idleMs = ps->idleUs/1000;
+	metrics.sleptMs = ps->sleptUs/1000;
+	metrics.jitterMaxUs = ps->jitterMaxUs;
+	metrics.lateWakes = ps->lateWakes;
 }
\ No newline at end of file
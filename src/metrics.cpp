@@ -0,0 +1,83 @@
+#include "metrics.h"
+#include "b2debug.h"
+
+#define METRICS_TEXT_SIZE 1792 // the latency histograms are the longer one
+
+PongMetrics metrics;
+
+const char *metricsNames[METRICS_COUNT] = {
+  "frames", "overruns", "overrun_max_us",
+  "rollbacks", "rollback_frames", "rollback_max",
+  "late_msgs", "future_msgs", "future_max", "future_dropped",
+  "tx_bytes", "tx_msgs", "rx_bytes", "rx_msgs",
+  "scores", "score_timeouts", "score_us", "score_max_us",
+  "links_lost", "resumes", "fallbacks",
+  "idle_ms", "slept_ms", "jitter_max_us", "late_wakes",
+  "send_latency_us", "recv_latency_us", "rx_bad_frames",
+  "pred_frames", "pred_misses",
+  "serves", "serve_us", "serve_max_us",
+  "tx_resent_frames"
+};
+
+uint32_t latencyHist[LAT_STAGES][LATENCY_BUCKETS];
+
+const char *latencyNames[LAT_STAGES] = { "send", "wire", "queue", "apply", "draw", "total" };
+
+// the snapshot being written to serial
+char metricsText[METRICS_TEXT_SIZE];
+uint16_t metricsTextLen = 0;
+uint16_t metricsTextSent = 0;
+
+void metricsInit() {
+  memset(&metrics, 0, sizeof(PongMetrics));
+  memset(latencyHist, 0, sizeof(latencyHist));
+  Serial.begin(115200); // requests come in on serial even without debug output
+}
+
+uint32_t encodeMetrics(uint8_t *buf) {
+  const uint32_t *counters = (const uint32_t *)&metrics;
+  memcpy(buf, "FLGMET", 6);
+  buf[6] = METRICS_VERSION;
+  buf[7] = METRICS_COUNT;
+  for (uint32_t i=0; i<METRICS_COUNT; i++) {
+    uint32_t v = counters[i];
+    buf[8+i*4] = v; buf[9+i*4] = v>>8; buf[10+i*4] = v>>16; buf[11+i*4] = v>>24;
+  }
+  return METRICS_WIRE_SIZE;
+}
+
+static void snapshotText() { // one line of name=value pairs
+  const uint32_t *counters = (const uint32_t *)&metrics;
+  int len = snprintf(metricsText, METRICS_TEXT_SIZE, "metrics v%d", METRICS_VERSION);
+  for (uint32_t i=0; i<METRICS_COUNT && len<METRICS_TEXT_SIZE; i++)
+    len += snprintf(metricsText+len, METRICS_TEXT_SIZE-len, " %s=%u", metricsNames[i], counters[i]);
+  if (len<METRICS_TEXT_SIZE-1) metricsText[len++] = '\n';
+  metricsTextLen = std::min(len, METRICS_TEXT_SIZE-1);
+  metricsTextSent = 0;
+}
+
+static void latencyText() { // one line, the bucket counts of each stage separated by commas
+  int len = snprintf(metricsText, METRICS_TEXT_SIZE, "latency v%d", LATENCY_VERSION);
+  for (uint32_t i=0; i<LAT_STAGES && len<METRICS_TEXT_SIZE; i++) {
+    len += snprintf(metricsText+len, METRICS_TEXT_SIZE-len, " %s=", latencyNames[i]);
+    for (uint32_t b=0; b<LATENCY_BUCKETS && len<METRICS_TEXT_SIZE; b++)
+      len += snprintf(metricsText+len, METRICS_TEXT_SIZE-len, b ? ",%u" : "%u", latencyHist[i][b]);
+  }
+  if (len<METRICS_TEXT_SIZE-1) metricsText[len++] = '\n';
+  metricsTextLen = std::min(len, METRICS_TEXT_SIZE-1);
+  metricsTextSent = 0;
+}
+
+void metricsService() {
+  while (Serial.available()>0) {
+    int req = Serial.read();
+    if (metricsTextSent!=metricsTextLen) continue; // one at a time
+    if (req==METRICS_REQUEST) snapshotText();
+    else if (req==LATENCY_REQUEST) latencyText();
+  }
+  // only what fits into the transmit buffer, the rest goes out with the next frames
+  if (metricsTextSent<metricsTextLen) {
+    int room = Serial.availableForWrite();
+    if (room>0) metricsTextSent += Serial.write((const uint8_t *)metricsText+metricsTextSent, std::min(room, metricsTextLen-metricsTextSent));
+  }
+}
@@ -0,0 +1,97 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <Arduino.h>
+
+/**********
+** Netcode health counters
+**   always on and cheap: plain increments, every counter has a single writer (the receive
+**   task owns the rx ones, the game loop all the others); a snapshot is taken on request
+**   and trickled out over serial without ever blocking the frame
+***********/
+#define METRICS_VERSION 1 // new counters are only ever appended
+#define METRICS_REQUEST 'M' // sent on serial or on a spectator socket to get a snapshot
+
+struct PongMetrics {
+  uint32_t frames;
+  uint32_t overruns; // frames longer than FRAME_TIME
+  uint32_t overrunMaxUs; // how much the worst one was over
+  uint32_t rollbacks;
+  uint32_t rollbackFrames; // sum of the rollback depths
+  uint32_t rollbackMax;
+  uint32_t lateMsgs; // direction changes for frames already out of the history
+  uint32_t futureMsgs; // direction changes buffered for frames we have not reached yet
+  uint32_t futureMax;
+  uint32_t futureDropped; // ... that did not fit: the other board got out of reach, the session is resumed
+  uint32_t txBytes;
+  uint32_t txMsgs;
+  uint32_t rxBytes;
+  uint32_t rxMsgs;
+  uint32_t scores; // score handshakes decided by the server
+  uint32_t scoreTimeouts; // ... without the client's acknowledge
+  uint32_t scoreUs; // sum of goal line to decision times
+  uint32_t scoreMaxUs;
+  uint32_t linksLost;
+  uint32_t resumes; // restarts avoided
+  uint32_t fallbacks; // restarts taken (the session could not be resumed)
+  uint32_t idleMs; // time between the frames, divide by frames*FRAME_TIME for the idle fraction
+  uint32_t sleptMs; // ... of which the core slept
+  uint32_t jitterMaxUs; // worst frame start after its tick
+  uint32_t lateWakes; // sleeps that woke after the tick
+  uint32_t sendLatencyUs; // calibrated at connect, over WiFi or the cable
+  uint32_t recvLatencyUs;
+  uint32_t rxBadFrames; // damaged frames dropped by the cable link
+  uint32_t predFrames; // frames of the other paddle a message confirmed
+  uint32_t predMisses; // ... that were played with another direction when they were made
+  uint32_t serves; // rounds the server started after a goal (not the first of a match)
+  uint32_t serveUs; // sum of goal line to serve times
+  uint32_t serveMaxUs;
+  uint32_t txResentFrames; // frames the cable link sent again for a missing acknowledge (counted by the receiving side)
+};
+typedef struct PongMetrics PongMetrics;
+#define METRICS_COUNT (sizeof(PongMetrics)/sizeof(uint32_t))
+#define METRICS_WIRE_SIZE (6+2+METRICS_COUNT*4) // "FLGMET", version, count, little endian counters
+
+extern PongMetrics metrics;
+
+inline void metricsMax(uint32_t *max, uint32_t value) { if (value>*max) *max=value; }
+
+inline void metricsRollback(uint32_t depth) {
+  metrics.rollbacks++;
+  metrics.rollbackFrames+=depth;
+  metricsMax(&metrics.rollbackMax, depth);
+}
+
+/**********
+** Input latency histograms
+**   a direction change is stamped when the touch is read and followed to the frame the other
+**   board draws it in; times of the sender are moved onto our clock with the offset measured
+**   at connect (getClockOffset), crystal drift skews it by a few us per second of the session;
+**   log2 buckets of us, bucket 0 takes everything below 1 us (also a negative, skewed wire time)
+***********/
+#define LATENCY_VERSION 1
+#define LATENCY_REQUEST 'L' // sent on serial to get the histograms
+#define LATENCY_BUCKETS 24 // the last one takes everything from 4.2 s on
+
+enum PongLatencyStage {
+  LAT_SEND, // touch read to message written (sender's clock)
+  LAT_WIRE, // written to decoded by the receive task
+  LAT_QUEUE, // decoded to taken by the game loop
+  LAT_APPLY, // taken to rolled back into the history
+  LAT_DRAW, // rolled back to drawn
+  LAT_TOTAL, // touch read to drawn on the other board
+  LAT_STAGES
+};
+
+extern uint32_t latencyHist[LAT_STAGES][LATENCY_BUCKETS];
+
+inline void latencyRecord(uint8_t stage, int32_t us) {
+  uint8_t bucket = us<1 ? 0 : std::min(32-__builtin_clz((uint32_t)us), LATENCY_BUCKETS-1);
+  latencyHist[stage][bucket]++;
+}
+
+void metricsInit();
+uint32_t encodeMetrics(uint8_t *buf); // returns the bytes written (METRICS_WIRE_SIZE)
+void metricsService(); // answers serial requests (metrics and latency), call once a frame
+
+#endif //__METRICS_H__
@@ -7,9 +7,25 @@
 extern SSD1306  display;
 #include <WiFi.h>
 #include <WiFiClient.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "spscqueue.h"
+#include "wire.h"
+#include <esp_system.h>
+#include "metrics.h"
+#ifdef b2SERIAL
+#include "seriallink.h"
+#include "serialframe.h"
+#endif
 
 #define PORT 5263
 #define CALIBRATION_COUNT 20
+#define RECEIVER_CORE 0 // the Arduino loop runs on core 1
+#define RECEIVER_STACK 4096
+#define RXBUF_SIZE 32 // fits the longest message (14 bytes) with some spare
+#define TXBUF_SIZE 160 // fits the longest write (a metrics snapshot or a resume: 6+25+1+1+99 bytes)
+#define LINK_READ_TIMEOUT 1000 // ms to wait for the rest of a handshake message
+#define HELLO_INTERVAL 100 // ms between the hellos of the server on a cable
 
 extern bool isServer;
 
@@ -22,15 +38,166 @@ const char* CMD_CHGDIR="C";
 const char* CMD_POTENTIALSCORE="P";
 const char* CMD_POTENTIALSCOREACK="Q";
 const char* CMD_FINALSCORE="F";
+const char* CMD_ROUND="R";
+const char* CMD_KEEPALIVE="K";
+const char* CMD_READY="Y";
+const char* CMD_SESSION="SESSION";
+const char* CMD_RESUME="RESUME";
+const char* CMD_HELLO="HELLO";
 
 WiFiServer srv(PORT);
 WiFiClient clnt;
 
+/**********
+** Link
+**   the byte stream under the protocol: the TCP socket, or the UART with b2SERIAL;
+**   a message is collected and written at once, as one TCP segment or one UART frame
+***********/
+#ifdef b2SERIAL
+static_assert(TXBUF_SIZE<=FRAME_MAX_PAYLOAD, "a write has to fit into a frame");
+static inline bool linkConnected() { return true; } // a cable can not tell, the receive timeout does
+static inline int linkAvailable() { return serialLinkAvailable(); }
+static inline int linkRead(uint8_t *buf, size_t len) { return serialLinkRead(buf, len); }
+static inline size_t linkWrite(const uint8_t *buf, size_t len) { return serialLinkWrite(buf, len); }
+static inline void linkStop() { serialLinkReset(); }
+#else
+static inline bool linkConnected() { return clnt.connected(); }
+static inline int linkAvailable() { return clnt.available(); }
+static inline int linkRead(uint8_t *buf, size_t len) { return clnt.read(buf, len); }
+static inline size_t linkWrite(const uint8_t *buf, size_t len) { return clnt.write(buf, len); }
+static inline void linkStop() { clnt.stop(); }
+#endif
+
+static bool linkReadBytes(uint8_t *buf, uint32_t len) { // for the handshakes, the receive task is not running
+  uint32_t got=0, start=millis();
+  while (got<len) {
+    if (millis()-start>LINK_READ_TIMEOUT) return false;
+    if (linkAvailable()>0) got+=linkRead(buf+got, len-got);
+  }
+  return true;
+}
+
+// every byte we send goes through these, for the metrics
+uint8_t txBuf[TXBUF_SIZE];
+uint32_t txLen = 0;
+uint32_t lastTxMillis = 0;
+
+static void txFlush() { // ends a message
+  if (!txLen) return;
+  metrics.txBytes+=linkWrite(txBuf, txLen);
+  txLen=0;
+  lastTxMillis=millis();
+}
+
+static void txWrite(const char *buf, size_t len) {
+  if (txLen+len>TXBUF_SIZE) txFlush();
+  memcpy(txBuf+txLen, buf, len);
+  txLen+=len;
+}
+
+static inline void txHeader(const char *cmd) { // starts a message
+  txFlush();
+  metrics.txMsgs++;
+  txWrite(cmd, strlen(cmd));
+}
+
 uint32_t sendingLatency;
 uint32_t receivingLatency;
+int32_t clockOffset;
+
+SPSCQueue<PongNetMsg, NETMSG_QUEUE_SIZE> rxQueue;
+TaskHandle_t rxTask = NULL;
+std::atomic<bool> rxPause(false); // asked by the game loop, while set the task does not touch the socket
+std::atomic<bool> rxPaused(false); // confirmed by the task
+std::atomic<uint32_t> lastRxMillis(0);
+std::atomic<bool> metricsAsked(false); // set by the receive task, answered by the game loop (it owns the writes)
 
+uint32_t sessionID; // picked by the server at connect, a reconnecting client has to present it
+
+// half of the average roundtrip of the pings, without the fastest and the slowest one;
+// the answers carry the responder's clock, the requester takes the clock offset from the
+// fastest ping (the least likely to have waited on one side)
+static uint32_t calibrate(bool requester, const char *role) {
+  uint32_t roundtime[CALIBRATION_COUNT], latency=0;
+  uint32_t minLatency = -1; // max unsigned int
+  uint32_t maxLatency = 0; // min unsigned int
+  for (int i=0; i<CALIBRATION_COUNT; i++) {
+    uint32_t start=micros(), remote=0;
+    if (requester) {
+      sendMsg("CALIBREQU");
+      waitMsg("CALIBRESP", CONNECT_TIMEOUT);
+      linkReadBytes((uint8_t *)&remote, sizeof(remote));
+    } else {
+      waitMsg("CALIBREQU", CONNECT_TIMEOUT);
+      txHeader("CALIBRESP");
+      remote=micros();
+      txWrite((const char *)&remote, sizeof(remote));
+      txFlush();
+    }
+    roundtime[i]=micros()-start;
+    if (requester && roundtime[i]<minLatency) clockOffset=(int32_t)(remote-(start+roundtime[i]/2));
+    minLatency = std::min(minLatency, roundtime[i]); // calc the lowest (to drop later from average)
+    maxLatency = std::max(maxLatency, roundtime[i]); // calc the highest (to drop later from average)
+    dbgf2(b2DEBUG_WIFI, "\tRoundtime[%d]: %d\n", i, roundtime[i]);
+    displayMsg(role, "Calibrating latency", String(i).c_str());
+  }
+  for (int i=0; i<CALIBRATION_COUNT; i++)
+    if (roundtime[i] != minLatency && roundtime[i] != maxLatency)
+      latency+=roundtime[i];
+  if (requester) sendMsg("CALIBDONE");
+  else waitMsg("CALIBDONE", CONNECT_TIMEOUT);
+  return latency/((CALIBRATION_COUNT-2)*2);
+}
+
+// calibrates the latency both ways and agrees on the session, the same over every link
+static void startSession(const char *role) {
+  if (isServer) {
+    sendingLatency=calibrate(true, role);
+    receivingLatency=calibrate(false, role);
+    sessionID=esp_random();
+    txHeader(CMD_SESSION);
+    txWrite((const char *)&sessionID, sizeof(sessionID));
+    txFlush();
+  } else {
+    receivingLatency=calibrate(false, role);
+    sendingLatency=calibrate(true, role);
+    waitMsg(CMD_SESSION, CONNECT_TIMEOUT);
+    linkReadBytes((uint8_t *)&sessionID, sizeof(sessionID));
+    dbgf(b2DEBUG_WIFI, "Session: %u\n", sessionID);
+  }
+  dbgf3(b2DEBUG_WIFI, "Calibration done, sending latency: %d, receiving latency: %d, clock offset: %d\n", sendingLatency, receivingLatency, clockOffset);
+  metrics.sendLatencyUs=sendingLatency;
+  metrics.recvLatencyUs=receivingLatency;
+  startReceiver();
+}
+
+#ifdef b2SERIAL
+bool networkInit() {
+  const char *role = isServer ? "SERVER on cable" : "CLIENT on cable";
+  serialLinkBegin();
+  displayMsg(role, "Waiting for the other board");
+  // the boards are powered up in any order: the server says hello until the client answers
+  bool found=false;
+  uint32_t start=millis();
+  while (!found && millis()-start<CONNECT_TIMEOUT) {
+    if (isServer) {
+      sendMsg(CMD_HELLO);
+      found=waitMsg(CMD_HELLO, HELLO_INTERVAL);
+    } else if ((found=waitMsg(CMD_HELLO, CONNECT_TIMEOUT))) {
+      sendMsg(CMD_HELLO);
+    }
+  }
+  if (!found) {
+    dbgln(b2DEBUG_WIFI, "No board on the cable, fallback to local game");
+    displayMsg(role, "No board on the cable", "Fallback to local game");
+    delay(1000);
+    return false;
+  }
+  startSession(role);
+  return true;
+}
+#else
 bool networkInit() {
-  uint32_t roundtime[CALIBRATION_COUNT], minLatency, maxLatency;
   if (isServer) {
     /************
     ** Server side connection code
@@ -55,44 +222,7 @@ bool networkInit() {
         dbg(b2DEBUG_WIFI, "Client connected from IP: ");
         dbgln(b2DEBUG_WIFI, clnt.remoteIP());
         displayMsg("Acting as SERVER", "Client connected, IP:", clnt.remoteIP().toString().c_str());
-        // calibrate latency
-        sendingLatency=0; 
-        minLatency = -1; // max unsigned int
-        maxLatency = 0; // min unsigned int
-        for (int i=0; i<CALIBRATION_COUNT; i++) {
-          roundtime[i]=micros();
-          sendMsg("CALIBREQU");
-          waitMsg("CALIBRESP", CONNECT_TIMEOUT);
-          roundtime[i]=micros()-roundtime[i];
-          minLatency = std::min(minLatency, roundtime[i]); // calc the lowest (to drop later from average)
-          maxLatency = std::max(maxLatency, roundtime[i]); // calc the highest (to drop later from average)
-          dbgf2(b2DEBUG_WIFI, "\tRoundtime[%d]: %d\n", i, roundtime[i]);
-          displayMsg("Acting as SERVER", "Calibrating latency", String(i).c_str());
-        }
-        for (int i=0; i<CALIBRATION_COUNT; i++)
-          if (roundtime[i] != minLatency && roundtime[i] != maxLatency)
-            sendingLatency+=roundtime[i];
-        sendingLatency/=(CALIBRATION_COUNT-2)*2; // half of the average roundtrip
-        sendMsg("CALIBDONE");
-        receivingLatency=0;
-        minLatency = -1; // max unsigned int
-        maxLatency = 0; // min unsigned int
-        for (int i=0; i<CALIBRATION_COUNT; i++) {
-          roundtime[i]=micros();
-          waitMsg("CALIBREQU", CONNECT_TIMEOUT);
-          sendMsg("CALIBRESP");
-          roundtime[i]=micros()-roundtime[i];
-          minLatency = std::min(minLatency, roundtime[i]); // calc the lowest (to drop later from average)
-          maxLatency = std::max(maxLatency, roundtime[i]); // calc the highest (to drop later from average)
-          dbgf2(b2DEBUG_WIFI, "\tRoundtime[%d]: %d\n", i, roundtime[i]);
-          displayMsg("Acting as SERVER", "Calibrating latency", String(i).c_str());
-        }
-        for (int i=0; i<CALIBRATION_COUNT; i++)
-          if (roundtime[i] != minLatency && roundtime[i] != maxLatency)
-            receivingLatency+=roundtime[i];
-        receivingLatency/=(CALIBRATION_COUNT-2)*2; // half of the average roundtrip
-        waitMsg("CALIBDONE", CONNECT_TIMEOUT);
-        dbgf2(b2DEBUG_WIFI, "Calibration done, sending latency: %d, receiving latency: %d", sendingLatency, receivingLatency);
+        startSession("Acting as SERVER");
       } else {
         dbgln(b2DEBUG_WIFI, "No client connection, fallback to local game");
         displayMsg("Acting as SERVER", "Fallback to local game");
@@ -136,43 +266,7 @@ bool networkInit() {
       if (clnt.connected()) {
         dbgln(b2DEBUG_WIFI, "Connected, calibrating latency");
         displayMsg("Acting as CLIENT", "Connected, calibrating latency");
-        receivingLatency=0;
-        minLatency = -1; // max unsigned int
-        maxLatency = 0; // min unsigned int
-        for (int i=0; i<CALIBRATION_COUNT; i++) {
-          roundtime[i]=micros();
-          waitMsg("CALIBREQU", CONNECT_TIMEOUT);
-          sendMsg("CALIBRESP");
-          roundtime[i]=micros()-roundtime[i];
-          minLatency = std::min(minLatency, roundtime[i]); // calc the lowest (to drop later from average)
-          maxLatency = std::max(maxLatency, roundtime[i]); // calc the highest (to drop later from average)
-          dbgf2(b2DEBUG_WIFI, "\tRoundtime[%d]: %d\n", i, roundtime[i]);
-          displayMsg("Acting as CLIENT", "Calibrating latency", String(i).c_str());
-        }
-        for (int i=0; i<CALIBRATION_COUNT; i++)
-          if (roundtime[i] != minLatency && roundtime[i] != maxLatency)
-            receivingLatency+=roundtime[i];
-        receivingLatency/=(CALIBRATION_COUNT-2)*2; // half of the average roundtrip
-        waitMsg("CALIBDONE", CONNECT_TIMEOUT);
-        sendingLatency=0;
-        minLatency = -1; // max unsigned int
-        maxLatency = 0; // min unsigned int
-        for (int i=0; i<CALIBRATION_COUNT; i++) {
-          roundtime[i]=micros();
-          sendMsg("CALIBREQU");
-          waitMsg("CALIBRESP", CONNECT_TIMEOUT);
-          roundtime[i]=micros()-roundtime[i];
-          minLatency = std::min(minLatency, roundtime[i]); // calc the lowest (to drop later from average)
-          maxLatency = std::max(maxLatency, roundtime[i]); // calc the highest (to drop later from average)
-          dbgf2(b2DEBUG_WIFI, "\tRoundtime[%d]: %d\n", i, roundtime[i]);
-          displayMsg("Acting as CLIENT", "Calibrating latency", String(i).c_str());
-        }
-        for (int i=0; i<CALIBRATION_COUNT; i++)
-          if (roundtime[i] != minLatency && roundtime[i] != maxLatency)
-            sendingLatency+=roundtime[i];
-        sendingLatency/=(CALIBRATION_COUNT-2)*2; // half of the average roundtrip
-        sendMsg("CALIBDONE");
-        dbgf2(b2DEBUG_WIFI, "Calibration done, sending latency: %d, receiving latency: %d", sendingLatency, receivingLatency);
+        startSession("Acting as CLIENT");
       } else {
         dbgln(b2DEBUG_WIFI, "Connection timed out, fallback to local game");
         displayMsg("Acting as CLIENT", "Connection timeout, fallback to local");
@@ -192,10 +286,14 @@ bool networkInit() {
   }
   return true;
 }
+#endif
 
 uint32_t getSendingLatency() { return sendingLatency; }
+uint32_t getMatchSeed() { return sessionID; }
 uint32_t getReceivingLatency() { return receivingLatency; }
 
+int32_t getClockOffset() { return clockOffset; }
+
 void displayMsg(const char *line1, const char *line2, const char *line3) {
   display.clear();
   display.setFont(ArialMT_Plain_10);
@@ -206,14 +304,235 @@ void displayMsg(const char *line1, const char *line2, const char *line3) {
   display.display();
 }
 
+/**********
+** Session resume
+**   instead of rebooting on a dead connection the client reconnects and presents the session,
+**   the server answers with a confirmed state and the inputs since then, and whether it is
+**   in a round at all; the receive task is paused meanwhile and the handshake reads the link
+**   directly
+***********/
+bool linkAlive() {
+  return linkConnected() && millis()-lastRxMillis<LINK_TIMEOUT;
+}
+
+static_assert(METRICS_WIRE_SIZE<=TXBUF_SIZE, "a metrics snapshot has to fit into one write");
+
+void refreshLink() {
+  lastRxMillis=millis();
+}
+
+void keepLinkAlive() { // while playing the direction keepalives come first
+  if (metricsAsked) { // the same FLGMET frame a spectator gets, a board never asks its peer
+    static uint8_t buf[METRICS_WIRE_SIZE];
+    metricsAsked=false;
+    txFlush();
+    metrics.txMsgs++;
+    txWrite((const char *)buf, encodeMetrics(buf));
+    txFlush();
+  }
+  if (millis()-lastTxMillis<KEEPALIVE_INTERVAL) return;
+  txHeader(CMD_KEEPALIVE);
+  txFlush();
+}
+
+void dropLink() {
+  pauseReceiver();
+  linkStop();
+}
+
+bool reconnect() { // client, one attempt
+#ifndef b2SERIAL
+  if (WiFi.status()!=WL_CONNECTED) return false; // the station reconnects to the access point by itself
+  if (!clnt.connect(host, PORT)) return false;
+  clnt.setNoDelay(true);
+#endif
+  txHeader(CMD_RESUME);
+  txWrite((const char *)&sessionID, sizeof(sessionID));
+  txFlush();
+  return true;
+}
+
+bool acceptReconnect() { // server, non-blocking unless a client shows up
+#ifdef b2SERIAL
+  if (linkAvailable()<=0) return false; // the client speaks first
+#else
+  WiFiClient c=srv.available();
+  if (!c) return false;
+  clnt=c;
+  clnt.setNoDelay(true);
+#endif
+  uint32_t id=0;
+  if (!waitMsg(CMD_RESUME, RESUME_TIMEOUT) || !linkReadBytes((uint8_t *)&id, sizeof(id)) || id!=sessionID) {
+    dbgf(b2DEBUG_WIFI, "Rejecting connection with session %u\n", id);
+    linkStop();
+    return false;
+  }
+  return true;
+}
+
+void sendResume(PongGameState *state, uint8_t count, const uint8_t *inputs, bool playing) {
+  txHeader(CMD_RESUME);
+  uint8_t round=playing;
+  txWrite((const char *)&round, sizeof(round));
+  uint8_t buf[WIRE_GAMESTATE_SIZE];
+  encodeGameState(buf, state);
+  txWrite((const char *)buf, WIRE_GAMESTATE_SIZE);
+  txWrite((const char *)&count, sizeof(count));
+  txWrite((const char *)inputs, count);
+  txFlush();
+  dbgf2(b2DEBUG_WIFI, "Resume sent from frame %d with %d inputs\n", state->frameID, count);
+  resumeReceiver();
+}
+
+bool waitResume(PongGameState *state, uint8_t *count, uint8_t *inputs, bool *playing) { // client
+  if (!waitMsg(CMD_RESUME, RESUME_TIMEOUT)) return false;
+  uint8_t round;
+  if (!linkReadBytes(&round, 1)) return false;
+  *playing=round!=0;
+  uint8_t buf[WIRE_GAMESTATE_SIZE];
+  if (!linkReadBytes(buf, WIRE_GAMESTATE_SIZE)) return false;
+  PongGameStateView view(buf);
+  if (!view.valid()) return false;
+  view.decode(state);
+  if (!linkReadBytes(count, 1) || *count>=GAMESTATE_BUFFER_SIZE) return false;
+  if (!linkReadBytes(inputs, *count)) return false;
+  dbgf2(b2DEBUG_WIFI, "Resume received from frame %d with %d inputs\n", state->frameID, *count);
+  resumeReceiver();
+  return true;
+}
+
 void sendMsg(const char *msg) {
-  dbg(b2DEBUG_WIFI, ("Sending message '"+String(msg)+"'. ").c_str());
-  clnt.write_P(msg, strlen(msg));
+  dbgf(b2DEBUG_WIFI, "Sending message '%s'. ", msg);
+  txHeader(msg);
+  txFlush();
   dbgln(b2DEBUG_WIFI, "Message sent.");
 }
 
+/**********
+** Receive task
+**   runs on the other core, reads the socket and decodes the messages into rxQueue
+**   so the game loop only has to drain already decoded messages
+***********/
+uint8_t rxBuf[RXBUF_SIZE];
+uint32_t rxLen = 0;
+
+int32_t decodeNetMsg(const uint8_t *buf, uint32_t len, PongNetMsg *msg) {
+  uint32_t need;
+  switch (buf[0]) {
+    case 'C': // CMD_CHGDIR
+      need=1+sizeof(uint32_t)+sizeof(int8_t)+sizeof(uint32_t)*2;
+      if (len<need) return 0;
+      msg->type=MSG_DIRCHG;
+      memcpy(&msg->data.dirChg.frameID, buf+1, sizeof(uint32_t));
+      msg->data.dirChg.direction=(int8_t)buf[5];
+      memcpy(&msg->data.dirChg.captureTime, buf+6, sizeof(uint32_t));
+      memcpy(&msg->data.dirChg.sendTime, buf+10, sizeof(uint32_t));
+      return need;
+    case 'P': // CMD_POTENTIALSCORE
+    case 'Q': // CMD_POTENTIALSCOREACK
+      need=1+sizeof(uint32_t)*3;
+      if (len<need) return 0;
+      msg->type=(buf[0]=='P')?MSG_POTENTIALSCORE:MSG_POTENTIALSCOREACK;
+      memcpy(&msg->data.score, buf+1, sizeof(uint32_t)*3);
+      return need;
+    case 'F': // CMD_FINALSCORE
+      need=1+sizeof(uint32_t)+sizeof(int8_t);
+      if (len<need) return 0;
+      msg->type=MSG_FINALSCORE;
+      memcpy(&msg->data.finalScore.frameID, buf+1, sizeof(uint32_t));
+      msg->data.finalScore.scoring=(int8_t)buf[5];
+      return need;
+    case 'R': // CMD_ROUND
+      need=1+sizeof(uint32_t)+3;
+      if (len<need) return 0;
+      msg->type=MSG_ROUND;
+      memcpy(&msg->data.round.round, buf+1, sizeof(uint32_t));
+      msg->data.round.scoreSelf=buf[5];
+      msg->data.round.scoreOther=buf[6];
+      msg->data.round.lost=buf[7];
+      return need;
+    case 'Y': // CMD_READY
+      msg->type=MSG_READY;
+      return 1;
+    case 'K': // CMD_KEEPALIVE
+      msg->type=MSG_KEEPALIVE;
+      return 1;
+    case METRICS_REQUEST:
+      msg->type=MSG_METRICSREQ;
+      return 1;
+    default:
+      return -1;
+  }
+}
+
+static void receiverTask(void *param) {
+  PongNetMsg msg;
+  for (;;) {
+    if (rxPause) { // the game loop is reconnecting
+      rxPaused=true;
+      vTaskDelay(5);
+      continue;
+    }
+    rxPaused=false;
+    bool idle=true;
+    // read what fits into the buffer
+    int avail=linkAvailable();
+    if (avail>0 && rxLen<RXBUF_SIZE) {
+      int n=linkRead(rxBuf+rxLen, std::min((uint32_t)avail, (uint32_t)(RXBUF_SIZE-rxLen)));
+      if (n>0) { rxLen+=n; idle=false; lastRxMillis=millis(); metrics.rxBytes+=n; }
+    }
+    // decode as many messages as the queue takes (if full, the bytes wait in the socket)
+    while (rxLen>0 && !rxQueue.full()) {
+      int32_t used=decodeNetMsg(rxBuf, rxLen, &msg);
+      if (used==0) break;
+      if (used<0) {
+        dbgf2(b2DEBUG_WIFI, "Dropping %d unexpected bytes starting with %d\n", -used, rxBuf[0]);
+        used=-used; // resync after them
+      } else {
+        msg.rxTime=micros();
+        if (msg.type==MSG_METRICSREQ) metricsAsked=true;
+        else if (msg.type!=MSG_KEEPALIVE) rxQueue.push(msg); // its bytes have refreshed lastRxMillis already
+        metrics.rxMsgs++;
+      }
+      rxLen-=used;
+      memmove(rxBuf, rxBuf+used, rxLen);
+    }
+    if (idle) vTaskDelay(1); // let the WiFi stack breathe
+  }
+}
+
+void startReceiver() {
+  rxLen=0;
+  lastRxMillis=millis();
+  xTaskCreatePinnedToCore(receiverTask, "pongrx", RECEIVER_STACK, NULL, 1, &rxTask, RECEIVER_CORE);
+}
+
+void pauseReceiver() {
+  if (!rxTask) return;
+  rxPaused=false;
+  rxPause=true;
+  while (!rxPaused) delay(1);
+}
+
+void resumeReceiver() { // drops everything of the old connection
+  rxLen=0;
+  while (rxQueue.front()) rxQueue.pop();
+  lastRxMillis=millis();
+  rxPause=false;
+}
+
+static PongNetMsg* peekNetMsg(uint8_t type) {
+  PongNetMsg *msg=rxQueue.front();
+  if (msg && msg->type==type) return msg;
+  return NULL;
+}
+
 bool waitMsg(const char *msg, uint32_t timeout) {
-  dbg(b2DEBUG_WIFI, ("Waiting for message '"+String(msg)+"'. ").c_str());
+  dbgf(b2DEBUG_WIFI, "Waiting for message '%s'. ", msg);
+  if (rxTask && !rxPause) { // the receive task owns the socket, we can not read it from here
+    dbgln(b2DEBUG_WIFI, "The receive task is running.");
+    return false;
+  }
   char buf[10];
   memset(buf, 0, 10);
   uint32_t rbytes=0, size=strlen(msg), start=millis();
@@ -223,10 +542,11 @@ bool waitMsg(const char *msg, uint32_t timeout) {
       dbgln(b2DEBUG_WIFI, "Timed out.");
       return false; // message did not arrive in time
     }
-    if (clnt.available()) {
-      buf[rbytes++]=clnt.read();
+    uint8_t c;
+    if (linkAvailable()>0 && linkRead(&c, 1)==1) {
+      buf[rbytes++]=c;
       if (memcmp(buf, msg, rbytes)!=0) {
-        dbg(b2DEBUG_WIFI, ("Received something else: "+String(buf)).c_str());
+        dbgf(b2DEBUG_WIFI, "Received something else: %s", buf);
         rbytes=0; // if so far does not compare, start over
       }
     }
@@ -235,114 +555,136 @@ bool waitMsg(const char *msg, uint32_t timeout) {
   return true; // if we got here, full size compares good
 }
 
-void sendGameState(PongGameState *state) {
-  dbg(b2DEBUG_WIFI, "Sending game state. ");
-  clnt.write_P(CMD_FULLGAMESTATE, strlen(CMD_FULLGAMESTATE));
-  dbg(b2DEBUG_WIFI, "Header sent. ");
-  clnt.write_P((const char *)state, sizeof(PongGameState));
-  dbgln(b2DEBUG_WIFI, "State sent.");
-}
-
-void waitGameState(PongGameState *state) {
-  dbg(b2DEBUG_WIFI, "Waiting for game state. ");
-  waitMsg(CMD_FULLGAMESTATE);
-  dbg(b2DEBUG_WIFI, "Header received. ");
-  clnt.readBytes((uint8_t *)state, sizeof(PongGameState));
-  dbgln(b2DEBUG_WIFI, "State received.");
+void discardNetMsgs(uint32_t keepMask) { // drops the messages in front that the caller does not expect now
+  PongNetMsg *msg;
+  while ((msg=rxQueue.front()) && !(keepMask & MSGMASK(msg->type))) {
+    dbgf(b2DEBUG_WIFI, "Discarding unexpected message of type %d\n", msg->type);
+    rxQueue.pop();
+  }
 }
 
-void sendDirChg(PongGameState *state) {
+uint32_t sendDirChg(PongGameState *state, uint32_t captureTime) {
   dbg(b2DEBUG_WIFI, "Sending direction change. ");
-  clnt.write_P(CMD_CHGDIR, strlen(CMD_CHGDIR));
+  txHeader(CMD_CHGDIR);
   dbg(b2DEBUG_WIFI, "Header sent. ");
-  clnt.write_P((const char *)&state->frameID, sizeof(state->frameID));
-  clnt.write_P((const char *)&state->dirSelf, sizeof(state->dirSelf));
+  txWrite((const char *)&state->frameID, sizeof(state->frameID));
+  txWrite((const char *)&state->dirSelf, sizeof(state->dirSelf));
+  txWrite((const char *)&captureTime, sizeof(captureTime));
+  uint32_t sendTime=micros();
+  txWrite((const char *)&sendTime, sizeof(sendTime));
+  txFlush();
   dbgf2(b2DEBUG_WIFI, "Direction change sent, frameID: %d, direction: %d\n", state->frameID, state->dirSelf);  
+  return sendTime;
 }
 
-bool acceptDirChg(uint32_t *fid, int8_t *dir) {
-  if (clnt.available()>=strlen(CMD_CHGDIR)+sizeof(uint32_t)+sizeof(uint8_t)) {
-    char c=clnt.peek();
-    if (c==CMD_CHGDIR[0]) { // one byte command to be able to use peek
-      clnt.read(); // pop command from buffer
-      clnt.readBytes((uint8_t*)fid, sizeof(*fid));
-      *dir=clnt.read();
-      dbgf2(b2DEBUG_WIFI, "Direction change received, frameID: %d, direction: %d\n", *fid, *dir);
-      return true;
-    }
-  }
-  return false;
+bool acceptDirChg(uint32_t *fid, int8_t *dir, uint32_t *rxTime, uint32_t *captureTime, uint32_t *sendTime) {
+  PongNetMsg *msg=peekNetMsg(MSG_DIRCHG);
+  if (!msg) return false;
+  *fid=msg->data.dirChg.frameID;
+  *dir=msg->data.dirChg.direction;
+  if (rxTime) *rxTime=msg->rxTime;
+  if (captureTime) *captureTime=msg->data.dirChg.captureTime;
+  if (sendTime) *sendTime=msg->data.dirChg.sendTime;
+  rxQueue.pop();
+  dbgf2(b2DEBUG_WIFI, "Direction change received, frameID: %d, direction: %d\n", *fid, *dir);
+  return true;
 }
 
 void sendPotentialScore(uint32_t frameID, uint32_t lastFrameReceived, uint32_t lastFrameSent) {
   dbg(b2DEBUG_WIFI, "Sending potential score. ");
-  clnt.write_P(CMD_POTENTIALSCORE, strlen(CMD_POTENTIALSCORE));
+  txHeader(CMD_POTENTIALSCORE);
   dbg(b2DEBUG_WIFI, "Header sent. ");
-  clnt.write_P((const char *)&frameID, sizeof(frameID));
-  clnt.write_P((const char *)&lastFrameReceived, sizeof(lastFrameReceived));
-  clnt.write_P((const char *)&lastFrameSent, sizeof(lastFrameSent));
+  txWrite((const char *)&frameID, sizeof(frameID));
+  txWrite((const char *)&lastFrameReceived, sizeof(lastFrameReceived));
+  txWrite((const char *)&lastFrameSent, sizeof(lastFrameSent));
+  txFlush();
   dbgf3(b2DEBUG_WIFI, "Potential score sent (12 bytes). frameids: %d, %d, %d\n", frameID, lastFrameReceived, lastFrameSent);  
 }
 
 bool acceptPotentialScore(uint32_t *frameID, uint32_t *lastFrameHandled, uint32_t *lastFrameShouldReceive) {
-  if (clnt.available()>=strlen(CMD_POTENTIALSCORE)+sizeof(uint32_t)*3) {
-    char c=clnt.peek();
-    if (c==CMD_POTENTIALSCORE[0]) { // one byte command to be able to use peek
-      clnt.read(); // pop command from buffer
-      clnt.readBytes((uint8_t*)frameID, sizeof(*frameID));
-      clnt.readBytes((uint8_t*)lastFrameHandled, sizeof(*lastFrameHandled));
-      clnt.readBytes((uint8_t*)lastFrameShouldReceive, sizeof(*lastFrameShouldReceive));
-      dbgf3(b2DEBUG_WIFI, "Potential score received, frameIDs: %d, %d, %d\n", *frameID, *lastFrameHandled, *lastFrameShouldReceive);
-      return true;
-    }
-  }
-  return false;
+  PongNetMsg *msg=peekNetMsg(MSG_POTENTIALSCORE);
+  if (!msg) return false;
+  *frameID=msg->data.score.frameID;
+  *lastFrameHandled=msg->data.score.lastFrameHandled;
+  *lastFrameShouldReceive=msg->data.score.lastFrameShouldReceive;
+  rxQueue.pop();
+  dbgf3(b2DEBUG_WIFI, "Potential score received, frameIDs: %d, %d, %d\n", *frameID, *lastFrameHandled, *lastFrameShouldReceive);
+  return true;
 }
 
 void sendPotentialScoreAck(uint32_t frameID, uint32_t lastFrameReceived, uint32_t lastFrameSent) {
   dbg(b2DEBUG_WIFI, "Sending potential score acknowledgment. ");
-  clnt.write_P(CMD_POTENTIALSCOREACK, strlen(CMD_POTENTIALSCOREACK));
+  txHeader(CMD_POTENTIALSCOREACK);
   dbg(b2DEBUG_WIFI, "Header sent. ");
-  clnt.write_P((const char *)&frameID, sizeof(frameID));
-  clnt.write_P((const char *)&lastFrameReceived, sizeof(lastFrameReceived));
-  clnt.write_P((const char *)&lastFrameSent, sizeof(lastFrameSent));
+  txWrite((const char *)&frameID, sizeof(frameID));
+  txWrite((const char *)&lastFrameReceived, sizeof(lastFrameReceived));
+  txWrite((const char *)&lastFrameSent, sizeof(lastFrameSent));
+  txFlush();
   dbgf3(b2DEBUG_WIFI, "Potential score acknowledgement sent (12 bytes). frameID: %d, %d, %d\n", frameID, lastFrameReceived, lastFrameSent);  
 }
 
 bool acceptPotentialScoreAck(uint32_t *frameID, uint32_t *lastFrameHandled, uint32_t *lastFrameShouldReceive) {
-  if (clnt.available()>=strlen(CMD_POTENTIALSCOREACK)+sizeof(uint32_t)*3) {
-    char c=clnt.peek();
-    if (c==CMD_POTENTIALSCOREACK[0]) { // one byte command to be able to use peek
-      clnt.read(); // pop command from buffer
-      clnt.readBytes((uint8_t*)frameID, sizeof(*frameID));
-      clnt.readBytes((uint8_t*)lastFrameHandled, sizeof(*lastFrameHandled));
-      clnt.readBytes((uint8_t*)lastFrameShouldReceive, sizeof(*lastFrameShouldReceive));
-      dbgf3(b2DEBUG_WIFI, "Potential score acknowledgement received, frameID: %d, %d, %d\n", *frameID, *lastFrameHandled, *lastFrameShouldReceive);
-      return true;
-    }
-  }
-  return false;
+  PongNetMsg *msg=peekNetMsg(MSG_POTENTIALSCOREACK);
+  if (!msg) return false;
+  *frameID=msg->data.score.frameID;
+  *lastFrameHandled=msg->data.score.lastFrameHandled;
+  *lastFrameShouldReceive=msg->data.score.lastFrameShouldReceive;
+  rxQueue.pop();
+  dbgf3(b2DEBUG_WIFI, "Potential score acknowledgement received, frameID: %d, %d, %d\n", *frameID, *lastFrameHandled, *lastFrameShouldReceive);
+  return true;
 }
 
 void sendFinalScore(uint32_t frameID, int8_t scoring) {
   dbg(b2DEBUG_WIFI, "Sending final score. ");
-  clnt.write_P(CMD_POTENTIALSCOREACK, strlen(CMD_POTENTIALSCOREACK));
+  txHeader(CMD_FINALSCORE);
   dbg(b2DEBUG_WIFI, "Header sent. ");
-  clnt.write_P((const char *)&frameID, sizeof(frameID));
-  clnt.write_P((const char *)&scoring, sizeof(scoring));
+  txWrite((const char *)&frameID, sizeof(frameID));
+  txWrite((const char *)&scoring, sizeof(scoring));
+  txFlush();
   dbgf2(b2DEBUG_WIFI, "Scoring sent (5 bytes). frameID: %d, scoring: %d\n", frameID, scoring);  
 }
 
 bool acceptFinalScore(uint32_t *frameID, int8_t *scoring) {
-  if (clnt.available()>=strlen(CMD_FINALSCORE)+sizeof(int8_t)) {
-    char c=clnt.peek();
-    if (c==CMD_POTENTIALSCOREACK[0]) { // one byte command to be able to use peek
-      clnt.read(); // pop command from buffer
-      clnt.readBytes((uint8_t*)frameID, sizeof(*frameID));
-      clnt.readBytes((uint8_t*)scoring, sizeof(*scoring));
-      dbgf2(b2DEBUG_WIFI, "Final score received, frameID: %d, scoring: %d\n", *frameID, *scoring);
-      return true;
-    }
-  }
-  return false;
+  PongNetMsg *msg=peekNetMsg(MSG_FINALSCORE);
+  if (!msg) return false;
+  *frameID=msg->data.finalScore.frameID;
+  *scoring=msg->data.finalScore.scoring;
+  rxQueue.pop();
+  dbgf2(b2DEBUG_WIFI, "Final score received, frameID: %d, scoring: %d\n", *frameID, *scoring);
+  return true;
+}
+
+void sendRound(PongRoundMsg *round) {
+  dbg(b2DEBUG_WIFI, "Sending round start. ");
+  txHeader(CMD_ROUND);
+  txWrite((const char *)&round->round, sizeof(round->round));
+  txWrite((const char *)&round->scoreSelf, sizeof(round->scoreSelf));
+  txWrite((const char *)&round->scoreOther, sizeof(round->scoreOther));
+  txWrite((const char *)&round->lost, sizeof(round->lost));
+  txFlush();
+  dbgf3(b2DEBUG_WIFI, "Round start sent (8 bytes). round: %d, score: %d - %d\n", round->round, round->scoreSelf, round->scoreOther);
+}
+
+bool acceptRound(PongRoundMsg *round, uint32_t *rxTime) {
+  PongNetMsg *msg=peekNetMsg(MSG_ROUND);
+  if (!msg) return false;
+  memcpy(round, &msg->data.round, sizeof(PongRoundMsg));
+  *rxTime=msg->rxTime;
+  rxQueue.pop();
+  dbgf3(b2DEBUG_WIFI, "Round start received, round: %d, score: %d - %d\n", round->round, round->scoreSelf, round->scoreOther);
+  return true;
+}
+
+void sendReady() {
+  dbg(b2DEBUG_WIFI, "Sending ready. ");
+  txHeader(CMD_READY);
+  txFlush();
+  dbgln(b2DEBUG_WIFI, "Ready sent.");
+}
+
+bool acceptReady() {
+  if (!peekNetMsg(MSG_READY)) return false;
+  rxQueue.pop();
+  dbgln(b2DEBUG_WIFI, "Ready received.");
+  return true;
 }
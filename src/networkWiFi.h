@@ -1,22 +1,98 @@
+#ifndef __NETWORKWIFI_H__
+#define __NETWORKWIFI_H__
+
 #include <Arduino.h>
 #include "gamestate.h"
 
 #define CONNECT_TIMEOUT 10000
+#define LINK_TIMEOUT 3000 // ms without any incoming byte means the connection is dead
+#define KEEPALIVE_FRAMES 15 // resend our direction if nothing was sent for this many frames
+#define KEEPALIVE_INTERVAL 500 // ms of silence after which a keepalive goes out between the rounds
+#define RESUME_TIMEOUT 2000 // ms to wait for each step of the resume handshake
+#define NETMSG_QUEUE_SIZE 32 // decoded messages waiting for the game loop (power of two)
+
+// decoded incoming messages (filled by the receive task)
+enum PongMsgType {
+  MSG_DIRCHG,
+  MSG_POTENTIALSCORE,
+  MSG_POTENTIALSCOREACK,
+  MSG_FINALSCORE,
+  MSG_ROUND,
+  MSG_READY, // the client was touched on the game over screen
+  MSG_KEEPALIVE, // only refreshes the link timeout, never queued
+  MSG_METRICSREQ // a host stand-in asks for a metrics snapshot, never queued
+};
+
+#define MSGMASK(type) (1<<(type))
+
+struct PongScoreMsg {
+  uint32_t frameID;
+  uint32_t lastFrameHandled;
+  uint32_t lastFrameShouldReceive;
+};
+typedef struct PongScoreMsg PongScoreMsg;
+
+struct PongFinalScoreMsg {
+  uint32_t frameID;
+  int8_t scoring;
+};
+typedef struct PongFinalScoreMsg PongFinalScoreMsg;
+
+struct PongRoundMsg { // the server started a round, its serve follows from the match seed
+  uint32_t round;
+  uint8_t scoreSelf; // as the server sees it
+  uint8_t scoreOther;
+  uint8_t lost; // the server lost the last point
+};
+typedef struct PongRoundMsg PongRoundMsg;
+
+struct PongNetMsg {
+  uint8_t type; // PongMsgType
+  uint32_t rxTime; // micros() when the message was decoded
+  union {
+    PongDirChangeMsg dirChg;
+    PongScoreMsg score;
+    PongFinalScoreMsg finalScore;
+    PongRoundMsg round;
+  } data;
+};
+typedef struct PongNetMsg PongNetMsg;
 
 void displayMsg(const char *line1, const char *line2=NULL, const char *line3=NULL);
 bool networkInit();
+void startReceiver();
+void pauseReceiver();
+void resumeReceiver();
+int32_t decodeNetMsg(const uint8_t *buf, uint32_t len, PongNetMsg *msg); // returns the bytes used, 0 if more are needed, minus the bytes to skip on garbage
 uint32_t getSendingLatency();
 uint32_t getReceivingLatency();
+int32_t getClockOffset(); // micros() of the other board minus ours, estimated at connect
+uint32_t getMatchSeed(); // agreed at connect, the same on both sides
+
+bool linkAlive();
+void refreshLink(); // restarts the link timeout, for a phase the peer may have been silent before
+void keepLinkAlive(); // call every frame in every networked phase, sends a keepalive if we were silent
+                     // and the metrics snapshot a host stand-in asked for
+void dropLink();
+bool reconnect();
+bool acceptReconnect();
+void sendResume(PongGameState *state, uint8_t count, const uint8_t *inputs, bool playing); // playing: the server is in a round
+bool waitResume(PongGameState *state, uint8_t *count, uint8_t *inputs, bool *playing);
 
 void sendMsg(const char *msg);
 bool waitMsg(const char *msg, uint32_t timeout = CONNECT_TIMEOUT);
-void sendGameState(PongGameState *state);
-void waitGameState(PongGameState *state);
-void sendDirChg(PongGameState *state);
-bool acceptDirChg(uint32_t *fid, int8_t *dir);
+void discardNetMsgs(uint32_t keepMask);
+uint32_t sendDirChg(PongGameState *state, uint32_t captureTime); // returns micros() when it was written
+bool acceptDirChg(uint32_t *fid, int8_t *dir, uint32_t *rxTime = NULL, uint32_t *captureTime = NULL, uint32_t *sendTime = NULL); // the sender's clock
 void sendPotentialScore(uint32_t frameID, uint32_t lastFrameReceived, uint32_t lastFrameSent);
 bool acceptPotentialScore(uint32_t *frameID, uint32_t *lastFrameHandled, uint32_t *lastFrameShouldReceive);
 void sendPotentialScoreAck(uint32_t frameID, uint32_t lastFrameReceived, uint32_t lastFrameSent);
 bool acceptPotentialScoreAck(uint32_t *frameID, uint32_t *lastFrameHandled, uint32_t *lastFrameShouldReceive);
 void sendFinalScore(uint32_t frameID, int8_t scoring);
 bool acceptFinalScore(uint32_t *frameID, int8_t *scoring);
+void sendRound(PongRoundMsg *round);
+bool acceptRound(PongRoundMsg *round, uint32_t *rxTime);
+void sendReady();
+bool acceptReady();
+
+#endif //__NETWORKWIFI_H__
@@ -0,0 +1,28 @@
+#include "pacerclock.h"
+#include "b2debug.h"
+#include <esp_sleep.h>
+
+static void pacerWake(void *arg) { // runs in the esp_timer task
+  xTaskNotifyGive((TaskHandle_t)arg);
+}
+
+void EspPacerClock::begin() {
+  task = xTaskGetCurrentTaskHandle();
+  esp_timer_create_args_t args;
+  memset(&args, 0, sizeof(args));
+  args.callback = pacerWake;
+  args.arg = task;
+  args.name = "pacer";
+  esp_timer_create(&args, &timer);
+}
+
+void EspPacerClock::sleep(uint32_t us) {
+  if (lightSleep && us > PACER_LIGHTSLEEP_MIN_US) {
+    esp_sleep_enable_timer_wakeup(us - PACER_LIGHTSLEEP_WAKE_US);
+    esp_light_sleep_start();
+    return;
+  }
+  if (!timer || us <= PACER_TIMER_WAKE_US) return;
+  esp_timer_start_once(timer, us - PACER_TIMER_WAKE_US);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
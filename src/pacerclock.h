@@ -0,0 +1,30 @@
+#ifndef __PACERCLOCK_H__
+#define __PACERCLOCK_H__
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#define PACER_TIMER_WAKE_US 50 // wake-up latency of the timer + task notification
+#define PACER_LIGHTSLEEP_WAKE_US 1000 // wake-up latency of light sleep
+#define PACER_LIGHTSLEEP_MIN_US 3000 // shorter idle times are not worth a light sleep
+
+/**********
+** The clock of the frame pacer on the ESP32
+**   sleep() blocks the loop task on a one-shot esp_timer, so the core idles instead of
+**   spinning; with lightSleep set (only when the radio is off) it light sleeps instead
+***********/
+class EspPacerClock {
+  public:
+    EspPacerClock() : lightSleep(false), timer(NULL), task(NULL) {}
+    void begin(); // call from the task that sleeps
+    uint32_t now() { return micros(); }
+    void sleep(uint32_t us);
+
+    bool lightSleep;
+
+  private:
+    esp_timer_handle_t timer;
+    TaskHandle_t task;
+};
+
+#endif //__PACERCLOCK_H__
@@ -0,0 +1,127 @@
+#ifndef __PHYSICS_H__
+#define __PHYSICS_H__
+
+#include <Arduino.h>
+#include "b2debug.h"
+#include "arena.h"
+#include "gamestate.h"
+#include "helper.h"
+#include "collision.h"
+
+/**********
+** Game physics
+**   templated on the arena so every bound is a compile time constant
+***********/
+template<class A>
+void moveBall(PongGameState* state, PongGameState* pState, int32_t deltaTime) {
+	dbgf(b2DEBUG_MOVEBALL, "moveBall: dT=%d\n", deltaTime);
+	// only the wall and the paddle the ball moves towards can be hit, the wall wins
+	PongBall ball = { pState->posBallX, pState->posBallY, pState->speedBallX, pState->speedBallY }, next;
+	PongSegment wall = { false, ball.speedY<0 ? A::wallTop : A::wallBottom, 0, A::wallLength, (int8_t)(ball.speedY<0 ? -1 : 1), 0 };
+	PongSegment paddle = ball.speedX<0 ? PongSegment{ true, A::paddleSelfX, pState->posSelf-A::paddleReach, pState->posSelf+A::paddleReach, -1, state->dirSelf }
+	                                   : PongSegment{ true, A::paddleOtherX, pState->posOther-A::paddleReach, pState->posOther+A::paddleReach, 1, state->dirOther };
+	int32_t collisionTime = deltaTime;
+	const PongSegment *hit = hitSegment(&ball, &wall, deltaTime, &collisionTime) ? &wall
+	                       : hitSegment(&ball, &paddle, deltaTime, &collisionTime) ? &paddle : NULL;
+	advanceBall(&ball, &next, hit, collisionTime, deltaTime);
+	state->posBallX = next.x;
+	state->posBallY = next.y;
+	state->speedBallX = next.speedX;
+	state->speedBallY = next.speedY;
+	dbgf2(b2DEBUG_MOVEBALL, "hit=%d at %d ", hit==&wall ? 0 : hit ? 1 : -1, collisionTime);
+	dbg(b2DEBUG_MOVEBALL, "move:[speed=("); dbg(b2DEBUG_MOVEBALL, state->speedBallX); dbg(b2DEBUG_MOVEBALL, ";"); dbg(b2DEBUG_MOVEBALL, state->speedBallY); dbg(b2DEBUG_MOVEBALL, ") pos=("); dbg(b2DEBUG_MOVEBALL, state->posBallX); dbg(b2DEBUG_MOVEBALL, ";"); dbg(b2DEBUG_MOVEBALL, state->posBallY); dbgln(b2DEBUG_MOVEBALL, ")]");
+}
+
+template<class A>
+void recalcFrame(PongGameState* curState, PongGameState* pState) {
+	// default frame time, we don't handle differences
+	int32_t deltaTime = A::frameTime; 
+	// move self
+	dbgf(b2DEBUG_RECALCFRAME, "self move amount in this frame: %d\n", A::paddleMove);
+	curState->posSelf = pState->posSelf + curState->dirSelf * A::paddleMove; 
+	if (curState->posSelf<A::paddleMin) curState->posSelf=A::paddleMin;
+	if (curState->posSelf>A::paddleMax) curState->posSelf=A::paddleMax;
+	dbgf(b2DEBUG_RECALCFRAME, "recalculated self position: %d\n", curState->posSelf);
+	// move other
+	dbgf(b2DEBUG_RECALCFRAME, "other move amount in this frame: %d\n", A::paddleMove);
+	curState->posOther = pState->posOther + curState->dirOther * A::paddleMove; 
+	if (curState->posOther<A::paddleMin) curState->posOther=A::paddleMin;
+	if (curState->posOther>A::paddleMax) curState->posOther=A::paddleMax;
+	dbgf(b2DEBUG_RECALCFRAME, "recalculated other position: %d\n", curState->posOther);
+	// move the ball
+	moveBall<A>(curState, pState, deltaTime);
+}
+
+template<class A>
+int8_t checkScoreSituation(PongGameState *state) { // returns 1: we won a point, 0: no scoring, -1: we lost a point
+	if (state->posBallX>A::goalOther) {
+		return 1;
+	} else if (state->posBallX<A::goalSelf) {
+		return -1;
+	} else {
+		return 0;
+	}
+}
+
+/**********
+** Rollback
+**   a late direction change of the other paddle is applied to every frame from its frame
+**   to the latest one with the same result as rerunning recalcFrame on all of them:
+**   the paddle is patched in closed form, the ball is only resimulated from the first frame
+**   it reaches the other paddle's line (before that the paddle can not change its path)
+***********/
+template<class A>
+int32_t paddleAfter(int32_t pos, int8_t dir, uint32_t frames) { // where a paddle moving in one direction ends up
+	int32_t target = pos + (int32_t)frames * dir * A::paddleMove;
+	if (target<A::paddleMin) return A::paddleMin;
+	if (target>A::paddleMax) return A::paddleMax;
+	return target;
+}
+
+template<class A>
+bool reachesOtherLine(PongGameState *pState) { // the ball gets to the other paddle's line in the next frame
+	int32_t t;
+	return pState->speedBallX > 0 && checkVCollision(A::paddleOtherX, INT32_MIN, INT32_MAX,
+	                                                 pState->posBallX, pState->posBallY, pState->speedBallX, pState->speedBallY,
+	                                                 A::frameTime, &t);
+}
+
+template<class A>
+bool rollbackOther(uint32_t frameID, int8_t dir) { // false if the frame is no longer in the history
+	uint32_t idx = getStateIdxWithID(frameID);
+	if (idx==NO_FRAME) return false;
+	uint32_t pIdx = prevState(idx);
+	if (pIdx==NO_FRAME) { // the oldest frame has nothing to replay from, it keeps its position
+		getState(idx)->dirOther = dir;
+		pIdx = idx;
+		idx = nextState(idx);
+	}
+	int32_t startPos = getState(pIdx)->posOther;
+	bool resimulate = false;
+	for (uint32_t frames=1; idx!=NO_FRAME; frames++) {
+		PongGameState *st = getState(idx), *pSt = getState(pIdx);
+		st->dirOther = dir;
+		if (!resimulate) resimulate = reachesOtherLine<A>(pSt);
+		if (resimulate) recalcFrame<A>(st, pSt);
+		else st->posOther = paddleAfter<A>(startPos, dir, frames);
+		pIdx = idx;
+		idx = nextState(idx);
+	}
+	return true;
+}
+
+template<class A>
+void serveBall(PongGameState *state, int32_t angle) { // angle in degrees, 0 is towards the other side
+	state->speedBallX=45*cos(angle*PI/180);
+	state->speedBallY=45*sin(angle*PI/180);
+	state->posBallX=A::width*500;
+	state->posBallY=A::height*500;
+}
+
+template<class A>
+void mirrorState(PongGameState *state) { // the same moment seen from the other side of the net
+	reverseRoles(state);
+	state->posBallX = A::wallLength - state->posBallX;
+}
+
+#endif //__PHYSICS_H__
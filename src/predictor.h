@@ -0,0 +1,53 @@
+#ifndef __PREDICTOR_H__
+#define __PREDICTOR_H__
+
+#include <Arduino.h>
+#include "b2debug.h"
+#include "arena.h"
+#include "gamestate.h"
+#include "ai.h"
+
+/**********
+** Remote input prediction
+**   guesses the other paddle's direction for the frames no message confirmed yet, a wrong
+**   guess is rolled back once the other side's next message is in; picked at build time:
+**   HoldPredictor (default) keeps the last direction received, InterceptPredictor
+**   (-D b2PREDICT_INTERCEPT) steers the paddle to where the ball crosses its line like the AI;
+**   the other side only sends changes (and keepalives), so a change it guesses that did not
+**   happen is only found out by the next message
+***********/
+#define INTERCEPT_REACTION 100000 // us a prediction of the ball is reused for
+#define INTERCEPT_FORESEE 1000000 // us ahead the ball is followed, a farther one is not reacted to yet
+#define INTERCEPT_DEADZONE 4000 // the paddle is not moved when it is this close to the ball's path (half a paddle)
+
+struct HoldPredictor {
+  static const bool guesses = false; // never differs from the last direction received
+  void reset() {}
+  template<class A>
+  int8_t next(PongGameState *, int8_t held) { return held; }
+};
+
+struct InterceptPredictor {
+  static const bool guesses = true;
+  PongAI ai; // an AI without error, only its prediction of the ball is used
+  void reset() { initAI(&ai, 0, INTERCEPT_REACTION, INTERCEPT_FORESEE); }
+  template<class A>
+  int8_t next(PongGameState *pState, int8_t held) {
+    // a ball going away tells nothing about what the other player does meanwhile
+    if (pState->speedBallX<=0 || pState->posBallX>A::paddleOtherX) return held;
+    if (!predict<A>(&ai, A::frameTime, pState)) return held;
+    // stops on the ball's path and turns back to it, otherwise keeps going like the last message said
+    int32_t diff = ai.predPosY - pState->posOther;
+    if (diff < -INTERCEPT_DEADZONE) return held>0 ? -1 : held;
+    if (diff > INTERCEPT_DEADZONE) return held<0 ? 1 : held;
+    return 0;
+  }
+};
+
+#ifdef b2PREDICT_INTERCEPT
+typedef InterceptPredictor OtherPredictor;
+#else
+typedef HoldPredictor OtherPredictor;
+#endif
+
+#endif //__PREDICTOR_H__
@@ -0,0 +1,45 @@
+#ifndef __PRNG_H__
+#define __PRNG_H__
+
+#include <stdint.h>
+
+/**********
+** Seedable pseudo random numbers
+**   a xorshift32 generator: every owner keeps its own state so a sequence
+**   only depends on its seed, not on who else draws numbers (or on which core);
+**   plain 32 bit integer math, so every platform produces the same sequence
+***********/
+struct PongPRNG {
+  uint32_t state;
+};
+typedef struct PongPRNG PongPRNG;
+
+// scrambles a number (the murmur3 finalizer), for seeds derived from each other
+inline uint32_t prngMix(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x85ebca6b;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35;
+  x ^= x >> 16;
+  return x;
+}
+
+inline void prngSeed(PongPRNG *rng, uint32_t seed) {
+  rng->state = seed ? seed : 0x9e3779b9; // xorshift gets stuck at zero
+}
+
+inline uint32_t prngNext(PongPRNG *rng) {
+  uint32_t x = rng->state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return rng->state = x;
+}
+
+// a number in [lo, hi), like Arduino's random(lo, hi)
+inline int32_t prngRandom(PongPRNG *rng, int32_t lo, int32_t hi) {
+  if (lo >= hi) return lo;
+  return lo + (int32_t)(prngNext(rng) % (uint32_t)(hi - lo));
+}
+
+#endif //__PRNG_H__
@@ -0,0 +1,37 @@
+#include "serialframe.h"
+
+uint16_t crc16(const uint8_t *buf, uint32_t len, uint16_t crc) {
+  while (len--) {
+    crc ^= (uint16_t)*buf++ << 8;
+    for (int i=0; i<8; i++) crc = (crc & 0x8000) ? (crc<<1) ^ 0x1021 : crc<<1;
+  }
+  return crc;
+}
+
+uint32_t encodeFrame(uint8_t *frame, const uint8_t *payload, uint32_t len, uint8_t seq, uint8_t ack) {
+  if (len>FRAME_MAX_PAYLOAD) return 0;
+  frame[0]=FRAME_SYNC;
+  frame[1]=len;
+  frame[2]=seq;
+  frame[3]=ack;
+  if (len) memcpy(frame+4, payload, len);
+  uint16_t crc=crc16(frame+1, len+3);
+  frame[len+4]=crc; frame[len+5]=crc>>8;
+  return len+FRAME_OVERHEAD;
+}
+
+int32_t decodeFrame(const uint8_t *buf, uint32_t avail, uint32_t *len) {
+  if (buf[0]!=FRAME_SYNC) { // skip to the next sync byte
+    uint32_t skip=1;
+    while (skip<avail && buf[skip]!=FRAME_SYNC) skip++;
+    return -(int32_t)skip;
+  }
+  if (avail<2) return 0;
+  uint32_t n=buf[1];
+  if (n>FRAME_MAX_PAYLOAD) return -1;
+  if (avail<n+FRAME_OVERHEAD) return 0;
+  uint16_t crc=crc16(buf+1, n+3);
+  if (buf[n+4]!=(uint8_t)crc || buf[n+5]!=(uint8_t)(crc>>8)) return -1; // a false sync or a damaged frame
+  *len=n;
+  return n+FRAME_OVERHEAD;
+}
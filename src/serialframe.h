@@ -0,0 +1,177 @@
+#ifndef __SERIALFRAME_H__
+#define __SERIALFRAME_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+/**********
+** Framing of the wired link
+**   a UART does not tell where a message starts nor that it arrived intact, so every
+**   write is sent as a frame (tools/seriallink.py has the same codec):
+**     0    FRAME_SYNC
+**     1    payload length (0..FRAME_MAX_PAYLOAD, 0 is a bare acknowledge)
+**     2    sequence number of the frame
+**     3    sequence number of the next frame expected from the other side
+**     4    payload
+**     4+n  CRC-16/CCITT-FALSE of the length, the numbers and the payload (little endian)
+**   a receiver that loses sync skips a byte and looks for the next FRAME_SYNC
+***********/
+#define FRAME_SYNC 0xB2
+#define FRAME_MAX_PAYLOAD 160 // the longest write is a resume (6+25+1+99 bytes)
+#define FRAME_OVERHEAD 6
+#define FRAME_MAX_SIZE (FRAME_MAX_PAYLOAD+FRAME_OVERHEAD)
+
+uint16_t crc16(const uint8_t *buf, uint32_t len, uint16_t crc = 0xffff);
+uint32_t encodeFrame(uint8_t *frame, const uint8_t *payload, uint32_t len, uint8_t seq, uint8_t ack); // returns the frame size, 0 if the payload does not fit
+// returns the bytes used (the payload is at frame+4, *len long), 0 if more are needed, minus the bytes to skip on garbage
+int32_t decodeFrame(const uint8_t *buf, uint32_t avail, uint32_t *len);
+
+/**********
+** Delivery
+**   the protocol above expects every byte once and in order, like from a socket, so a damaged
+**   frame has to come again (Go-Back-N): the receiver takes only the frame it expects next and
+**   answers every data frame with the number of the one after it, carried by its own next
+**   frame or a bare acknowledge; the sender keeps up to FRAME_WINDOW frames until they are
+**   acknowledged and sends all of them again once the oldest waited FRAME_RESEND_MS.
+**   A full window means the other board stopped answering: the write fails as on a full
+**   socket and the session's receive timeout decides. After a reset on one side the other
+**   drops the new frames (their numbers start over) until it resets too, then they come again
+**
+**   Port is anything with int available(), size_t readBytes(buf, len), uint32_t millis()
+**   and size_t write(buf, len) that puts a frame on the wire in one piece, so the writing
+**   side and the receiving side (which acknowledges and resends) can share it
+***********/
+#define FRAME_WINDOW 16 // divides 256, the sequence numbers wrap
+#define FRAME_RESEND_MS 20 // a cable answers within a few ms (the receive task polls every 1 ms)
+
+struct FrameLinkStats {
+  uint32_t badFrames; // damaged frames and garbage skipped
+  uint32_t resentFrames;
+  uint32_t dupFrames; // frames received again or out of order, dropped
+};
+typedef struct FrameLinkStats FrameLinkStats;
+
+template<class Port>
+class FrameLink {
+  public:
+    FrameLink(Port &port) : port(port) { memset(&stats, 0, sizeof(stats)); reset(); }
+
+    // the writing side: returns the payload bytes sent, 0 if the window is full
+    size_t write(const uint8_t *buf, size_t len) {
+      uint8_t seq=txNext;
+      if (!len || (uint8_t)(seq-txAcked)>=FRAME_WINDOW) return 0;
+      uint32_t slot=seq%FRAME_WINDOW;
+      uint32_t size=encodeFrame(txFrame[slot], buf, len, seq, rxNext);
+      if (!size) return 0;
+      txSize[slot]=size;
+      txTime[slot]=port.millis();
+      txNext=seq+1; // the receiving side may resend it from now on
+      port.write(txFrame[slot], size); // a short write is a damaged frame, it comes again
+      return len;
+    }
+
+    // the receiving side: payload bytes ready to read, takes in what the port received
+    int available() {
+      pump();
+      return payloadLen;
+    }
+
+    int read(uint8_t *buf, size_t len) {
+      if (!payloadLen) pump();
+      uint32_t n=len<payloadLen ? len : payloadLen;
+      memcpy(buf, payload+payloadStart, n);
+      payloadStart+=n;
+      payloadLen-=n;
+      if (!payloadLen) payloadStart=0;
+      return n;
+    }
+
+    // drops the partial frames, everything not read yet and not acknowledged yet, neither
+    // side may be using the link meanwhile
+    void reset() {
+      uint8_t drain[32];
+      while (port.available()>0) port.readBytes(drain, sizeof(drain));
+      rawLen=0;
+      payloadStart=0;
+      payloadLen=0;
+      txNext=0;
+      txAcked=0;
+      rxNext=0;
+    }
+
+    const FrameLinkStats *getStats() const { return &stats; }
+
+  private:
+    void resend() { // go back to the oldest frame not acknowledged
+      uint8_t acked=txAcked, next=txNext;
+      if (acked==next) return;
+      uint32_t now=port.millis();
+      if (now-txTime[acked%FRAME_WINDOW]<FRAME_RESEND_MS) return;
+      for (uint8_t seq=acked; seq!=next; seq++) {
+        uint32_t slot=seq%FRAME_WINDOW;
+        txTime[slot]=now;
+        port.write(txFrame[slot], txSize[slot]);
+        stats.resentFrames++;
+      }
+    }
+
+    void pump() {
+      resend();
+      bool ackDue=false;
+      while (payloadLen+FRAME_MAX_PAYLOAD <= sizeof(payload)) { // room for one more frame
+        int avail=port.available();
+        if (avail>0 && rawLen<sizeof(raw))
+          rawLen+=port.readBytes(raw+rawLen, (uint32_t)avail<sizeof(raw)-rawLen ? avail : sizeof(raw)-rawLen);
+        if (!rawLen) break;
+        uint32_t len;
+        int32_t used=decodeFrame(raw, rawLen, &len);
+        if (used==0) { // the rest of the frame is still on the wire
+          if (avail<=0) break;
+          continue;
+        }
+        if (used<0) {
+          stats.badFrames++;
+          used=-used;
+        } else {
+          uint8_t seq=raw[2], ack=raw[3];
+          if ((uint8_t)(ack-txAcked)<=(uint8_t)(txNext-txAcked)) txAcked=ack; // not a stale one
+          if (len) {
+            ackDue=true;
+            if (seq==rxNext) {
+              if (payloadStart+payloadLen+len > sizeof(payload)) { // move the unread bytes to the front
+                memmove(payload, payload+payloadStart, payloadLen);
+                payloadStart=0;
+              }
+              memcpy(payload+payloadStart+payloadLen, raw+4, len);
+              payloadLen+=len;
+              rxNext=seq+1;
+            } else stats.dupFrames++;
+          }
+        }
+        rawLen-=used;
+        memmove(raw, raw+used, rawLen);
+      }
+      if (ackDue) {
+        uint8_t frame[FRAME_OVERHEAD];
+        port.write(frame, encodeFrame(frame, NULL, 0, txNext, rxNext));
+      }
+    }
+
+    Port &port;
+    FrameLinkStats stats; // written by the receiving side
+    // written by the writing side, resent by the receiving side once published by txNext
+    uint8_t txFrame[FRAME_WINDOW][FRAME_MAX_SIZE];
+    uint32_t txSize[FRAME_WINDOW];
+    uint32_t txTime[FRAME_WINDOW]; // millis of the last send
+    std::atomic<uint8_t> txNext; // written by the writing side
+    std::atomic<uint8_t> txAcked; // written by the receiving side
+    std::atomic<uint8_t> rxNext; // ...
+    // the receiving side only
+    uint8_t raw[FRAME_MAX_SIZE*2]; // frames as they come from the port
+    uint32_t rawLen;
+    uint8_t payload[FRAME_MAX_PAYLOAD*2]; // delivered, not read yet
+    uint32_t payloadStart, payloadLen;
+};
+
+#endif //__SERIALFRAME_H__
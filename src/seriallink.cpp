@@ -0,0 +1,52 @@
+#include "seriallink.h"
+#include "serialframe.h"
+#include "metrics.h"
+#include "b2debug.h"
+
+struct UartPort { // the UART driver locks its writes, a frame is never interleaved with another
+  int available() { return Serial2.available(); }
+  size_t readBytes(uint8_t *buf, size_t len) { return Serial2.readBytes(buf, len); }
+  size_t write(const uint8_t *buf, size_t len) { return Serial2.write(buf, len); }
+  uint32_t millis() { return ::millis(); }
+};
+
+// written by the game loop, read (and acknowledged, and resent) by whoever owns the receiving
+// side: the receive task or the handshake
+static UartPort uart;
+static FrameLink<UartPort> frameLink(uart);
+
+void serialLinkBegin() {
+  Serial2.setRxBufferSize(SERIAL_LINK_RXBUF);
+  Serial2.begin(SERIAL_LINK_BAUD, SERIAL_8N1, SERIAL_LINK_RX, SERIAL_LINK_TX);
+  serialLinkReset();
+}
+
+size_t serialLinkWrite(const uint8_t *buf, size_t len) {
+  size_t sent=frameLink.write(buf, len);
+  if (!sent) {
+    dbgf(b2DEBUG_WIFI, "Dropping a write of %d bytes, the other board acknowledges nothing\n", (int)len);
+  }
+  return sent;
+}
+
+static void takeStats() { // the receiving side counts, also the resends
+  const FrameLinkStats *stats=frameLink.getStats();
+  metrics.rxBadFrames=stats->badFrames;
+  metrics.txResentFrames=stats->resentFrames;
+}
+
+int serialLinkAvailable() {
+  int avail=frameLink.available();
+  takeStats();
+  return avail;
+}
+
+int serialLinkRead(uint8_t *buf, size_t len) {
+  int n=frameLink.read(buf, len);
+  takeStats();
+  return n;
+}
+
+void serialLinkReset() {
+  frameLink.reset();
+}
@@ -0,0 +1,24 @@
+#ifndef __SERIALLINK_H__
+#define __SERIALLINK_H__
+
+#include <Arduino.h>
+
+/**********
+** Wired link between the boards (b2SERIAL)
+**   UART2 crossed over (TX to RX) between two boards, the grounds connected; every write
+**   goes out as one numbered frame (serialframe.h) and is sent again until the other board
+**   acknowledges it, reads return the payloads once and in order as one byte stream, the
+**   same as a socket would
+***********/
+#define SERIAL_LINK_BAUD 2000000
+#define SERIAL_LINK_RX 16
+#define SERIAL_LINK_TX 17
+#define SERIAL_LINK_RXBUF 1024 // UART driver buffer
+
+void serialLinkBegin();
+size_t serialLinkWrite(const uint8_t *buf, size_t len); // returns the payload bytes sent, 0 while FRAME_WINDOW frames wait for their acknowledge
+int serialLinkAvailable(); // payload bytes ready to read, takes in what the UART received
+int serialLinkRead(uint8_t *buf, size_t len);
+void serialLinkReset(); // drops the partial frames, everything not read yet and not acknowledged yet
+
+#endif //__SERIALLINK_H__
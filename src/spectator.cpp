@@ -0,0 +1,174 @@
+#include "spectator.h"
+#include "b2debug.h"
+#include "wire.h"
+#include "metrics.h"
+
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include <lwip/sockets.h>
+
+extern const char* CMD_FULLGAMESTATE;
+
+/**********
+** Shared, reference counted frame buffers
+**   every published frame is encoded once and all spectators send from the same bytes,
+**   a metrics snapshot asked for by a spectator is queued only for that one
+***********/
+#define SPECTATOR_FRAME_SIZE (6+WIRE_GAMESTATE_SIZE)
+#define SPECTATOR_DATA_SIZE (METRICS_WIRE_SIZE>SPECTATOR_FRAME_SIZE?METRICS_WIRE_SIZE:SPECTATOR_FRAME_SIZE)
+struct SpectatorFrame {
+  uint16_t refs; // number of spectators still having this frame in their queue
+  uint8_t len;
+  uint8_t data[SPECTATOR_DATA_SIZE];
+};
+SpectatorFrame spectatorFrames[SPECTATOR_FRAMES];
+uint16_t nextFrame = 0;
+int16_t metricsFrame = -1; // the buffer of the metrics snapshot
+
+/**********
+** Subscribers
+**   each one has a small queue of frame indices and the write offset into the head frame
+***********/
+struct Spectator {
+  WiFiClient clnt;
+  bool active;
+  uint16_t queue[SPECTATOR_QUEUE];
+  uint8_t head;
+  uint8_t count;
+  uint8_t written; // bytes of the head frame already sent
+  uint16_t stalled; // frames without any progress
+  bool metricsPending; // asked for a metrics snapshot that is not queued yet
+};
+Spectator spectators[SPECTATOR_MAX];
+WiFiServer spectatorSrv(SPECTATOR_PORT);
+
+static void releaseFrame(uint16_t idx) {
+  if (spectatorFrames[idx].refs>0) spectatorFrames[idx].refs--;
+}
+
+static void dropSpectator(Spectator *s) {
+  while (s->count>0) {
+    releaseFrame(s->queue[s->head]);
+    s->head=(s->head+1) % SPECTATOR_QUEUE;
+    s->count--;
+  }
+  s->clnt.stop();
+  s->active=false;
+  dbgln(b2DEBUG_WIFI, "Spectator dropped.");
+}
+
+void spectatorInit() {
+  for (int i=0; i<SPECTATOR_FRAMES; i++) spectatorFrames[i].refs=0;
+  for (int i=0; i<SPECTATOR_MAX; i++) spectators[i].active=false;
+  spectatorSrv.begin();
+}
+
+void spectatorAccept() {
+  WiFiClient c=spectatorSrv.available();
+  if (!c) return;
+  for (int i=0; i<SPECTATOR_MAX; i++) {
+    if (!spectators[i].active) {
+      Spectator *s=&spectators[i];
+      s->clnt=c;
+      s->clnt.setNoDelay(true);
+      s->active=true;
+      s->head=0; s->count=0; s->written=0; s->stalled=0; s->metricsPending=false;
+      dbgf(b2DEBUG_WIFI, "Spectator connected in slot %d\n", i);
+      return;
+    }
+  }
+  c.stop(); // no free slot
+}
+
+static int16_t allocFrame() {
+  uint16_t idx=nextFrame;
+  for (int i=0; i<SPECTATOR_FRAMES && spectatorFrames[idx].refs>0; i++) idx=(idx+1) % SPECTATOR_FRAMES;
+  if (spectatorFrames[idx].refs>0) return -1;
+  nextFrame=(idx+1) % SPECTATOR_FRAMES;
+  return idx;
+}
+
+static void queueFrame(Spectator *s, uint16_t idx) {
+  if (s->count==SPECTATOR_QUEUE) { // slow spectator: skip ahead by dropping its oldest frame that is not being written
+    uint8_t drop=(s->written>0)?(s->head+1) % SPECTATOR_QUEUE:s->head;
+    releaseFrame(s->queue[drop]);
+    for (uint8_t j=drop; j!=(s->head+s->count-1) % SPECTATOR_QUEUE; j=(j+1) % SPECTATOR_QUEUE)
+      s->queue[j]=s->queue[(j+1) % SPECTATOR_QUEUE];
+    s->count--;
+  }
+  s->queue[(s->head+s->count) % SPECTATOR_QUEUE]=idx;
+  s->count++;
+  spectatorFrames[idx].refs++;
+}
+
+// writes what the socket takes without blocking, returns whether anything went out
+static bool sendQueued(Spectator *s) {
+  bool progress=false;
+  while (s->count>0) {
+    SpectatorFrame *f=&spectatorFrames[s->queue[s->head]];
+    int sent=send(s->clnt.fd(), f->data+s->written, f->len-s->written, MSG_DONTWAIT); // never block the game loop
+    if (sent<=0) break; // socket buffer is full (or error, which connected() reports next time)
+    progress=true;
+    s->written+=sent;
+    if (s->written<f->len) break;
+    releaseFrame(s->queue[s->head]);
+    s->head=(s->head+1) % SPECTATOR_QUEUE;
+    s->count--;
+    s->written=0;
+  }
+  if (progress) s->stalled=0;
+  return progress;
+}
+
+void spectatorPublish(PongGameState *state) {
+  if (spectatorCount()==0) return;
+  // find a free buffer (there is always one: a spectator holds the newest frames, at most one older frame
+  // it is still writing and at most the one metrics snapshot, see SPECTATOR_FRAMES)
+  int16_t idx=allocFrame();
+  if (idx<0) return; // can not happen, skip this frame for everyone
+  if (idx==metricsFrame) metricsFrame=-1; // the snapshot in it is sent already
+  // encode once
+  SpectatorFrame *f=&spectatorFrames[idx];
+  memcpy(f->data, CMD_FULLGAMESTATE, 6);
+  encodeGameState(f->data+6, state);
+  f->len=SPECTATOR_FRAME_SIZE;
+  // hand out references and send right away, several confirmed frames may come in one go
+  for (int i=0; i<SPECTATOR_MAX; i++) {
+    if (!spectators[i].active) continue;
+    queueFrame(&spectators[i], idx);
+    sendQueued(&spectators[i]);
+  }
+}
+
+static void serviceMetrics(Spectator *s) {
+  uint8_t req[8];
+  int n=recv(s->clnt.fd(), req, sizeof(req), MSG_DONTWAIT);
+  for (int i=0; i<n; i++) if (req[i]==METRICS_REQUEST) s->metricsPending=true;
+  if (!s->metricsPending) return;
+  if (metricsFrame>=0 && spectatorFrames[metricsFrame].refs>0) return; // another spectator's snapshot is still queued, try again with the next frame
+  int16_t idx=allocFrame();
+  if (idx<0) return;
+  metricsFrame=idx;
+  SpectatorFrame *f=&spectatorFrames[idx];
+  f->len=encodeMetrics(f->data);
+  queueFrame(s, idx);
+  s->metricsPending=false;
+}
+
+void spectatorService() {
+  spectatorAccept();
+  for (int i=0; i<SPECTATOR_MAX; i++) {
+    Spectator *s=&spectators[i];
+    if (!s->active) continue;
+    if (!s->clnt.connected()) { dropSpectator(s); continue; }
+    serviceMetrics(s);
+    if (sendQueued(s) || s->count==0) s->stalled=0;
+    else if (++s->stalled>SPECTATOR_STALL_LIMIT) dropSpectator(s);
+  }
+}
+
+uint16_t spectatorCount() {
+  uint16_t n=0;
+  for (int i=0; i<SPECTATOR_MAX; i++) if (spectators[i].active) n++;
+  return n;
+}
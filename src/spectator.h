@@ -0,0 +1,23 @@
+#ifndef __SPECTATOR_H__
+#define __SPECTATOR_H__
+
+#include <Arduino.h>
+#include "gamestate.h"
+
+#define SPECTATOR_PORT 5264
+#ifndef SPECTATOR_MAX
+#define SPECTATOR_MAX 4 // lwIP has only a handful of sockets to spare (the host test raises it)
+#endif
+#define SPECTATOR_QUEUE 4 // frames queued per spectator before it skips ahead
+// shared frame buffers: the newest SPECTATOR_QUEUE frames, an older one being written per spectator,
+// a metrics snapshot and the new one
+#define SPECTATOR_FRAMES (SPECTATOR_MAX+SPECTATOR_QUEUE+2)
+#define SPECTATOR_STALL_LIMIT 90 // frames a spectator may go without progress before being dropped (3 seconds)
+
+void spectatorInit();
+void spectatorAccept();
+void spectatorPublish(PongGameState *state);
+void spectatorService();
+uint16_t spectatorCount();
+
+#endif //__SPECTATOR_H__
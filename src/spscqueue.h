@@ -0,0 +1,43 @@
+#ifndef __SPSCQUEUE_H__
+#define __SPSCQUEUE_H__
+
+#include <stdint.h>
+#include <atomic>
+
+/**********
+** Lock-free single producer / single consumer ring
+**   fixed capacity (must be a power of two), the producer only writes head and the consumer only writes tail
+***********/
+template<class T, uint32_t N>
+class SPSCQueue {
+  static_assert((N & (N-1)) == 0, "capacity must be a power of two");
+  public:
+    SPSCQueue() : head(0), tail(0) {}
+
+    // producer side
+    bool push(const T &item) {
+      uint32_t h = head.load(std::memory_order_relaxed);
+      if (h - tail.load(std::memory_order_acquire) == N) return false; // full
+      items[h & (N-1)] = item;
+      head.store(h + 1, std::memory_order_release); // publish the item
+      return true;
+    }
+    bool full() const { return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire) == N; }
+
+    // consumer side
+    T* front() { // the oldest item stays valid until pop()
+      uint32_t t = tail.load(std::memory_order_relaxed);
+      if (head.load(std::memory_order_acquire) == t) return NULL; // empty
+      return &items[t & (N-1)];
+    }
+    void pop() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+    bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed); }
+    uint32_t size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+
+  private:
+    T items[N];
+    std::atomic<uint32_t> head; // next slot to write (free running, wraps naturally)
+    std::atomic<uint32_t> tail; // next slot to read
+};
+
+#endif //__SPSCQUEUE_H__
@@ -0,0 +1,236 @@
+#include "tournament.h"
+#include "b2debug.h"
+
+#ifdef b2TOURNAMENT
+#include <Arduino.h>
+#include <atomic>
+#include "arena.h"
+#include "gamestate.h"
+#include "physics.h"
+#include "ai.h"
+#include "prng.h"
+#include "predictor.h"
+#include "networkWiFi.h"
+
+#define TOURNAMENT_SEED 20240601 // change it to get another (but again reproducible) run
+#define TOURNAMENT_RALLIES 2000 // rallies per setting on the board
+#define TOURNAMENT_MAX_FRAMES 3000 // a rally longer than this (~100 seconds) is a draw
+#define TOURNAMENT_YIELD 100 // rallies between two yields, keeps the task watchdog fed
+#define TOURNAMENT_WORKERS 2 // one per core of the board
+#define TOURNAMENT_LAG 2 // frames a message of the tested AI takes to the other board in the predictor replay
+#define TOUR_HISTORY 64 // frames of the replay kept, more than KEEPALIVE_FRAMES+TOURNAMENT_LAG
+
+typedef SSD1306Arena TourArena;
+
+// the swept grid, every setting plays against the default AI
+const int32_t tourErrors[] = { 40, 80, 160 };
+const int32_t tourReactions[] = { 250000, 500000, 1000000 };
+const int32_t tourForesees[] = { 500000, 1000000, 2000000 };
+#define TOUR_COUNT(a) (sizeof(a)/sizeof(a[0]))
+#define TOURNAMENT_SETTINGS (TOUR_COUNT(tourErrors)*TOUR_COUNT(tourReactions)*TOUR_COUNT(tourForesees))
+
+struct TourResult {
+  uint32_t won;
+  uint32_t lost;
+  uint32_t draws;
+  uint64_t frames;
+  uint64_t predError; // sum of |predicted - real| ball position at the paddle line, in 1/1000 pixels
+  uint32_t predictions;
+  uint32_t guessFrames[2]; // hold and intercept predictor replays of the tested AI's inputs
+  uint32_t guessMisses[2];
+  uint32_t rollbacks[2];
+  uint32_t rollbackFrames[2];
+};
+typedef struct TourResult TourResult;
+
+// what the tested AI played and sent, as the other board would receive it TOURNAMENT_LAG frames later
+struct TourLink {
+  int8_t played[TOUR_HISTORY]; // by frameID
+  bool sent[TOUR_HISTORY];
+  int8_t lastDir;
+  uint32_t lastSent;
+};
+typedef struct TourLink TourLink;
+
+// the other board guessing the tested AI's inputs and rolling back like commNetwork does; the guesses
+// are made from the real states, a wrong guess changing the history seen by the next ones is left out
+template<class P>
+struct TourGuesser {
+  P predictor;
+  int8_t held;
+  uint32_t confirmed;
+  int8_t guess[TOUR_HISTORY]; // what each frame was made with
+  int8_t history[TOUR_HISTORY]; // ... and what it has now
+};
+
+TourResult tourResults[TOURNAMENT_SETTINGS];
+uint32_t tourRallies = TOURNAMENT_RALLIES;
+std::atomic<uint32_t> tourNext;
+SemaphoreHandle_t tourDone;
+
+// records how far off the AI was where the ball reaches its paddle line in the next frame, whether
+// the paddle hits it back or misses it (the AI plays "other")
+static void tourCheckPrediction(PongAI *ai, PongGameState *pState, TourResult *res) {
+  int32_t t;
+  if (!ai->hasPred || pState->speedBallX <= 0) return;
+  if (!checkVCollision(TourArena::paddleOtherX, INT32_MIN, INT32_MAX, pState->posBallX, pState->posBallY,
+                       pState->speedBallX, pState->speedBallY, TourArena::frameTime, &t)) return;
+  int32_t y = pState->posBallY + t*pState->speedBallY/1000;
+  if (y < TourArena::wallTop) y = 2*TourArena::wallTop - y; // bounced off a wall on the way in this frame
+  if (y > TourArena::wallBottom) y = 2*TourArena::wallBottom - y;
+  int32_t diff = ai->predPosY - y;
+  res->predError += diff < 0 ? -diff : diff;
+  res->predictions++;
+}
+
+static void tourSend(TourLink *link, uint32_t frame, int8_t dir) {
+  bool send = dir!=link->lastDir || frame-link->lastSent >= KEEPALIVE_FRAMES;
+  link->played[frame%TOUR_HISTORY] = dir;
+  link->sent[frame%TOUR_HISTORY] = send;
+  if (send) {
+    link->lastDir = dir;
+    link->lastSent = frame;
+  }
+}
+
+template<class P>
+static void tourGuess(TourGuesser<P> *g, TourLink *link, uint32_t frame, PongGameState *pState, TourResult *res, int r) {
+  int8_t dir = g->predictor.template next<TourArena>(pState, g->held);
+  g->guess[frame%TOUR_HISTORY] = g->history[frame%TOUR_HISTORY] = dir;
+  if (frame<=TOURNAMENT_LAG || !link->sent[(frame-TOURNAMENT_LAG)%TOUR_HISTORY]) return;
+  // the message of frame fid is in: every frame since the last one is known now
+  uint32_t fid = frame-TOURNAMENT_LAG, wrong = 0;
+  for (uint32_t f=g->confirmed+1; f<=fid; f++) {
+    int8_t actual = f<fid ? g->held : link->played[fid%TOUR_HISTORY];
+    res->guessFrames[r]++;
+    if (g->guess[f%TOUR_HISTORY]!=actual) res->guessMisses[r]++;
+    if (!wrong && g->history[f%TOUR_HISTORY]!=actual) wrong = f;
+  }
+  if (wrong) {
+    res->rollbacks[r]++;
+    res->rollbackFrames[r] += frame-wrong+1;
+    for (uint32_t f=wrong; f<=frame; f++) g->history[f%TOUR_HISTORY] = f<fid ? g->held : link->played[fid%TOUR_HISTORY];
+  }
+  g->held = link->played[fid%TOUR_HISTORY];
+  g->confirmed = fid;
+}
+
+// one rally from the serve to the score, the tested AI is "other", the default AI "self"
+static void tourRally(PongAI *tested, PongAI *base, PongPRNG *rng, bool towardsTested, TourResult *res) {
+  PongGameState cur, prev, mCur, mPrev;
+  memset(&prev, 0, sizeof(PongGameState));
+  prev.posSelf = TourArena::height*500;
+  prev.posOther = TourArena::height*500;
+  serveBall<TourArena>(&prev, towardsTested ? prngRandom(rng, -30, 30) : prngRandom(rng, 150, 210));
+  tested->hasPred = false;
+  base->hasPred = false;
+  TourLink link;
+  TourGuesser<HoldPredictor> hold;
+  TourGuesser<InterceptPredictor> intercept;
+  memset(&link, 0, sizeof(TourLink));
+  memset(&hold, 0, sizeof(hold));
+  memset(&intercept, 0, sizeof(intercept));
+  hold.predictor.reset();
+  intercept.predictor.reset();
+  for (uint32_t frame=1; frame<=TOURNAMENT_MAX_FRAMES; frame++) {
+    memcpy(&cur, &prev, sizeof(PongGameState));
+    cur.frameID = frame;
+    // both paddles use the shipped AI, the default one sees the game from the other side of the net
+    calcAI<TourArena>(tested, &cur, &prev);
+    memcpy(&mCur, &cur, sizeof(PongGameState)); mirrorState<TourArena>(&mCur);
+    memcpy(&mPrev, &prev, sizeof(PongGameState)); mirrorState<TourArena>(&mPrev);
+    calcAI<TourArena>(base, &mCur, &mPrev);
+    cur.dirSelf = mCur.dirOther;
+    tourSend(&link, frame, cur.dirOther);
+    tourGuess(&hold, &link, frame, &prev, res, 0);
+    tourGuess(&intercept, &link, frame, &prev, res, 1);
+    tourCheckPrediction(tested, &prev, res);
+    recalcFrame<TourArena>(&cur, &prev);
+    int8_t scoring = checkScoreSituation<TourArena>(&cur);
+    if (scoring != 0) {
+      if (scoring < 0) res->won++; else res->lost++;
+      res->frames += frame;
+      return;
+    }
+    memcpy(&prev, &cur, sizeof(PongGameState));
+  }
+  res->draws++;
+  res->frames += TOURNAMENT_MAX_FRAMES;
+}
+
+static void tourSetting(uint32_t idx, PongAI *tested) {
+  uint32_t e = idx / (TOUR_COUNT(tourReactions)*TOUR_COUNT(tourForesees));
+  uint32_t r = idx / TOUR_COUNT(tourForesees) % TOUR_COUNT(tourReactions);
+  uint32_t f = idx % TOUR_COUNT(tourForesees);
+  initAI(tested, tourErrors[e], tourReactions[r], tourForesees[f]);
+}
+
+void tournamentStart(uint32_t rallies) {
+  tourRallies = rallies;
+  tourNext = 0;
+}
+
+// pulls settings until none is left, every setting has its own seeds so the results
+// do not depend on which worker (core or thread) played it
+void tournamentPlay(bool yield) {
+  PongAI tested, base;
+  PongPRNG rng;
+  uint32_t idx;
+  while ((idx = tourNext.fetch_add(1)) < TOURNAMENT_SETTINGS) {
+    TourResult *res = &tourResults[idx];
+    memset(res, 0, sizeof(TourResult));
+    tourSetting(idx, &tested);
+    initAI(&base);
+    seedAI(&tested, TOURNAMENT_SEED*3 + idx*7919);
+    seedAI(&base, TOURNAMENT_SEED*5 + idx*7919);
+    prngSeed(&rng, TOURNAMENT_SEED*7 + idx*7919);
+    for (uint32_t i=0; i<tourRallies; i++) {
+      tourRally(&tested, &base, &rng, i%2, res);
+      if (yield && i%TOURNAMENT_YIELD == TOURNAMENT_YIELD-1) vTaskDelay(1);
+    }
+  }
+}
+
+static void tourWorker(void *param) {
+  tournamentPlay(true);
+  xSemaphoreGive(tourDone);
+  vTaskDelete(NULL);
+}
+
+void runTournament() {
+  Serial.begin(115200);
+  delay(100);
+  tournamentStart(TOURNAMENT_RALLIES);
+  tourDone = xSemaphoreCreateCounting(TOURNAMENT_WORKERS, 0);
+  uint32_t start = millis();
+  for (int i=0; i<TOURNAMENT_WORKERS; i++) {
+    xTaskCreatePinnedToCore(tourWorker, "tournament", 4096, NULL, 1, NULL, i);
+  }
+  for (int i=0; i<TOURNAMENT_WORKERS; i++) xSemaphoreTake(tourDone, portMAX_DELAY);
+  uint32_t elapsed = millis() - start;
+  vSemaphoreDelete(tourDone);
+  tournamentReport(TOURNAMENT_WORKERS, elapsed);
+}
+
+void tournamentReport(uint32_t workers, uint32_t elapsed) {
+  PongAI base;
+  initAI(&base);
+  Serial.printf("{\n  \"version\": 1,\n  \"seed\": %u,\n  \"rallies\": %u,\n  \"workers\": %u,\n  \"elapsed_ms\": %u,\n  \"lag\": %u,\n", TOURNAMENT_SEED, tourRallies, workers, elapsed, TOURNAMENT_LAG);
+  Serial.printf("  \"baseline\": {\"error\": %d, \"reaction\": %d, \"foresee\": %d},\n  \"results\": [", base.aiError, base.aiReaction, base.aiForesee);
+  for (uint32_t idx=0; idx<TOURNAMENT_SETTINGS; idx++) {
+    PongAI tested;
+    tourSetting(idx, &tested);
+    TourResult *res = &tourResults[idx];
+    Serial.printf("%s\n    {\"error\": %d, \"reaction\": %d, \"foresee\": %d, \"win_rate\": %.4f, \"draws\": %u, \"rally_frames\": %.1f, \"pred_error\": %.1f",
+                  idx ? "," : "", tested.aiError, tested.aiReaction, tested.aiForesee,
+                  (float)res->won / tourRallies, res->draws, (float)res->frames / tourRallies,
+                  res->predictions ? (float)res->predError / res->predictions / 1000 : 0.0f);
+    for (int r=0; r<2; r++)
+      Serial.printf(", \"%s\": {\"hit_rate\": %.4f, \"rollbacks\": %u, \"rollback_depth\": %.2f}", r ? "intercept" : "hold",
+                    res->guessFrames[r] ? 1.0f - (float)res->guessMisses[r] / res->guessFrames[r] : 0.0f, res->rollbacks[r],
+                    res->rollbacks[r] ? (float)res->rollbackFrames[r] / res->rollbacks[r] : 0.0f);
+    Serial.printf("}");
+  }
+  Serial.printf("\n  ]\n}\n");
+}
+#endif
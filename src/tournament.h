@@ -0,0 +1,20 @@
+#ifndef __TOURNAMENT_H__
+#define __TOURNAMENT_H__
+
+#include "b2debug.h"
+
+/**********
+** AI tournament
+**   enabled with b2TOURNAMENT (see b2debug.h), it plays headless AI-vs-AI rallies
+**   on both cores at startup, sweeping a grid of AI settings against the default AI,
+**   and prints win rate, rally length and prediction error of each setting as JSON;
+**   the host runs the same on a thread per core (emu/host.cpp)
+***********/
+#ifdef b2TOURNAMENT
+void runTournament();
+void tournamentStart(uint32_t rallies); // rallies per setting
+void tournamentPlay(bool yield); // a worker, returns when every setting is played
+void tournamentReport(uint32_t workers, uint32_t elapsed);
+#endif
+
+#endif //__TOURNAMENT_H__
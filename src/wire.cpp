@@ -0,0 +1,35 @@
+#include "wire.h"
+
+static uint8_t* putInt24(uint8_t *buf, int32_t v) {
+  buf[0]=v; buf[1]=v>>8; buf[2]=v>>16;
+  return buf+3;
+}
+
+void encodeGameState(uint8_t *buf, const PongGameState *state) {
+  buf[0]=WIRE_VERSION;
+  buf[1]=state->frameID; buf[2]=state->frameID>>8; buf[3]=state->frameID>>16; buf[4]=state->frameID>>24;
+  uint16_t packed=std::min(state->scoreSelf, (uint8_t)0x3f) | (std::min(state->scoreOther, (uint8_t)0x3f)<<6) |
+                  ((state->dirSelf+1)<<12) | ((state->dirOther+1)<<14);
+  buf[5]=packed; buf[6]=packed>>8;
+  uint8_t *p=buf+7;
+  p=putInt24(p, state->posSelf);
+  p=putInt24(p, state->posOther);
+  p=putInt24(p, state->posBallX);
+  p=putInt24(p, state->posBallY);
+  p=putInt24(p, state->speedBallX);
+  putInt24(p, state->speedBallY);
+}
+
+void PongGameStateView::decode(PongGameState *state) const {
+  state->frameID=frameID();
+  state->scoreSelf=scoreSelf();
+  state->scoreOther=scoreOther();
+  state->dirSelf=dirSelf();
+  state->dirOther=dirOther();
+  state->posSelf=posSelf();
+  state->posOther=posOther();
+  state->posBallX=posBallX();
+  state->posBallY=posBallY();
+  state->speedBallX=speedBallX();
+  state->speedBallY=speedBallY();
+}
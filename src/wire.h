@@ -0,0 +1,48 @@
+#ifndef __WIRE_H__
+#define __WIRE_H__
+
+#include <Arduino.h>
+#include "gamestate.h"
+
+/**********
+** Portable wire encoding of PongGameState
+**   explicit little-endian layout, independent of the compiler's struct padding:
+**     0  version (WIRE_VERSION)
+**     1  frameID (32 bits)
+**     5  scoreSelf (6 bits) | scoreOther (6 bits) | dirSelf+1 (2 bits) | dirOther+1 (2 bits)
+**     7  posSelf, posOther, posBallX, posBallY, speedBallX, speedBallY (signed 24 bits each)
+**   scores above 63 saturate
+***********/
+#define WIRE_VERSION 1
+#define WIRE_GAMESTATE_SIZE 25
+
+void encodeGameState(uint8_t *buf, const PongGameState *state);
+
+// zero-copy read access to an encoded game state sitting in a receive buffer
+class PongGameStateView {
+  public:
+    explicit PongGameStateView(const uint8_t *buf) : buf(buf) {}
+    bool valid() const { return buf[0]==WIRE_VERSION; }
+    uint32_t frameID() const { return (uint32_t)buf[1] | ((uint32_t)buf[2]<<8) | ((uint32_t)buf[3]<<16) | ((uint32_t)buf[4]<<24); }
+    uint8_t scoreSelf() const { return packed() & 0x3f; }
+    uint8_t scoreOther() const { return (packed()>>6) & 0x3f; }
+    int8_t dirSelf() const { return ((packed()>>12) & 3) - 1; }
+    int8_t dirOther() const { return ((packed()>>14) & 3) - 1; }
+    int32_t posSelf() const { return int24(7); }
+    int32_t posOther() const { return int24(10); }
+    int32_t posBallX() const { return int24(13); }
+    int32_t posBallY() const { return int24(16); }
+    int32_t speedBallX() const { return int24(19); }
+    int32_t speedBallY() const { return int24(22); }
+    void decode(PongGameState *state) const;
+
+  private:
+    uint16_t packed() const { return (uint16_t)buf[5] | ((uint16_t)buf[6]<<8); }
+    int32_t int24(uint8_t at) const { // sign extend from 24 bits
+      int32_t v = (int32_t)buf[at] | ((int32_t)buf[at+1]<<8) | ((int32_t)buf[at+2]<<16);
+      return (v ^ 0x800000) - 0x800000;
+    }
+    const uint8_t *buf;
+};
+
+#endif //__WIRE_H__
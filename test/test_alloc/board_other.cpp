@@ -0,0 +1,5 @@
+// the board it plays against
+#define EMU_NS other
+#define EMU_FIRMWARE otherFirmware
+#define EMU_NAME "other"
+#include "../../emu/firmware.h"
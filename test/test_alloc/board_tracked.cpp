@@ -0,0 +1,8 @@
+// the board whose loop task counts its allocations (see src/allocstats.h)
+#define b2DEBUG_ALLOC
+#define EMU_NS tracked
+#define EMU_FIRMWARE trackedFirmware
+#define EMU_NAME "tracked"
+#include "../../emu/firmware.h"
+
+uint32_t trackedFrames() { return tracked::metrics.frames; }
@@ -0,0 +1,88 @@
+#include <unity.h>
+
+/**********
+** The frame loop stays off the heap
+**   two emulated boards play networked matches (see emu/emu.h), the loop task of one of
+**   them counts its allocations with src/allocstats.cpp and asserts that no frame after
+**   the warmup made any; each role is played in a fresh child process
+***********/
+#include "../../emu/emu.cpp"
+#include <sys/wait.h>
+
+// the lolin32_alloc environment has the linker wrap the malloc family, on the host glibc lets
+// the program replace it and keeps the originals reachable as __libc_*
+extern "C" {
+  void *__libc_malloc(size_t size);
+  void *__libc_calloc(size_t n, size_t size);
+  void *__libc_realloc(void *ptr, size_t size);
+  void *__wrap_malloc(size_t size);
+  void *__wrap_calloc(size_t n, size_t size);
+  void *__wrap_realloc(void *ptr, size_t size);
+
+  void *__real_malloc(size_t size) { return __libc_malloc(size); }
+  void *__real_calloc(size_t n, size_t size) { return __libc_calloc(n, size); }
+  void *__real_realloc(void *ptr, size_t size) { return __libc_realloc(ptr, size); }
+  void *malloc(size_t size) throw() { return __wrap_malloc(size); }
+  void *calloc(size_t n, size_t size) throw() { return __wrap_calloc(n, size); }
+  void *realloc(void *ptr, size_t size) throw() { return __wrap_realloc(ptr, size); }
+}
+
+#define MATCHES 2 // with the rematch in between
+#define LIMIT_US 1200000000ULL // 20 minutes of virtual time
+#define MIN_FRAMES 1000
+
+extern EmuFirmware trackedFirmware, otherFirmware;
+uint32_t trackedFrames();
+
+uint32_t matchesOver = 0;
+bool wasOver = false;
+
+static bool matchesDone() {
+  bool over = trackedFirmware.gameOver();
+  if (over && !wasOver) matchesOver++;
+  wasOver = over;
+  return matchesOver>=MATCHES;
+}
+
+// returns the child's wait status, an allocation in a frame aborts it
+static int playMatches(bool trackedServes) {
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid==0) {
+    EmuConfig config = { 2000, 1000, 1, true }; // verbose: the board prints what it allocated before asserting
+    emuInit(&config);
+    EmuFirmware *server = trackedServes ? &trackedFirmware : &otherFirmware;
+    EmuFirmware *client = trackedServes ? &otherFirmware : &trackedFirmware;
+    emuAddBoard(server, server->serverID, 0);
+    emuAddBoard(client, client->serverID+1, 700000);
+    bool done = emuRun(LIMIT_US, matchesDone);
+    printf("%u frames of the %s checked\n", trackedFrames(), trackedServes ? "server" : "client");
+    fflush(stdout);
+    _exit(done && trackedFrames()>=MIN_FRAMES ? 0 : 1);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return status;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_server_frames_do_not_allocate() {
+  int status = playMatches(true);
+  TEST_ASSERT_FALSE_MESSAGE(WIFSIGNALED(status), "a frame of the server allocated");
+  TEST_ASSERT_EQUAL_INT(0, WEXITSTATUS(status));
+}
+
+void test_client_frames_do_not_allocate() {
+  int status = playMatches(false);
+  TEST_ASSERT_FALSE_MESSAGE(WIFSIGNALED(status), "a frame of the client allocated");
+  TEST_ASSERT_EQUAL_INT(0, WEXITSTATUS(status));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_server_frames_do_not_allocate);
+  RUN_TEST(test_client_frames_do_not_allocate);
+  return UNITY_END();
+}
@@ -0,0 +1,62 @@
+// the physics as it was before the arena template (src/main.cpp of the first tree), debug output
+// left out; included once per arena with its SCREEN_*, PADDLE_*, BALL_RADIUS and MOVE_SPEED macros
+// set, so both are the macro code a build for that display would have compiled
+
+void moveBall(PongGameState* state, PongGameState* pState, int32_t deltaTime) {
+	// collision detection
+  int32_t collisionTime = deltaTime, nextSpeedBallX = pState->speedBallX, nextSpeedBallY = pState->speedBallY;
+	if (pState->speedBallY < 0 && checkHCollision(0, BALL_RADIUS*1000, SCREEN_WIDTH*1000,
+	                                    pState->posBallX, pState->posBallY, pState->speedBallX, pState->speedBallY,
+																			deltaTime, &collisionTime)) { // collide with top
+    nextSpeedBallY=-pState->speedBallY;
+	} else if (pState->speedBallY > 0 && checkHCollision(0, (SCREEN_HEIGHT-BALL_RADIUS)*1000, SCREEN_WIDTH*1000,
+	                                    pState->posBallX, pState->posBallY, pState->speedBallX, pState->speedBallY,
+																			deltaTime, &collisionTime)) { // collide with bottom
+    nextSpeedBallY=-pState->speedBallY;
+	} else if (pState->speedBallX < 0 && checkVCollision((PADDLE_WIDTH+BALL_RADIUS)*1000, pState->posSelf-PADDLE_HEIGHT*500-BALL_RADIUS*1000, pState->posSelf+PADDLE_HEIGHT*500+BALL_RADIUS*1000,
+	                                             pState->posBallX, pState->posBallY, pState->speedBallX, pState->speedBallY,
+																							 deltaTime, &collisionTime)) { // collide with left paddle
+    nextSpeedBallX=-pState->speedBallX;
+		// adjust for moving paddle
+		if (state->dirSelf>0)
+				nextSpeedBallY = nextSpeedBallY * (nextSpeedBallY < 0 ? 0.5 : 1.5);
+		else if (state->dirSelf<0)
+          nextSpeedBallY = nextSpeedBallY * (nextSpeedBallY > 0 ? 0.5 : 1.5);
+	} else if (pState->speedBallX > 0 && checkVCollision((SCREEN_WIDTH-PADDLE_WIDTH-BALL_RADIUS)*1000, pState->posOther-PADDLE_HEIGHT*500-BALL_RADIUS*1000, pState->posOther+PADDLE_HEIGHT*500+BALL_RADIUS*1000,
+	                                             pState->posBallX, pState->posBallY, pState->speedBallX, pState->speedBallY,
+																							 deltaTime, &collisionTime)) { // collide with right paddle
+    nextSpeedBallX=-pState->speedBallX;
+		// adjust for moving paddle
+    if (state->dirOther>0)
+      nextSpeedBallY = nextSpeedBallY * (nextSpeedBallY < 0 ? 0.5 : 1.5);
+    else if (state->dirOther<0)
+      nextSpeedBallY = nextSpeedBallY * (nextSpeedBallY > 0 ? 0.5 : 1.5);
+	}
+	// move1
+	state->posBallX = pState->posBallX + pState->speedBallX * collisionTime / 1000;
+	state->posBallY = pState->posBallY + pState->speedBallY * collisionTime / 1000;
+	// update ball speed according to collision
+	state->speedBallX=nextSpeedBallX;
+	state->speedBallY=nextSpeedBallY;
+	// move2 (finish the move if collision happens mid-frame)
+	state->posBallX += state->speedBallX * (deltaTime-collisionTime) / 1000;
+	state->posBallY += state->speedBallY * (deltaTime-collisionTime) / 1000;
+}
+
+void recalcFrame(PongGameState* curState, PongGameState* pState) {
+	int32_t move;
+	// default frame time, we don't handle differences
+	int32_t deltaTime = FRAME_TIME;
+	// move self
+	move = deltaTime * MOVE_SPEED / 1000;
+	curState->posSelf = pState->posSelf + curState->dirSelf * move;
+	if (curState->posSelf<(PADDLE_HEIGHT*1000/2)) curState->posSelf=(PADDLE_HEIGHT*1000/2);
+	if (curState->posSelf>(SCREEN_HEIGHT-PADDLE_HEIGHT/2)*1000) curState->posSelf=(SCREEN_HEIGHT-PADDLE_HEIGHT/2)*1000;
+	// move other
+	move = deltaTime * MOVE_SPEED / 1000;
+	curState->posOther = pState->posOther + curState->dirOther * move;
+	if (curState->posOther<(PADDLE_HEIGHT*1000/2)) curState->posOther=(PADDLE_HEIGHT*1000/2);
+	if (curState->posOther>(SCREEN_HEIGHT-PADDLE_HEIGHT/2)*1000) curState->posOther=(SCREEN_HEIGHT-PADDLE_HEIGHT/2)*1000;
+	// move the ball
+	moveBall(curState, pState, deltaTime);
+}
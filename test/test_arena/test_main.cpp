@@ -0,0 +1,154 @@
+#include <unity.h>
+
+/**********
+** Arena types side by side
+**   the 128x64 and the 128x32 arena run in one binary; each is checked frame by frame
+**   against the macro code it replaced (baseline.h, compiled once with each display's
+**   macros) on random rallies, and recalcFrame is timed against that code
+***********/
+#include "../../src/arena.h"
+#include "../../src/physics.h"
+#include "../../src/helper.cpp"
+
+#include <chrono>
+
+#define FRAMES 1000000
+#define TIMED_FRAMES 4096
+#define TIMED_ROUNDS 200
+
+namespace baseline64 {
+  #define SCREEN_WIDTH 128
+  #define SCREEN_HEIGHT 64
+  #define PADDLE_WIDTH 3
+  #define PADDLE_HEIGHT 8
+  #define BALL_RADIUS 2
+  #define FRAME_TIME 33333
+  #define MOVE_SPEED (SCREEN_HEIGHT/1)
+  #include "baseline.h"
+  #undef SCREEN_WIDTH
+  #undef SCREEN_HEIGHT
+  #undef PADDLE_WIDTH
+  #undef PADDLE_HEIGHT
+  #undef BALL_RADIUS
+  #undef FRAME_TIME
+  #undef MOVE_SPEED
+}
+
+namespace baseline32 {
+  #define SCREEN_WIDTH 128
+  #define SCREEN_HEIGHT 32
+  #define PADDLE_WIDTH 2
+  #define PADDLE_HEIGHT 6
+  #define BALL_RADIUS 1
+  #define FRAME_TIME 33333
+  #define MOVE_SPEED (SCREEN_HEIGHT/1)
+  #include "baseline.h"
+  #undef SCREEN_WIDTH
+  #undef SCREEN_HEIGHT
+  #undef PADDLE_WIDTH
+  #undef PADDLE_HEIGHT
+  #undef BALL_RADIUS
+  #undef FRAME_TIME
+  #undef MOVE_SPEED
+}
+
+typedef void (*RecalcFrame)(PongGameState *, PongGameState *);
+
+static uint32_t seed = 5263;
+
+static uint32_t next() {
+  seed = seed*1103515245+12345;
+  return seed>>8 ^ seed<<13;
+}
+
+static int32_t between(int32_t lo, int32_t hi) { return lo + (int32_t)(next() % (uint32_t)(hi-lo+1)); }
+
+volatile int32_t sink; // keeps the timed frames from being dropped
+
+// a ball anywhere in the arena at up to ten times the serve speed, the paddles anywhere in their range
+template<class A>
+static void randomState(PongGameState *state) {
+  memset(state, 0, sizeof(PongGameState));
+  state->posSelf = between(A::paddleMin, A::paddleMax);
+  state->posOther = between(A::paddleMin, A::paddleMax);
+  state->posBallX = between(0, A::wallLength);
+  state->posBallY = between(A::wallTop, A::wallBottom);
+  state->speedBallX = between(-450, 450);
+  state->speedBallY = between(-450, 450);
+}
+
+// rallies of both implementations side by side, restarted when the ball leaves the arena
+template<class A>
+static void checkAgainstBaseline(RecalcFrame baseline, const char *name) {
+  PongGameState prev, templ, macro;
+  randomState<A>(&prev);
+  uint32_t rallies = 1;
+  for (uint32_t f=0; f<FRAMES; f++) {
+    templ = prev;
+    if (next()%8==0) templ.dirSelf = next()%3-1;
+    if (next()%8==0) templ.dirOther = next()%3-1;
+    macro = templ;
+    recalcFrame<A>(&templ, &prev);
+    baseline(&macro, &prev);
+    if (memcmp(&templ, &macro, sizeof(PongGameState))) {
+      char msg[96];
+      snprintf(msg, sizeof(msg), "%s: frame %u of rally %u differs from the macro code", name, f, rallies);
+      TEST_FAIL_MESSAGE(msg);
+    }
+    prev = templ;
+    if (checkScoreSituation<A>(&prev) || next()%1000==0) {
+      randomState<A>(&prev);
+      rallies++;
+    }
+  }
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%s: %d frames in %u rallies equal to the macro code", name, FRAMES, rallies);
+  TEST_MESSAGE(msg);
+}
+
+// the same frames through both, the fastest of the rounds counts
+template<class A>
+static void timeAgainstBaseline(RecalcFrame baseline, const char *name) {
+  static PongGameState in[TIMED_FRAMES], out[TIMED_FRAMES];
+  for (int i=0; i<TIMED_FRAMES; i++) {
+    randomState<A>(&in[i]);
+    out[i].dirSelf = next()%3-1;
+    out[i].dirOther = next()%3-1;
+  }
+  uint64_t templNs = UINT64_MAX, macroNs = UINT64_MAX; // the fastest round of each
+  for (int r=0; r<TIMED_ROUNDS; r++) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i=0; i<TIMED_FRAMES; i++) recalcFrame<A>(&out[i], &in[i]);
+    sink += out[r%TIMED_FRAMES].posBallX;
+    auto mid = std::chrono::steady_clock::now();
+    for (int i=0; i<TIMED_FRAMES; i++) baseline(&out[i], &in[i]);
+    sink += out[r%TIMED_FRAMES].posBallX;
+    auto end = std::chrono::steady_clock::now();
+    templNs = std::min(templNs, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(mid-start).count());
+    macroNs = std::min(macroNs, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end-mid).count());
+  }
+  char msg[128];
+  snprintf(msg, sizeof(msg), "%s: recalcFrame %.1f ns, the macro code %.1f ns per frame", name,
+           (double)templNs/TIMED_FRAMES, (double)macroNs/TIMED_FRAMES);
+  TEST_MESSAGE(msg);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_both_arenas_equal_the_macro_code() {
+  checkAgainstBaseline<SSD1306Arena>(baseline64::recalcFrame, "128x64");
+  checkAgainstBaseline<SSD1306ShortArena>(baseline32::recalcFrame, "128x32");
+}
+
+void test_both_arenas_timed_against_the_macro_code() {
+  timeAgainstBaseline<SSD1306Arena>(baseline64::recalcFrame, "128x64");
+  timeAgainstBaseline<SSD1306ShortArena>(baseline32::recalcFrame, "128x32");
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_both_arenas_equal_the_macro_code);
+  RUN_TEST(test_both_arenas_timed_against_the_macro_code);
+  return UNITY_END();
+}
@@ -0,0 +1,169 @@
+#include <unity.h>
+
+/**********
+** Sprites against the display library
+**   drawFrame ORs pre-shifted sprites (src/blit.h) into the framebuffer where it used to
+**   call the library's fillRect and fillCircle; the emulator's SSD1306 runs the library's
+**   code for those, so every sprite at every position (also clipped at the edges) and
+**   random whole frames have to give the same framebuffer, and the sprites are timed
+**   against the library drawing the same frame
+***********/
+#include "../../src/blit.cpp"
+#include "../../src/arena.h"
+#include <SSD1306.h>
+
+#include <chrono>
+
+typedef SSD1306Arena Arena;
+
+#define FRAMES 4096
+#define TIMED_ROUNDS 200
+#define DIGIT_WIDTH 5 // as in src/main.cpp
+#define DIGIT_HEIGHT 9
+#define DIGIT_ADVANCE (DIGIT_WIDTH+2)
+#define FB_SIZE (Arena::width*Arena::height/8)
+
+const uint8_t digitSegments[10] = { 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F };
+
+static uint32_t seed = 5263;
+
+static uint32_t next() {
+  seed = seed*1103515245+12345;
+  return seed>>8 ^ seed<<13;
+}
+
+static int32_t between(int32_t lo, int32_t hi) { return lo + (int32_t)(next() % (uint32_t)(hi-lo+1)); }
+
+static uint8_t libraryFb[FB_SIZE], spriteFb[FB_SIZE];
+static SSD1306 display(0x3c, 5, 4);
+static PongSprite digitSprites[10], paddleSprite, ballSprite;
+
+// the digits as drawFrame drew them before the sprites
+static void libraryDigit(int16_t x, int16_t y, uint8_t digit) {
+  uint8_t seg = digitSegments[digit];
+  if (seg & 0x01) display.fillRect(x, y, DIGIT_WIDTH, 1); // a: top
+  if (seg & 0x02) display.fillRect(x+DIGIT_WIDTH-1, y, 1, DIGIT_HEIGHT/2+1); // b: top right
+  if (seg & 0x04) display.fillRect(x+DIGIT_WIDTH-1, y+DIGIT_HEIGHT/2, 1, DIGIT_HEIGHT/2+1); // c: bottom right
+  if (seg & 0x08) display.fillRect(x, y+DIGIT_HEIGHT-1, DIGIT_WIDTH, 1); // d: bottom
+  if (seg & 0x10) display.fillRect(x, y+DIGIT_HEIGHT/2, 1, DIGIT_HEIGHT/2+1); // e: bottom left
+  if (seg & 0x20) display.fillRect(x, y, 1, DIGIT_HEIGHT/2+1); // f: top left
+  if (seg & 0x40) display.fillRect(x, y+DIGIT_HEIGHT/2, DIGIT_WIDTH, 1); // g: middle
+}
+
+static void spriteDigit(int16_t x, int16_t y, uint8_t digit) {
+  blitSprite(spriteFb, Arena::width, Arena::height, x, y, &digitSprites[digit]);
+}
+
+// as in src/main.cpp, with either way of drawing a digit
+static void drawNumber(void (*drawDigit)(int16_t, int16_t, uint8_t), int16_t x, int16_t y, uint32_t value, bool alignRight) {
+  uint8_t digits[10], n = 0;
+  do { digits[n++] = value % 10; value /= 10; } while (value);
+  if (alignRight) x -= n*DIGIT_ADVANCE-2;
+  while (n) { drawDigit(x, y, digits[--n]); x += DIGIT_ADVANCE; }
+}
+
+struct Frame {
+  int16_t self, other, ballX, ballY; // in pixels
+  uint8_t scoreSelf, scoreOther;
+};
+
+static void randomFrame(Frame *f) {
+  f->self = between(-Arena::paddleHeight/2, Arena::height+Arena::paddleHeight/2);
+  f->other = between(-Arena::paddleHeight/2, Arena::height+Arena::paddleHeight/2);
+  f->ballX = between(-Arena::ballRadius-2, Arena::width+Arena::ballRadius+2);
+  f->ballY = between(-Arena::ballRadius-2, Arena::height+Arena::ballRadius+2);
+  f->scoreSelf = next()%16; f->scoreOther = next()%16;
+}
+
+// drawFrame with the library, then with the sprites
+static void libraryFrame(const Frame *f) {
+  display.clear();
+  drawNumber(libraryDigit, Arena::width/2-5, 0, f->scoreSelf, true);
+  drawNumber(libraryDigit, Arena::width/2+5, 0, f->scoreOther, false);
+  display.fillRect(0, f->self-Arena::paddleHeight/2, Arena::paddleWidth, Arena::paddleHeight);
+  display.fillRect(Arena::width-Arena::paddleWidth, f->other-Arena::paddleHeight/2, Arena::paddleWidth, Arena::paddleHeight);
+  display.fillCircle(f->ballX, f->ballY, Arena::ballRadius);
+}
+
+static void spriteFrame(const Frame *f) {
+  memset(spriteFb, 0, FB_SIZE);
+  drawNumber(spriteDigit, Arena::width/2-5, 0, f->scoreSelf, true);
+  drawNumber(spriteDigit, Arena::width/2+5, 0, f->scoreOther, false);
+  blitSprite(spriteFb, Arena::width, Arena::height, 0, f->self-Arena::paddleHeight/2, &paddleSprite);
+  blitSprite(spriteFb, Arena::width, Arena::height, Arena::width-Arena::paddleWidth, f->other-Arena::paddleHeight/2, &paddleSprite);
+  blitSprite(spriteFb, Arena::width, Arena::height, f->ballX-Arena::ballRadius, f->ballY-Arena::ballRadius, &ballSprite);
+}
+
+static void assertSameFb(const char *what, int16_t x, int16_t y) {
+  if (!memcmp(libraryFb, spriteFb, FB_SIZE)) return;
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%s at %d,%d differs from the library's", what, x, y);
+  TEST_FAIL_MESSAGE(msg);
+}
+
+void setUp() {
+  for (uint8_t d=0; d<10; d++) makeDigitSprite(&digitSprites[d], digitSegments[d], DIGIT_WIDTH, DIGIT_HEIGHT);
+  makeRectSprite(&paddleSprite, Arena::paddleWidth, Arena::paddleHeight);
+  makeCircleSprite(&ballSprite, Arena::ballRadius);
+  display.buffer = libraryFb;
+  display.clear();
+  memset(spriteFb, 0, FB_SIZE);
+}
+void tearDown() {}
+
+void test_every_sprite_position_equals_the_library() {
+  for (int16_t y=-SPRITE_MAX_HEIGHT-1; y<=Arena::height+1; y++) {
+    for (int16_t x=-SPRITE_MAX_WIDTH-1; x<=Arena::width+1; x++) {
+      display.clear(); memset(spriteFb, 0, FB_SIZE);
+      display.fillRect(x, y, Arena::paddleWidth, Arena::paddleHeight);
+      blitSprite(spriteFb, Arena::width, Arena::height, x, y, &paddleSprite);
+      assertSameFb("a paddle", x, y);
+      display.clear(); memset(spriteFb, 0, FB_SIZE);
+      display.fillCircle(x, y, Arena::ballRadius);
+      blitSprite(spriteFb, Arena::width, Arena::height, x-Arena::ballRadius, y-Arena::ballRadius, &ballSprite);
+      assertSameFb("the ball", x, y);
+      for (uint8_t d=0; d<10; d++) {
+        display.clear(); memset(spriteFb, 0, FB_SIZE);
+        libraryDigit(x, y, d);
+        spriteDigit(x, y, d);
+        assertSameFb("a digit", x, y);
+      }
+    }
+  }
+}
+
+void test_random_frames_equal_the_library_and_draw_faster() {
+  static Frame frames[FRAMES];
+  for (uint32_t i=0; i<FRAMES; i++) {
+    randomFrame(&frames[i]);
+    libraryFrame(&frames[i]);
+    spriteFrame(&frames[i]);
+    assertSameFb("a frame with the ball", frames[i].ballX, frames[i].ballY);
+  }
+  volatile uint32_t sink = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint32_t r=0; r<TIMED_ROUNDS; r++)
+    for (uint32_t i=0; i<FRAMES; i++) { libraryFrame(&frames[i]); sink += libraryFb[i%FB_SIZE]; }
+  std::chrono::steady_clock::time_point library = std::chrono::steady_clock::now();
+  for (uint32_t r=0; r<TIMED_ROUNDS; r++)
+    for (uint32_t i=0; i<FRAMES; i++) { spriteFrame(&frames[i]); sink += spriteFb[i%FB_SIZE]; }
+  std::chrono::steady_clock::time_point sprites = std::chrono::steady_clock::now();
+  for (uint32_t r=0; r<TIMED_ROUNDS; r++)
+    for (uint32_t i=0; i<FRAMES; i++) { memset(spriteFb, 0, FB_SIZE); sink += spriteFb[i%FB_SIZE]; }
+  std::chrono::steady_clock::time_point cleared = std::chrono::steady_clock::now();
+  double libraryNs = std::chrono::duration<double, std::nano>(library-start).count()/(TIMED_ROUNDS*FRAMES);
+  double spriteNs = std::chrono::duration<double, std::nano>(sprites-library).count()/(TIMED_ROUNDS*FRAMES);
+  double clearNs = std::chrono::duration<double, std::nano>(cleared-sprites).count()/(TIMED_ROUNDS*FRAMES);
+  char msg[160];
+  snprintf(msg, sizeof(msg), "a frame (the clear, two paddles, the ball and two to four digits): library %.1f ns, sprites %.1f ns, of which the clear %.1f ns",
+           libraryNs, spriteNs, clearNs);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(spriteNs<libraryNs);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_sprite_position_equals_the_library);
+  RUN_TEST(test_random_frames_equal_the_library_and_draw_faster);
+  return UNITY_END();
+}
@@ -0,0 +1,144 @@
+#include <unity.h>
+
+/**********
+** Page ordered images against drawXbm
+**   the win and lose screens used to be drawn with the library's drawXbm from the XBMs in
+**   resources/; blitImage (src/blit.h) copies or decompresses the page ordered arrays
+**   tools/imgconv.py makes of them instead. Both images, raw and RLE, at every column they
+**   fit in have to give the framebuffer drawXbm gives, and each way is timed; the flash
+**   bytes of every form are printed next to the times
+***********/
+#include "../../src/blit.cpp"
+#include "../../src/arena.h"
+#include "../../src/img/win_pages.h"
+#include "../../src/img/lose_pages.h"
+#include "../../resources/win.xbm"
+#include "../../resources/lose.xbm"
+#include <SSD1306.h>
+
+#include <chrono>
+
+typedef SSD1306Arena Arena;
+
+#define TIMED_DRAWS 256
+#define TIMED_ROUNDS 50
+#define FB_SIZE (Arena::width*Arena::height/8)
+#define IMAGE_MAX_SIZE FB_SIZE
+
+static uint8_t xbmFb[FB_SIZE], blitFb[FB_SIZE];
+static SSD1306 display(0x3c, 5, 4);
+
+struct TestImage {
+  const char *name;
+  const uint8_t *xbm;
+  uint16_t xbmSize;
+  int16_t width, height;
+  const PongImage *rle; // as imgconv wrote it to src/img/
+  PongImage raw; // the same pages unpacked
+  uint8_t rawData[IMAGE_MAX_SIZE];
+};
+
+static TestImage images[2] = {
+  { "win", win_bits, sizeof(win_bits), win_width, win_height, &win_pages },
+  { "lose", lose_bits, sizeof(lose_bits), lose_width, lose_height, &lose_pages },
+};
+
+// the RLE format of tools/imgconv.py (unrle there), on its own so the raw form does not go through blitImage
+static void unpack(TestImage *t) {
+  uint16_t n=0, i=0;
+  while (i<t->rle->size) {
+    uint8_t ctrl=t->rle->data[i];
+    if (ctrl<0x80) {
+      TEST_ASSERT_TRUE(n+ctrl+1<=IMAGE_MAX_SIZE);
+      memcpy(t->rawData+n, t->rle->data+i+1, ctrl+1);
+      n+=ctrl+1; i+=ctrl+2;
+    } else {
+      TEST_ASSERT_TRUE(n+ctrl-0x80+2<=IMAGE_MAX_SIZE);
+      memset(t->rawData+n, t->rle->data[i+1], ctrl-0x80+2);
+      n+=ctrl-0x80+2; i+=2;
+    }
+  }
+  TEST_ASSERT_EQUAL(t->rle->width*t->rle->pages, n);
+  t->raw = { t->rle->width, t->rle->pages, false, n, t->rawData };
+}
+
+static void drawWithXbm(const TestImage *t, int16_t x, int16_t page) {
+  display.buffer = xbmFb;
+  display.clear();
+  display.drawXbm(x, page*8, t->width, t->height, t->xbm);
+}
+
+static void drawWithBlit(const PongImage *img, int16_t x, int16_t page) {
+  memset(blitFb, 0, FB_SIZE);
+  blitImage(blitFb, Arena::width, x, page, img);
+}
+
+// every column the image fits in, on every page it fits on
+static void checkImage(const TestImage *t, const PongImage *img, const char *form) {
+  TEST_ASSERT_EQUAL(t->width, img->width);
+  TEST_ASSERT_EQUAL((t->height+7)/8, img->pages);
+  for (int16_t page=0; page+img->pages<=Arena::height/8; page++) {
+    for (int16_t x=0; x+img->width<=Arena::width; x++) {
+      drawWithXbm(t, x, page);
+      drawWithBlit(img, x, page);
+      if (memcmp(xbmFb, blitFb, FB_SIZE)) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "%s (%s) at column %d, page %d differs from drawXbm", t->name, form, x, page);
+        TEST_FAIL_MESSAGE(msg);
+      }
+    }
+  }
+}
+
+// centered as in src/main.cpp, the fastest of the rounds counts
+template<class Draw>
+static double bestNs(Draw draw) {
+  uint64_t best = UINT64_MAX;
+  for (int r=0; r<TIMED_ROUNDS; r++) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i=0; i<TIMED_DRAWS; i++) draw();
+    auto end = std::chrono::steady_clock::now();
+    best = std::min(best, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end-start).count());
+  }
+  return (double)best/TIMED_DRAWS;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_rle_as_written() {
+  for (TestImage &t : images) {
+    TEST_ASSERT_TRUE(t.rle->rle); // both compress, see the imgconv output
+    unpack(&t);
+  }
+}
+
+void test_raw_equals_drawXbm() {
+  for (TestImage &t : images) checkImage(&t, &t.raw, "raw");
+}
+
+void test_rle_equals_drawXbm() {
+  for (TestImage &t : images) checkImage(&t, t.rle, "rle");
+}
+
+void test_timed_against_drawXbm() {
+  for (TestImage &t : images) {
+    int16_t x = (Arena::width - t.width)/2, page = (Arena::height/8 - t.raw.pages)/2;
+    double xbmNs = bestNs([&]() { drawWithXbm(&t, x, page); });
+    double rawNs = bestNs([&]() { drawWithBlit(&t.raw, x, page); });
+    double rleNs = bestNs([&]() { drawWithBlit(t.rle, x, page); });
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%s: drawXbm %.0f ns (%u flash bytes), raw blit %.0f ns (%u bytes), rle blit %.0f ns (%u bytes)",
+             t.name, xbmNs, t.xbmSize, rawNs, t.raw.size, rleNs, t.rle->size);
+    TEST_MESSAGE(msg);
+  }
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rle_as_written);
+  RUN_TEST(test_raw_equals_drawXbm);
+  RUN_TEST(test_rle_equals_drawXbm);
+  RUN_TEST(test_timed_against_drawXbm);
+  return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <unity.h>
+
+/**********
+** Sweep-and-prune against brute force
+**   CollisionWorld's broadphase may only skip pairs that can not collide: on random worlds
+**   (balls anywhere at up to ten times the serve speed, segments of both orientations and
+**   facings, overlapping ones, moved between frames) every ball has to end each frame
+**   exactly where testing it against every segment in list order puts it
+***********/
+#include "../../src/helper.cpp"
+#include "../../src/collision.h"
+
+#define WORLDS 2000
+#define FRAMES 30
+#define FRAME_US 33333
+#define MAX_BALLS 256
+#define MAX_SEGMENTS 32
+#define AREA_X 128000 // the arena in 1/1000 pixel, with some of the balls outside of it
+#define AREA_Y 64000
+#define AREA_KEEP 1000000 // the narrowphase computes distance*1000 in 32 bit, it holds up to 2147 pixels away
+
+static uint32_t seed = 5263;
+
+static uint32_t next() {
+  seed = seed*1103515245+12345;
+  return seed>>8 ^ seed<<13;
+}
+
+static int32_t between(int32_t lo, int32_t hi) { return lo + (int32_t)(next() % (uint32_t)(hi-lo+1)); }
+
+static CollisionWorld<MAX_BALLS, MAX_SEGMENTS> world;
+static PongBall brute[MAX_BALLS];
+
+static void randomSegment(PongSegment *seg) {
+  seg->vertical = next()%2;
+  int32_t along = seg->vertical ? AREA_Y : AREA_X;
+  seg->pos = seg->vertical ? between(-4000, AREA_X+4000) : between(-4000, AREA_Y+4000);
+  seg->from = between(-4000, along);
+  seg->to = seg->from + between(0, along/2);
+  seg->facing = next()%2 ? 1 : -1;
+  seg->dir = next()%3-1;
+}
+
+static void randomWorld(uint32_t balls, uint32_t segments) {
+  world.clear();
+  for (uint32_t i=0; i<segments; i++) {
+    PongSegment seg;
+    if (i>0 && next()%4==0) seg = *world.segment(next()%i); // the same line twice: the earlier one has to win
+    else randomSegment(&seg);
+    world.addSegment(seg);
+  }
+  int32_t speed = next()%2 ? 450 : 4500;
+  for (uint32_t i=0; i<balls; i++) {
+    PongBall ball = { between(-8000, AREA_X+8000), between(-8000, AREA_Y+8000), between(-speed, speed), between(-speed, speed) };
+    world.addBall(ball);
+    brute[i] = ball;
+  }
+}
+
+// every ball against every segment, the first listed hit wins; returns the balls that could hit more than one
+static uint32_t bruteStep(uint32_t *hits) {
+  uint32_t contested = 0;
+  for (uint32_t i=0; i<world.ballCount(); i++) {
+    int32_t when, later;
+    int32_t hit = firstHit(&brute[i], world.segment(0), world.segmentCount(), FRAME_US, &when);
+    if (hit<0) { advanceBall(&brute[i], &brute[i], NULL, when, FRAME_US); continue; }
+    (*hits)++;
+    for (uint32_t s=hit+1; s<world.segmentCount(); s++)
+      if (hitSegment(&brute[i], world.segment(s), FRAME_US, &later)) { contested++; break; }
+    advanceBall(&brute[i], &brute[i], world.segment(hit), when, FRAME_US);
+  }
+  return contested;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_sweep_and_prune_equals_brute_force() {
+  uint32_t hits = 0, contested = 0, steps = 0;
+  for (uint32_t w=0; w<WORLDS; w++) {
+    randomWorld(between(1, MAX_BALLS), between(1, MAX_SEGMENTS));
+    for (uint32_t f=0; f<FRAMES; f++) {
+      if (next()%4==0) { // a paddle moves between the frames
+        PongSegment *seg = world.segment(next()%world.segmentCount());
+        int32_t by = between(-3000, 3000);
+        seg->from += by; seg->to += by;
+      }
+      contested += bruteStep(&hits);
+      world.step(FRAME_US);
+      steps++;
+      for (uint32_t i=0; i<world.ballCount(); i++) {
+        if (memcmp(world.ball(i), &brute[i], sizeof(PongBall))) {
+          char msg[128];
+          snprintf(msg, sizeof(msg), "world %u frame %u ball %u: %d,%d swept, %d,%d brute force", w, f, i,
+                   world.ball(i)->x, world.ball(i)->y, brute[i].x, brute[i].y);
+          TEST_FAIL_MESSAGE(msg);
+        }
+        if (abs(brute[i].x)>AREA_KEEP || abs(brute[i].y)>AREA_KEEP) { // spun up and gone, serve it again
+          brute[i].x = AREA_X/2; brute[i].y = AREA_Y/2;
+          *world.ball(i) = brute[i];
+        }
+      }
+    }
+  }
+  char msg[128];
+  snprintf(msg, sizeof(msg), "%u frames of %u worlds, %u hits, %u of them with another segment in reach", steps, WORLDS, hits, contested);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(hits>steps); // the worlds are busy
+  TEST_ASSERT_TRUE(contested>hits/100); // and the list order had to decide
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_sweep_and_prune_equals_brute_force);
+  return UNITY_END();
+}
@@ -0,0 +1,135 @@
+#include <unity.h>
+
+/**********
+** Frame pacing against a mock clock
+**   src/framepacer.h driven by a clock that only moves when it is read or slept on: every
+**   read costs a microsecond like the spin loop's micros(), a sleep wakes a set time late;
+**   the frame starts, the idle and sleep times and the counters are checked exactly
+***********/
+#include "../../src/framepacer.h"
+
+#define FRAME_US 33333
+#define SPIN_US 200
+
+struct MockClock {
+  uint32_t t; // the time, read without cost by the test
+  uint32_t readUs; // a now() takes this long
+  uint32_t wakeLateUs; // a sleep returns this much after the time asked for
+  uint32_t sleeps;
+  uint32_t sleptUs;
+
+  MockClock(uint32_t start) : t(start), readUs(1), wakeLateUs(0), sleeps(0), sleptUs(0) {}
+  uint32_t now() { uint32_t at = t; t += readUs; return at; }
+  void sleep(uint32_t us) { sleeps++; sleptUs += us; t += us + wakeLateUs; }
+};
+
+typedef FramePacer<MockClock, FRAME_US, SPIN_US> Pacer;
+
+static uint32_t seed = 5263;
+
+static uint32_t next() {
+  seed = seed*1103515245+12345;
+  return seed>>8 ^ seed<<13;
+}
+
+// plays frames of the given work times, checks every frame starts on its tick (within the
+// spin loop's last read) and returns the summed work
+static uint64_t play(MockClock &clock, Pacer &pacer, uint32_t frames, uint32_t minWork, uint32_t maxWork) {
+  uint32_t tick = clock.t;
+  uint64_t work = 0;
+  pacer.start();
+  for (uint32_t f=0; f<frames; f++) {
+    uint32_t w = minWork + next() % (maxWork-minWork+1);
+    clock.t += w;
+    work += w;
+    pacer.wait();
+    tick += FRAME_US;
+    TEST_ASSERT_TRUE((int32_t)(clock.t-tick) >= 0); // never early
+    TEST_ASSERT_TRUE(clock.t-tick <= 2*clock.readUs); // the read that saw the tick and the one after it
+  }
+  return work;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_idle_time_is_slept_and_frames_start_on_their_tick() {
+  MockClock clock(1000);
+  clock.wakeLateUs = 50; // the timer and the task notification
+  Pacer pacer(clock);
+  uint64_t work = play(clock, pacer, 3000, 2000, 20000);
+  const PacerStats *s = pacer.getStats();
+  TEST_ASSERT_EQUAL_UINT32(3000, s->frames);
+  TEST_ASSERT_EQUAL_UINT32(0, s->overruns);
+  TEST_ASSERT_EQUAL_UINT32(0, s->lateWakes);
+  TEST_ASSERT_EQUAL_UINT32(3000, clock.sleeps);
+  TEST_ASSERT_TRUE(s->jitterMaxUs <= 1);
+  // the idle time is the frame minus the work (and the read that ended the frame)
+  TEST_ASSERT_TRUE(s->idleUs <= 3000ULL*FRAME_US-work && s->idleUs+3000*2 >= 3000ULL*FRAME_US-work);
+  // all of it asleep but the spin margin, which the late wake eats into
+  TEST_ASSERT_TRUE(s->sleptUs+3000ULL*(SPIN_US-50+2) >= s->idleUs);
+  char msg[128];
+  snprintf(msg, sizeof(msg), "idle %.1f%% of the frames, %.1f%% of it slept, jitter max %u us",
+           100.0*s->idleUs/(3000.0*FRAME_US), 100.0*s->sleptUs/s->idleUs, s->jitterMaxUs);
+  TEST_MESSAGE(msg);
+}
+
+void test_late_wakes_are_counted_and_delay_the_frame() {
+  MockClock clock(1000);
+  clock.wakeLateUs = SPIN_US+300;
+  Pacer pacer(clock);
+  pacer.start();
+  for (int f=0; f<10; f++) { clock.t += 5000; pacer.wait(); }
+  const PacerStats *s = pacer.getStats();
+  TEST_ASSERT_EQUAL_UINT32(10, s->lateWakes);
+  TEST_ASSERT_EQUAL_UINT32(10, clock.sleeps);
+  TEST_ASSERT_TRUE(s->jitterMaxUs >= 300 && s->jitterMaxUs <= 302); // the wake, plus the read after it
+  TEST_ASSERT_EQUAL_UINT32(0, s->overruns); // the timeline is kept, only the start of the frame moved
+}
+
+void test_short_idle_is_spun_without_a_sleep() {
+  MockClock clock(1000);
+  Pacer pacer(clock);
+  play(clock, pacer, 100, FRAME_US-SPIN_US+1, FRAME_US-10);
+  TEST_ASSERT_EQUAL_UINT32(0, clock.sleeps);
+  TEST_ASSERT_EQUAL_UINT32(0, pacer.getStats()->sleptUs);
+  TEST_ASSERT_EQUAL_UINT32(0, pacer.getStats()->overruns);
+}
+
+void test_an_overrun_restarts_the_timeline_without_catching_up() {
+  MockClock clock(1000);
+  Pacer pacer(clock);
+  pacer.start();
+  clock.t += 10000; pacer.wait();
+  uint32_t tick = clock.t;
+  clock.t += FRAME_US+5000; // one frame's work takes too long
+  uint32_t end = clock.t;
+  pacer.wait();
+  TEST_ASSERT_EQUAL_UINT32(1, pacer.getStats()->overruns);
+  TEST_ASSERT_EQUAL_UINT32(end+1, clock.t); // returns at once
+  TEST_ASSERT_TRUE(clock.t-tick > FRAME_US);
+  clock.t += 10000; pacer.wait(); // the next frame is a whole frame after the late one ended
+  TEST_ASSERT_TRUE(clock.t-end >= FRAME_US && clock.t-end <= FRAME_US+2);
+  TEST_ASSERT_EQUAL_UINT32(1, pacer.getStats()->overruns);
+}
+
+void test_the_clock_wraps_around() {
+  MockClock clock(0xffffffffu-10*FRAME_US); // micros() wraps after 71 minutes
+  clock.wakeLateUs = 50;
+  Pacer pacer(clock);
+  play(clock, pacer, 100, 1000, 30000);
+  TEST_ASSERT_TRUE(clock.t<0xffffffffu-10*FRAME_US); // it did wrap
+  TEST_ASSERT_EQUAL_UINT32(0, pacer.getStats()->overruns);
+  TEST_ASSERT_EQUAL_UINT32(0, pacer.getStats()->lateWakes);
+  TEST_ASSERT_TRUE(pacer.getStats()->jitterMaxUs <= 1);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_idle_time_is_slept_and_frames_start_on_their_tick);
+  RUN_TEST(test_late_wakes_are_counted_and_delay_the_frame);
+  RUN_TEST(test_short_idle_is_spun_without_a_sleep);
+  RUN_TEST(test_an_overrun_restarts_the_timeline_without_catching_up);
+  RUN_TEST(test_the_clock_wraps_around);
+  return UNITY_END();
+}
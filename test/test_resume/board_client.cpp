@@ -0,0 +1,8 @@
+// the board playing the client
+#define EMU_NS client
+#define EMU_FIRMWARE clientFirmware
+#define EMU_NAME "client"
+#include "../../emu/firmware.h"
+#include "probe.h"
+
+BOARD_PROBE(client, clientProbe)
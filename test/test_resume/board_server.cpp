@@ -0,0 +1,8 @@
+// the board playing the server
+#define EMU_NS server
+#define EMU_FIRMWARE serverFirmware
+#define EMU_NAME "server"
+#include "../../emu/firmware.h"
+#include "probe.h"
+
+BOARD_PROBE(server, serverProbe)
@@ -0,0 +1,37 @@
+// what test_resume reads of a board, the same for both copies of the firmware
+struct BoardProbe {
+  bool (*playing)(); // in a rally
+  bool (*resuming)();
+  bool (*isServer)();
+  uint32_t (*lastFrameReceived)(); // the last frame the other side's input came for
+  uint32_t (*otherConfirmed)(); // the other side's inputs are known up to this frame
+  uint32_t (*oldestFrame)(); // of the history
+  uint32_t (*currentFrame)();
+  uint32_t (*roundNo)();
+  bool (*state)(uint32_t fid, void *out); // copies that frame's state (as the server sees it) if it is in the history
+  uint32_t (*resumes)();
+  uint32_t (*fallbacks)();
+};
+typedef struct BoardProbe BoardProbe;
+
+#define BOARD_PROBE(ns, name) \
+  BoardProbe name = { \
+    []() { return ns::phase==ns::PHASE_PLAY; }, \
+    []() { return ns::phase==ns::PHASE_RESUME; }, \
+    []() { return ns::isServer; }, \
+    []() { return ns::lastFrameReceived; }, \
+    []() { return ns::otherConfirmed; }, \
+    []() { return ns::oldestState()->frameID; }, \
+    []() { return ns::curState()->frameID; }, \
+    []() { return ns::roundNo; }, \
+    [](uint32_t fid, void *out) { \
+      ns::PongGameState *st = ns::getStateWithID(fid); \
+      if (!st) return false; \
+      ns::PongGameState copy = *st; \
+      if (!ns::isServer) ns::mirrorState<ns::Arena>(&copy); \
+      memcpy(out, &copy, sizeof(copy)); \
+      return true; \
+    }, \
+    []() { return ns::metrics.resumes; }, \
+    []() { return ns::metrics.fallbacks; }, \
+  };
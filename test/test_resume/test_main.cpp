@@ -0,0 +1,115 @@
+#include <unity.h>
+
+/**********
+** Resuming a rally
+**   two emulated boards play a networked match (see emu/emu.h) until the rally is under
+**   way, then every connection between them is reset; both have to reconnect and go on
+**   with the same rally from the last frame the server had the client's input for, their
+**   states equal frame by frame (the client's mirrored), and the time from the cut until
+**   both play again is reported and has to stay under RESUME_BOUND_MS
+***********/
+#include "../../emu/emu.cpp"
+#include "../../src/gamestate.h"
+#include "probe.h"
+
+#define CUT_FRAME 45 // of the first rally, the ball is past the middle
+#define RESUME_BOUND_MS 100 // three frames: a frame on each board to notice and a round trip, far below RESUME_TIMEOUT
+#define PLAY_ON_US 2000000 // after the resume, unless the rally ends first
+#define LIMIT_US 60000000ULL
+
+extern EmuFirmware serverFirmware, clientFirmware;
+extern BoardProbe serverProbe, clientProbe;
+
+static bool rallyUnderWay() {
+  return serverProbe.playing() && clientProbe.playing() && serverProbe.currentFrame()>=CUT_FRAME;
+}
+
+static bool serverResumed = false, clientResumed = false;
+
+static bool bothResumed() {
+  serverResumed |= serverProbe.resuming();
+  clientResumed |= clientProbe.resuming();
+  return serverResumed && clientResumed && serverProbe.playing() && clientProbe.playing();
+}
+
+// every frame from first to last both histories hold has to be the same on both boards, returns how many were
+static uint32_t compareStates(uint32_t first, uint32_t last, const char *when) {
+  uint32_t compared = 0;
+  for (uint32_t fid=first; fid<=last; fid++) {
+    PongGameState s, c;
+    if (!serverProbe.state(fid, &s) || !clientProbe.state(fid, &c)) continue;
+    if (memcmp(&s, &c, sizeof(PongGameState))) {
+      char msg[96];
+      snprintf(msg, sizeof(msg), "%s: frame %u differs between the boards", when, fid);
+      TEST_FAIL_MESSAGE(msg);
+    }
+    compared++;
+  }
+  return compared;
+}
+
+static uint64_t playOnUntil = 0;
+static uint32_t resumedRound = 0, checkedUpTo = 0, comparedAfter = 0;
+
+// the frames both boards have confirmed since the last look, until the rally ends
+static bool playedOn() {
+  if (!serverProbe.playing() || !clientProbe.playing() || serverProbe.roundNo()!=resumedRound) return true;
+  uint32_t last = std::min(serverProbe.otherConfirmed(), clientProbe.otherConfirmed());
+  if (last>checkedUpTo) {
+    comparedAfter += compareStates(checkedUpTo+1, last, "after the resume");
+    checkedUpTo = last;
+  }
+  return emuTime()>=playOnUntil;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_rally_resumes_after_a_cut() {
+  EmuConfig config = { 2000, 1000, 1, false };
+  emuInit(&config);
+  emuAddBoard(&serverFirmware, serverFirmware.serverID, 0);
+  emuAddBoard(&clientFirmware, serverFirmware.serverID+1, 700000);
+  TEST_ASSERT_TRUE_MESSAGE(emuRun(LIMIT_US, rallyUnderWay), "the first rally did not start");
+  TEST_ASSERT_TRUE(serverProbe.isServer() && !clientProbe.isServer());
+
+  uint32_t round = serverProbe.roundNo(), cutFrame = serverProbe.currentFrame();
+  uint32_t confirmed = serverProbe.lastFrameReceived();
+  uint64_t cutAt = emuTime();
+  emuCutLinks();
+  TEST_ASSERT_TRUE_MESSAGE(emuRun(cutAt+LIMIT_US, bothResumed), "the boards did not resume");
+  double resumeMs = (emuTime()-cutAt)/1000.0;
+
+  // the same rally, the client's history rebuilt from the server's last confirmed frame on
+  TEST_ASSERT_EQUAL_UINT32(1, serverProbe.resumes());
+  TEST_ASSERT_EQUAL_UINT32(1, clientProbe.resumes());
+  TEST_ASSERT_EQUAL_UINT32(0, serverProbe.fallbacks()+clientProbe.fallbacks());
+  TEST_ASSERT_EQUAL_UINT32(round, serverProbe.roundNo());
+  TEST_ASSERT_EQUAL_UINT32(round, clientProbe.roundNo());
+  TEST_ASSERT_TRUE(clientProbe.currentFrame()>cutFrame);
+  TEST_ASSERT_TRUE(serverProbe.lastFrameReceived()>=confirmed);
+  TEST_ASSERT_EQUAL_UINT32(serverProbe.lastFrameReceived(), clientProbe.oldestFrame());
+  uint32_t compared = compareStates(clientProbe.oldestFrame(), clientProbe.otherConfirmed(), "at the resume");
+  TEST_ASSERT_TRUE(compared>0);
+
+  char msg[128];
+  snprintf(msg, sizeof(msg), "resumed in %.1f ms (bound %d ms) from frame %u, the link was cut at frame %u",
+           resumeMs, RESUME_BOUND_MS, clientProbe.oldestFrame(), cutFrame);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE_MESSAGE(resumeMs<RESUME_BOUND_MS, "the resume took too long");
+
+  // play goes on in step: what both have confirmed is the same on both boards
+  resumedRound = round;
+  checkedUpTo = clientProbe.otherConfirmed();
+  playOnUntil = emuTime()+PLAY_ON_US;
+  emuRun(playOnUntil, playedOn);
+  snprintf(msg, sizeof(msg), "%u confirmed frames after the resume equal on both boards, up to frame %u", comparedAfter, checkedUpTo);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(comparedAfter>0);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rally_resumes_after_a_cut);
+  return UNITY_END();
+}
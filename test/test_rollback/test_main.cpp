@@ -0,0 +1,106 @@
+#include <unity.h>
+
+/**********
+** Rollback equivalence
+**   rollbackOther patches the other paddle in closed form and resimulates the ball only
+**   from where it reaches the paddle's line; on random histories it has to leave every
+**   frame exactly as replaying recalcFrame on all of them does
+***********/
+#include "../../src/arena.h"
+#include "../../src/physics.h"
+#include "../../src/gamestate.cpp"
+#include "../../src/helper.cpp"
+
+typedef SSD1306Arena Arena;
+
+#define HISTORIES 200000
+#define MAX_FRAMES 150 // longer than the ring, so the oldest frames get dropped too
+
+static uint32_t seed = 5263;
+
+static uint32_t next() {
+  seed = seed*1103515245+12345;
+  return seed>>8 ^ seed<<13;
+}
+
+static int32_t between(int32_t lo, int32_t hi) { return lo + (int32_t)(next() % (uint32_t)(hi-lo+1)); }
+
+// a rally from a random moment: the ball anywhere (also behind the paddles) at any speed up to
+// a hundred times the serve, the paddles steered in runs like a player or the AI does
+static uint32_t randomHistory() {
+  initBuffer();
+  bufferAdd();
+  PongGameState *state = curState();
+  memset(state, 0, sizeof(PongGameState));
+  state->frameID = next() % 1000000;
+  state->posSelf = between(Arena::paddleMin, Arena::paddleMax);
+  state->posOther = between(Arena::paddleMin, Arena::paddleMax);
+  state->posBallX = between(-Arena::ballRadius*1000, Arena::wallLength+Arena::ballRadius*1000);
+  state->posBallY = between(Arena::wallTop, Arena::wallBottom);
+  int32_t speed = next()%4 ? 450 : 4500;
+  state->speedBallX = between(-speed, speed);
+  state->speedBallY = between(-speed, speed);
+  uint32_t frames = between(1, MAX_FRAMES);
+  int8_t dirSelf = 0, dirOther = 0;
+  for (uint32_t f=0; f<frames; f++) {
+    if (next()%8==0) dirSelf = next()%3-1;
+    if (next()%8==0) dirOther = next()%3-1;
+    PongGameState *pState = curState();
+    PongGameState *st = copyLatestState();
+    st->dirSelf = dirSelf;
+    st->dirOther = dirOther;
+    recalcFrame<Arena>(st, pState);
+  }
+  return frames;
+}
+
+// the history from the oldest frame on, as a plain array
+static uint32_t snapshot(PongGameState *out) {
+  uint32_t n = 0;
+  for (PongGameState *st = oldestState(); st; st = nextState(st)) out[n++] = *st;
+  return n;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_patched_history_equals_full_replay() {
+  static PongGameState expected[GAMESTATE_BUFFER_SIZE], actual[GAMESTATE_BUFFER_SIZE];
+  uint32_t resimulated = 0;
+  for (uint32_t h=0; h<HISTORIES; h++) {
+    randomHistory();
+    uint32_t n = snapshot(expected);
+    uint32_t from = next() % n;
+    int8_t dir = next()%3-1;
+    // the reference: every frame from the changed one recalculated (the oldest has nothing to replay from)
+    for (uint32_t i=from; i<n; i++) {
+      expected[i].dirOther = dir;
+      if (i>0) recalcFrame<Arena>(&expected[i], &expected[i-1]);
+    }
+    for (uint32_t i=std::max(from, 1u); i<n; i++) if (reachesOtherLine<Arena>(&expected[i-1])) { resimulated++; break; }
+    TEST_ASSERT_TRUE(rollbackOther<Arena>(expected[from].frameID, dir));
+    TEST_ASSERT_EQUAL_UINT32(n, snapshot(actual));
+    if (memcmp(expected, actual, n*sizeof(PongGameState))) {
+      char msg[96];
+      snprintf(msg, sizeof(msg), "history %u: %u frames, rolled back from frame %u to %d", h, n, from, dir);
+      TEST_FAIL_MESSAGE(msg);
+    }
+  }
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%d histories, %u of them resimulated the ball", HISTORIES, resimulated);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(resimulated>HISTORIES/20); // both paths were taken
+}
+
+void test_a_frame_out_of_the_history_is_refused() {
+  randomHistory();
+  TEST_ASSERT_FALSE(rollbackOther<Arena>(oldestState()->frameID-1, 1));
+  TEST_ASSERT_FALSE(rollbackOther<Arena>(curState()->frameID+1, 1));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_patched_history_equals_full_replay);
+  RUN_TEST(test_a_frame_out_of_the_history_is_refused);
+  return UNITY_END();
+}
@@ -0,0 +1,234 @@
+#include <unity.h>
+
+/**********
+** Delivery over a bad cable
+**   two FrameLinks of src/serialframe.h talk through a mock wire that drops, damages and cuts
+**   frames, adds line noise and takes its time; every byte written has to come out on the
+**   other side exactly once and in order, also across a reset of either side
+***********/
+#include "../../src/serialframe.cpp"
+
+#include <deque>
+#include <vector>
+
+#define WIRE_MS 1 // a frame takes this long to arrive (2 Mbaud, and the receive task's poll)
+
+static uint32_t seed = 5263;
+
+static uint32_t next() {
+  seed = seed*1103515245+12345;
+  return seed>>8 ^ seed<<13;
+}
+
+static uint32_t now = 0; // the clock of both boards
+
+struct Damage {
+  uint32_t dropPerMille; // the frame never arrives
+  uint32_t flipPerMille; // a bit of it flips
+  uint32_t cutPerMille; // it ends early
+  uint32_t noisePerMille; // garbage in front of it
+};
+
+struct Chunk {
+  uint32_t at;
+  std::vector<uint8_t> bytes;
+};
+
+// one direction of the cable
+struct MockWire {
+  Damage damage;
+  bool dark; // unplugged
+  std::deque<Chunk> flying;
+  std::vector<uint8_t> arrived;
+  uint32_t frames;
+
+  MockWire() : dark(false), frames(0) { memset(&damage, 0, sizeof(damage)); }
+
+  void send(const uint8_t *buf, size_t len) {
+    frames++;
+    if (dark || next()%1000 < damage.dropPerMille) return;
+    Chunk chunk;
+    chunk.at = now+WIRE_MS;
+    if (next()%1000 < damage.noisePerMille)
+      for (uint32_t n=next()%6+1; n; n--) chunk.bytes.push_back(next()%3 ? next() : FRAME_SYNC);
+    chunk.bytes.insert(chunk.bytes.end(), buf, buf+len);
+    if (next()%1000 < damage.flipPerMille) chunk.bytes[chunk.bytes.size()-1-next()%len] ^= 1<<(next()%8);
+    if (next()%1000 < damage.cutPerMille) chunk.bytes.resize(chunk.bytes.size()-1-next()%len);
+    flying.push_back(chunk);
+  }
+
+  void deliver() {
+    while (!flying.empty() && (int32_t)(now-flying.front().at) >= 0) {
+      arrived.insert(arrived.end(), flying.front().bytes.begin(), flying.front().bytes.end());
+      flying.pop_front();
+    }
+  }
+};
+
+struct MockPort {
+  MockWire *in, *out;
+
+  MockPort(MockWire *in, MockWire *out) : in(in), out(out) {}
+
+  int available() { in->deliver(); return in->arrived.size(); }
+  size_t readBytes(uint8_t *buf, size_t len) {
+    len = std::min(len, in->arrived.size());
+    memcpy(buf, &in->arrived[0], len);
+    in->arrived.erase(in->arrived.begin(), in->arrived.begin()+len);
+    return len;
+  }
+  size_t write(const uint8_t *buf, size_t len) { out->send(buf, len); return len; }
+  uint32_t millis() { return now; }
+};
+
+// a board: writes random messages, reads whatever arrived
+struct Board {
+  MockPort port;
+  FrameLink<MockPort> link;
+  std::vector<uint8_t> sent, received;
+  uint32_t refused; // writes of a full window
+
+  Board(MockWire *in, MockWire *out) : port(in, out), link(port), refused(0) {}
+
+  void writeSome(uint32_t perMille) {
+    if (next()%1000 >= perMille) return;
+    uint8_t msg[FRAME_MAX_PAYLOAD];
+    uint32_t len = next()%8 ? next()%14+1 : next()%FRAME_MAX_PAYLOAD+1; // mostly direction changes, some resumes
+    for (uint32_t i=0; i<len; i++) msg[i] = next();
+    if (link.write(msg, len)==len) sent.insert(sent.end(), msg, msg+len);
+    else refused++;
+  }
+
+  void readAll() {
+    uint8_t buf[64];
+    while (link.available()>0) {
+      int n = link.read(buf, next()%sizeof(buf)+1);
+      received.insert(received.end(), buf, buf+n);
+    }
+  }
+};
+
+static MockWire aToB, bToA;
+
+static void reset(const Damage &damage) {
+  aToB = MockWire(); bToA = MockWire();
+  aToB.damage = damage; bToA.damage = damage;
+  now = 0;
+}
+
+// both boards busy for a while, the writes stop some time before the end so the last frames make it
+static void play(Board &a, Board &b, uint32_t ms, uint32_t perMille) {
+  for (uint32_t end=now+ms; now!=end; now++) {
+    bool writing = end-now > 500;
+    if (writing) { a.writeSome(perMille); b.writeSome(perMille); }
+    a.readAll(); b.readAll();
+  }
+}
+
+static void assertSameBytes(const std::vector<uint8_t> &sent, const std::vector<uint8_t> &received) {
+  TEST_ASSERT_EQUAL_UINT32(sent.size(), received.size());
+  if (sent.size()) TEST_ASSERT_EQUAL_HEX8_ARRAY(&sent[0], &received[0], sent.size());
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_frame_layout() {
+  const uint8_t payload[] = { 'C', 1, 2 };
+  uint8_t frame[FRAME_MAX_SIZE];
+  TEST_ASSERT_EQUAL_UINT32(3+FRAME_OVERHEAD, encodeFrame(frame, payload, 3, 7, 200));
+  uint16_t crc = crc16(frame+1, 6);
+  const uint8_t expected[] = { FRAME_SYNC, 3, 7, 200, 'C', 1, 2, (uint8_t)crc, (uint8_t)(crc>>8) };
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, frame, sizeof(expected));
+  uint32_t len = 99;
+  TEST_ASSERT_EQUAL_INT32(3+FRAME_OVERHEAD, decodeFrame(frame, sizeof(expected), &len));
+  TEST_ASSERT_EQUAL_UINT32(3, len);
+  TEST_ASSERT_EQUAL_INT32(0, decodeFrame(frame, sizeof(expected)-1, &len)); // not all there yet
+  frame[5] ^= 4;
+  TEST_ASSERT_EQUAL_INT32(-1, decodeFrame(frame, sizeof(expected), &len));
+  TEST_ASSERT_EQUAL_UINT32(FRAME_OVERHEAD, encodeFrame(frame, NULL, 0, 0, 1)); // a bare acknowledge
+  TEST_ASSERT_EQUAL_INT32(FRAME_OVERHEAD, decodeFrame(frame, FRAME_OVERHEAD, &len));
+  TEST_ASSERT_EQUAL_UINT32(0, len);
+  TEST_ASSERT_EQUAL_UINT32(0, encodeFrame(frame, payload, FRAME_MAX_PAYLOAD+1, 0, 0));
+}
+
+void test_every_byte_arrives_once_and_in_order_over_a_bad_cable() {
+  Damage damage = { 50, 20, 10, 20 }; // one frame in ten lost or damaged
+  reset(damage);
+  Board a(&bToA, &aToB), b(&aToB, &bToA);
+  play(a, b, 60000, 300);
+  assertSameBytes(a.sent, b.received);
+  assertSameBytes(b.sent, a.received);
+  const FrameLinkStats *sa = a.link.getStats(), *sb = b.link.getStats();
+  char msg[160];
+  snprintf(msg, sizeof(msg), "%u bytes each way in %u frames, %u frames resent, %u bad spots and %u out of order skipped, %u writes refused",
+           (unsigned)a.sent.size(), aToB.frames, sa->resentFrames, sb->badFrames, sb->dupFrames, a.refused);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(a.sent.size()>100000 && b.sent.size()>100000);
+  TEST_ASSERT_TRUE(sa->resentFrames>0 && sb->resentFrames>0);
+  TEST_ASSERT_TRUE(sa->badFrames>0 && sb->badFrames>0);
+  TEST_ASSERT_TRUE(sa->dupFrames>0 && sb->dupFrames>0); // the frames after a lost one came twice
+}
+
+void test_a_clean_cable_resends_nothing() {
+  Damage clean = { 0, 0, 0, 0 };
+  reset(clean);
+  Board a(&bToA, &aToB), b(&aToB, &bToA);
+  play(a, b, 10000, 500);
+  assertSameBytes(a.sent, b.received);
+  assertSameBytes(b.sent, a.received);
+  TEST_ASSERT_EQUAL_UINT32(0, a.link.getStats()->resentFrames+b.link.getStats()->resentFrames);
+  TEST_ASSERT_EQUAL_UINT32(0, a.link.getStats()->badFrames+b.link.getStats()->badFrames);
+  TEST_ASSERT_EQUAL_UINT32(0, a.refused+b.refused);
+}
+
+void test_a_full_window_refuses_writes_until_acknowledged() {
+  Damage clean = { 0, 0, 0, 0 };
+  reset(clean);
+  Board a(&bToA, &aToB), b(&aToB, &bToA);
+  const uint8_t msg[] = { 'K' };
+  for (int i=0; i<FRAME_WINDOW; i++) TEST_ASSERT_EQUAL_UINT32(1, a.link.write(msg, 1));
+  TEST_ASSERT_EQUAL_UINT32(0, a.link.write(msg, 1)); // b has not read anything yet
+  now += WIRE_MS;
+  b.readAll();
+  TEST_ASSERT_EQUAL_UINT32(FRAME_WINDOW, b.received.size());
+  now += WIRE_MS;
+  a.readAll(); // takes b's acknowledge
+  TEST_ASSERT_EQUAL_UINT32(1, a.link.write(msg, 1));
+}
+
+void test_the_side_that_resets_later_gets_the_new_stream() {
+  Damage clean = { 0, 0, 0, 0 };
+  reset(clean);
+  Board a(&bToA, &aToB), b(&aToB, &bToA);
+  play(a, b, 5000, 300); // a session, a few hundred frames each way
+  aToB.dark = bToA.dark = true; // the cable comes loose
+  play(a, b, 1000, 300);
+  aToB.dark = bToA.dark = false;
+  // a times out first and starts over with a resume, b still holds the old session
+  a.link.reset(); a.sent.clear(); a.received.clear();
+  const uint8_t resume[] = "RESUME";
+  TEST_ASSERT_EQUAL_UINT32(6, a.link.write(resume, 6));
+  b.received.clear();
+  for (uint32_t end=now+200; now!=end; now++) { a.readAll(); b.readAll(); }
+  TEST_ASSERT_EQUAL_UINT32(0, b.received.size()); // a frame numbered from the start is not the one b expects
+  b.link.reset(); b.sent.clear();
+  for (uint32_t end=now+200; now!=end; now++) { a.readAll(); b.readAll(); }
+  TEST_ASSERT_EQUAL_UINT32(6, b.received.size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(resume, &b.received[0], 6);
+  TEST_ASSERT_EQUAL_UINT32(0, a.received.size()); // nothing of b's old session got through
+  a.sent.assign(resume, resume+6);
+  play(a, b, 5000, 300);
+  assertSameBytes(a.sent, b.received);
+  assertSameBytes(b.sent, a.received);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_frame_layout);
+  RUN_TEST(test_every_byte_arrives_once_and_in_order_over_a_bad_cable);
+  RUN_TEST(test_a_clean_cable_resends_nothing);
+  RUN_TEST(test_a_full_window_refuses_writes_until_acknowledged);
+  RUN_TEST(test_the_side_that_resets_later_gets_the_new_stream);
+  return UNITY_END();
+}
@@ -0,0 +1,214 @@
+#include <unity.h>
+
+/**********
+** Spectator streaming over loopback sockets
+**   the server side is src/spectator.cpp unmodified (the emulator's stand-ins run on real
+**   sockets outside of the boards), the spectators are plain sockets of this test
+***********/
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+// lwIP's send buffer counts bytes and takes a part of a write when it is nearly full, Linux takes
+// small writes whole; the ones to a slow spectator are cut here (lwIP's sockets.h maps send() to
+// lwip_send() the same way)
+#define HOST_MAX_FD 4096
+bool partialWrites[HOST_MAX_FD];
+uint32_t partialSeed=5264;
+
+static ssize_t lwip_send(int fd, const void *buf, size_t len, int flags) {
+  if (fd>=0 && fd<HOST_MAX_FD && partialWrites[fd] && len>1) {
+    partialSeed=partialSeed*1103515245+12345;
+    len=1+(partialSeed>>16) % (len-1);
+  }
+  return send(fd, buf, len, flags);
+}
+#define send lwip_send
+
+#define SPECTATOR_MAX 256 // instead of lwIP's handful, the buffer sizing must hold for any count
+#include "../../src/spectator.cpp"
+#include "../../src/wire.cpp"
+#include "../../src/metrics.cpp"
+#include "../../emu/emu.cpp"
+
+const char* CMD_FULLGAMESTATE="FLGMST";
+
+#define VIEWERS 200
+#define VIEWER_BUFFER 4096
+#define HOST_SNDBUF 4096 // lwIP's TCP_SND_BUF is about this small, Linux would buffer megabytes
+#define VIEWER_RCVBUF 2048 // so a spectator not reading stalls within a few hundred frames
+
+enum ViewerKind { VIEW_ALL, VIEW_SLOW, VIEW_NONE }; // reads everything, a few bytes a frame, nothing
+
+struct Viewer {
+  int fd;
+  ViewerKind kind;
+  uint8_t buf[VIEWER_BUFFER];
+  size_t len;
+  uint32_t frames; // game states received
+  uint32_t lastFrame; // frameID of the last one
+  uint32_t snapshots; // metrics snapshots received
+  bool broken; // garbage in the stream or a frame out of order
+};
+Viewer viewers[VIEWERS];
+
+static void connectViewers(int n) {
+  for (int i=0; i<n; i++) {
+    Viewer *v=&viewers[i];
+    memset(v, 0, sizeof(Viewer));
+    v->fd=socket(AF_INET, SOCK_STREAM, 0);
+    int size=VIEWER_RCVBUF;
+    setsockopt(v->fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family=AF_INET;
+    addr.sin_port=htons(SPECTATOR_PORT);
+    addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+    TEST_ASSERT_EQUAL_INT(0, connect(v->fd, (sockaddr *)&addr, sizeof(addr)));
+    fcntl(v->fd, F_SETFL, O_NONBLOCK);
+  }
+  for (int tries=0; spectatorCount()<n && tries<100000; tries++) spectatorService(); // one accept per call
+  TEST_ASSERT_EQUAL_INT(n, spectatorCount());
+  for (int i=0; i<SPECTATOR_MAX; i++) {
+    if (!spectators[i].active) continue;
+    int fd=spectators[i].clnt.fd(), size=HOST_SNDBUF;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    TEST_ASSERT_TRUE(fd<HOST_MAX_FD);
+    partialWrites[fd]=false;
+  }
+}
+
+// the server's end of each viewer's connection gets its writes cut
+static void cutWrites(int n, ViewerKind kind) {
+  for (int i=0; i<SPECTATOR_MAX; i++) {
+    if (!spectators[i].active) continue;
+    int fd=spectators[i].clnt.fd();
+    sockaddr_in peer, local;
+    socklen_t len=sizeof(peer);
+    getpeername(fd, (sockaddr *)&peer, &len);
+    for (int j=0; j<n; j++) {
+      len=sizeof(local);
+      getsockname(viewers[j].fd, (sockaddr *)&local, &len);
+      if (local.sin_port==peer.sin_port) partialWrites[fd]=viewers[j].kind==kind;
+    }
+  }
+}
+
+static void closeViewers(int n) {
+  for (int i=0; i<n; i++) close(viewers[i].fd);
+  for (int tries=0; spectatorCount()>0 && tries<1000; tries++) spectatorService();
+  TEST_ASSERT_EQUAL_INT(0, spectatorCount());
+}
+
+// reads up to max bytes and takes the complete messages out of the stream
+static void readViewer(Viewer *v, size_t max) {
+  size_t room=std::min(max, VIEWER_BUFFER-v->len);
+  int n=recv(v->fd, v->buf+v->len, room, 0);
+  if (n>0) v->len+=n;
+  size_t at=0;
+  while (v->len-at>=6) {
+    uint8_t *msg=v->buf+at;
+    if (memcmp(msg, "FLGMST", 6)==0) {
+      if (v->len-at<SPECTATOR_FRAME_SIZE) break;
+      PongGameStateView view(msg+6);
+      if (!view.valid() || (v->frames>0 && view.frameID()<=v->lastFrame)) v->broken=true;
+      v->lastFrame=view.frameID();
+      v->frames++;
+      at+=SPECTATOR_FRAME_SIZE;
+    } else if (memcmp(msg, "FLGMET", 6)==0) {
+      if (v->len-at<METRICS_WIRE_SIZE) break;
+      v->snapshots++;
+      at+=METRICS_WIRE_SIZE;
+    } else {
+      v->broken=true;
+      at=v->len;
+    }
+  }
+  memmove(v->buf, v->buf+at, v->len-at);
+  v->len-=at;
+}
+
+static void readViewers(int n) {
+  for (int i=0; i<n; i++) {
+    if (viewers[i].kind==VIEW_ALL) readViewer(&viewers[i], VIEWER_BUFFER);
+    else if (viewers[i].kind==VIEW_SLOW) readViewer(&viewers[i], SPECTATOR_FRAME_SIZE/2);
+  }
+}
+
+// plays frames 1..frames, returns the us spent in the spectator code
+static uint32_t stream(int n, uint32_t frames) {
+  PongGameState state;
+  memset(&state, 0, sizeof(state));
+  uint32_t busy=0;
+  for (uint32_t f=1; f<=frames; f++) {
+    state.frameID=f;
+    state.posBallX=f*1000;
+    uint32_t start=micros();
+    spectatorPublish(&state);
+    spectatorService();
+    busy+=micros()-start;
+    readViewers(n);
+  }
+  for (int i=0; i<20; i++) { spectatorService(); readViewers(n); } // drain
+  return busy;
+}
+
+void setUp() {
+  spectatorInit();
+}
+
+void tearDown() {}
+
+void test_every_frame_reaches_every_spectator() {
+  connectViewers(VIEWERS);
+  for (int i=0; i<VIEWERS; i++) viewers[i].kind=VIEW_ALL;
+  uint32_t frames=1000;
+  uint32_t busy=stream(VIEWERS, frames);
+  for (int i=0; i<VIEWERS; i++) {
+    TEST_ASSERT_FALSE(viewers[i].broken);
+    TEST_ASSERT_EQUAL_UINT32(frames, viewers[i].frames);
+  }
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%d spectators: %.2f us per spectator and frame", VIEWERS, (double)busy/frames/VIEWERS);
+  TEST_MESSAGE(msg);
+  closeViewers(VIEWERS);
+}
+
+void test_metrics_snapshot_goes_to_the_asking_spectator() {
+  connectViewers(VIEWERS);
+  for (int i=0; i<VIEWERS; i++) viewers[i].kind=VIEW_ALL;
+  for (int i=0; i<VIEWERS; i+=2) TEST_ASSERT_EQUAL_INT(1, send(viewers[i].fd, "M", 1, 0));
+  stream(VIEWERS, 200);
+  for (int i=0; i<VIEWERS; i++) {
+    TEST_ASSERT_FALSE(viewers[i].broken);
+    TEST_ASSERT_EQUAL_UINT32(200, viewers[i].frames); // a snapshot never displaces a frame of a spectator keeping up
+    TEST_ASSERT_EQUAL_UINT32(i%2==0 ? 1 : 0, viewers[i].snapshots);
+  }
+  closeViewers(VIEWERS);
+}
+
+void test_slow_spectators_skip_ahead_and_stalled_ones_are_dropped() {
+  connectViewers(VIEWERS);
+  for (int i=0; i<VIEWERS; i++) viewers[i].kind=(ViewerKind)(i%3);
+  cutWrites(VIEWERS, VIEW_SLOW); // each one keeps an older frame it is still writing
+  for (int i=0; i<VIEWERS; i+=5) send(viewers[i].fd, "M", 1, 0); // snapshots on top, from all kinds
+  uint32_t frames=3000;
+  stream(VIEWERS, frames);
+  int stalled=0;
+  for (int i=0; i<VIEWERS; i++) {
+    Viewer *v=&viewers[i];
+    TEST_ASSERT_FALSE(v->broken); // the frame being written is never pulled from under a spectator
+    if (v->kind==VIEW_ALL) TEST_ASSERT_EQUAL_UINT32(frames, v->frames); // the buffers never run out
+    if (v->kind==VIEW_SLOW) TEST_ASSERT_TRUE(v->frames>frames/4 && v->frames<frames); // skipped ahead, but kept
+    if (v->kind==VIEW_NONE) stalled++;
+  }
+  TEST_ASSERT_EQUAL_INT(VIEWERS-stalled, spectatorCount());
+  closeViewers(VIEWERS);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_frame_reaches_every_spectator);
+  RUN_TEST(test_metrics_snapshot_goes_to_the_asking_spectator);
+  RUN_TEST(test_slow_spectators_skip_ahead_and_stalled_ones_are_dropped);
+  return UNITY_END();
+}
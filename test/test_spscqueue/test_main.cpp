@@ -0,0 +1,143 @@
+#include <unity.h>
+
+/**********
+** SPSCQueue under real threads
+**   a producer thread stands in for the receive task, the consumer for the game loop; the
+**   items are the receive task's PongDirChangeMsg, checked for loss, order and torn copies
+***********/
+#include "../../src/spscqueue.h"
+#include "../../src/arena.h"
+#include "../../src/physics.h"
+#include "../../src/gamestate.cpp"
+#include "../../src/helper.cpp"
+
+#include <thread>
+#include <chrono>
+#include <vector>
+
+typedef SSD1306Arena Arena;
+
+static uint32_t nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// every field derived from the sequence number, a torn copy does not add up
+static void makeMsg(PongDirChangeMsg *msg, uint32_t seq) {
+  msg->frameID=seq;
+  msg->direction=(int8_t)(seq % 3)-1;
+  msg->captureTime=seq*2654435761u;
+  msg->sendTime=~seq;
+}
+
+static bool checkMsg(const PongDirChangeMsg *msg, uint32_t seq) {
+  return msg->frameID==seq && msg->direction==(int8_t)(seq % 3)-1 && msg->captureTime==seq*2654435761u && msg->sendTime==~seq;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_high_rate_producer_loses_and_reorders_nothing() {
+  static SPSCQueue<PongDirChangeMsg, 32> queue; // the receive queue's capacity
+  const uint32_t count=2000000;
+  uint32_t fullSpins=0;
+  std::thread producer([&]() {
+    PongDirChangeMsg msg;
+    for (uint32_t seq=0; seq<count; seq++) {
+      makeMsg(&msg, seq);
+      while (!queue.push(msg)) { fullSpins++; std::this_thread::yield(); } // the core may be shared
+    }
+  });
+  uint32_t expected=0, bad=0;
+  while (expected<count) {
+    PongDirChangeMsg *msg=queue.front();
+    if (!msg) { std::this_thread::yield(); continue; }
+    if (!checkMsg(msg, expected)) bad++;
+    queue.pop();
+    expected++;
+  }
+  producer.join();
+  TEST_ASSERT_EQUAL_UINT32(0, bad);
+  TEST_ASSERT_TRUE(queue.empty());
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%u messages, the producer found the queue full %u times", count, fullSpins);
+  TEST_MESSAGE(msg);
+}
+
+/**********
+** Arrival to rollback
+**   the producer delivers direction changes for recent frames at random times, the game
+**   loop drains the queue at the start of each frame and rolls the history back
+***********/
+#define LOOP_FRAMES 90 // 3 seconds of frames
+#define LOOP_FRAME_US 33333
+#define ARRIVAL_GAP_US 4000 // mean gap between two messages, a busy link
+
+struct Arrival {
+  uint32_t rxTime; // stamped by the producer, like decodeNetMsg does
+  uint32_t frame; // the game loop's frame when it was pushed
+  uint32_t seq;
+};
+
+static int percentile(std::vector<uint32_t> &v, int p) {
+  std::sort(v.begin(), v.end());
+  return v.empty() ? 0 : v[std::min(v.size()-1, v.size()*p/100)];
+}
+
+void test_arrival_to_rollback_latency() {
+  static SPSCQueue<Arrival, 32> queue;
+  std::atomic<uint32_t> frame(0);
+  std::atomic<bool> done(false);
+  std::thread producer([&]() {
+    uint32_t seed=5263, seq=0;
+    while (!done.load()) {
+      seed=seed*1103515245+12345;
+      std::this_thread::sleep_for(std::chrono::microseconds((seed>>16) % (2*ARRIVAL_GAP_US)));
+      Arrival a;
+      a.rxTime=nowUs();
+      a.frame=frame.load();
+      a.seq=seq++;
+      queue.push(a);
+    }
+  });
+  // a history of real frames to roll back in
+  initBuffer();
+  bufferAdd();
+  serveBall<Arena>(curState(), 30);
+  std::vector<uint32_t> total, apply;
+  uint32_t late=0, lost=0, nextSeq=0;
+  uint32_t start=nowUs();
+  for (uint32_t f=1; f<=LOOP_FRAMES; f++) {
+    frame.store(f);
+    PongGameState *pState=curState();
+    recalcFrame<Arena>(copyLatestState(), pState);
+    Arrival *a;
+    while ((a=queue.front())) {
+      uint32_t taken=nowUs();
+      if (a->seq!=nextSeq) lost++;
+      nextSeq=a->seq+1;
+      rollbackOther<Arena>(curState()->frameID>8 ? curState()->frameID-8 : 0, (a->seq % 3)-1); // a change 8 frames back
+      uint32_t applied=nowUs();
+      total.push_back(applied-a->rxTime);
+      apply.push_back(applied-taken);
+      if (f>a->frame+2) late++; // waited past the next frame start (one more for a push racing the frame change)
+      queue.pop();
+    }
+    while (nowUs()-start<f*LOOP_FRAME_US) std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  done.store(true);
+  producer.join();
+  TEST_ASSERT_TRUE(total.size()>LOOP_FRAMES);
+  TEST_ASSERT_EQUAL_UINT32(0, lost);
+  TEST_ASSERT_EQUAL_UINT32(0, late); // a message is always in the history by the next frame
+  char msg[160];
+  snprintf(msg, sizeof(msg), "%u messages, arrival to rolled back p50 %d us p99 %d us max %d us, of it the rollback p50 %d us p99 %d us",
+           (uint32_t)total.size(), percentile(total, 50), percentile(total, 99), percentile(total, 100), percentile(apply, 50), percentile(apply, 99));
+  TEST_MESSAGE(msg);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_high_rate_producer_loses_and_reorders_nothing);
+  RUN_TEST(test_arrival_to_rollback_latency);
+  return UNITY_END();
+}
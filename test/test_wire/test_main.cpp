@@ -0,0 +1,136 @@
+#include <unity.h>
+
+/**********
+** Wire encoding of the game state
+**   the layout of src/wire.h byte for byte, round trips of random states through
+**   encodeGameState and PongGameStateView, and the size and speed of the encoding
+***********/
+#include "../../src/wire.cpp"
+
+#include <chrono>
+
+#define ROUNDTRIPS 1000000
+#define INT24_MAX 0x7fffff
+
+static uint32_t seed = 5263;
+
+static uint32_t next() {
+  seed = seed*1103515245+12345;
+  return seed>>8 ^ seed<<13;
+}
+
+static int32_t int24() { return (int32_t)(next() % (2*INT24_MAX+1)) - INT24_MAX; }
+
+static void randomState(PongGameState *state) {
+  state->frameID = next();
+  state->scoreSelf = next() % 64;
+  state->scoreOther = next() % 64;
+  state->dirSelf = next() % 3 - 1;
+  state->dirOther = next() % 3 - 1;
+  state->posSelf = int24();
+  state->posOther = int24();
+  state->posBallX = int24();
+  state->posBallY = int24();
+  state->speedBallX = int24();
+  state->speedBallY = int24();
+}
+
+static void assertSameState(const PongGameState *a, const PongGameState *b) {
+  TEST_ASSERT_EQUAL_UINT32(a->frameID, b->frameID);
+  TEST_ASSERT_EQUAL_UINT8(a->scoreSelf, b->scoreSelf);
+  TEST_ASSERT_EQUAL_UINT8(a->scoreOther, b->scoreOther);
+  TEST_ASSERT_EQUAL_INT8(a->dirSelf, b->dirSelf);
+  TEST_ASSERT_EQUAL_INT8(a->dirOther, b->dirOther);
+  TEST_ASSERT_EQUAL_INT32(a->posSelf, b->posSelf);
+  TEST_ASSERT_EQUAL_INT32(a->posOther, b->posOther);
+  TEST_ASSERT_EQUAL_INT32(a->posBallX, b->posBallX);
+  TEST_ASSERT_EQUAL_INT32(a->posBallY, b->posBallY);
+  TEST_ASSERT_EQUAL_INT32(a->speedBallX, b->speedBallX);
+  TEST_ASSERT_EQUAL_INT32(a->speedBallY, b->speedBallY);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_layout_is_little_endian_and_packed() {
+  PongGameState state;
+  memset(&state, 0, sizeof(state));
+  state.frameID = 0x12345678;
+  state.scoreSelf = 5; state.scoreOther = 63;
+  state.dirSelf = -1; state.dirOther = 1;
+  state.posSelf = 32000; state.posOther = -1;
+  state.posBallX = 0x123456; state.posBallY = -0x123456;
+  state.speedBallX = 450; state.speedBallY = -300;
+  const uint8_t expected[WIRE_GAMESTATE_SIZE] = {
+    WIRE_VERSION,
+    0x78, 0x56, 0x34, 0x12,
+    0xc5, 0x8f, // 5 | 63<<6 | 0<<12 | 2<<14
+    0x00, 0x7d, 0x00, 0xff, 0xff, 0xff,
+    0x56, 0x34, 0x12, 0xaa, 0xcb, 0xed,
+    0xc2, 0x01, 0x00, 0xd4, 0xfe, 0xff
+  };
+  uint8_t buf[WIRE_GAMESTATE_SIZE];
+  encodeGameState(buf, &state);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buf, WIRE_GAMESTATE_SIZE);
+}
+
+void test_random_states_round_trip() {
+  uint8_t buf[WIRE_GAMESTATE_SIZE+1];
+  for (uint32_t i=0; i<ROUNDTRIPS; i++) {
+    PongGameState in, out;
+    randomState(&in);
+    buf[WIRE_GAMESTATE_SIZE] = 0xa5; // a write past the end shows here
+    encodeGameState(buf, &in);
+    TEST_ASSERT_EQUAL_HEX8(0xa5, buf[WIRE_GAMESTATE_SIZE]);
+    PongGameStateView view(buf);
+    TEST_ASSERT_TRUE(view.valid());
+    TEST_ASSERT_EQUAL_UINT32(in.frameID, view.frameID());
+    TEST_ASSERT_EQUAL_INT32(in.posBallX, view.posBallX());
+    view.decode(&out);
+    assertSameState(&in, &out);
+  }
+}
+
+void test_scores_saturate_and_versions_are_checked() {
+  PongGameState in, out;
+  randomState(&in);
+  in.scoreSelf = 64; in.scoreOther = 255;
+  uint8_t buf[WIRE_GAMESTATE_SIZE];
+  encodeGameState(buf, &in);
+  PongGameStateView(buf).decode(&out);
+  TEST_ASSERT_EQUAL_UINT8(63, out.scoreSelf);
+  TEST_ASSERT_EQUAL_UINT8(63, out.scoreOther);
+  TEST_ASSERT_EQUAL_INT8(in.dirSelf, out.dirSelf); // the saturated scores do not spill into the directions
+  TEST_ASSERT_EQUAL_INT8(in.dirOther, out.dirOther);
+  buf[0] = WIRE_VERSION+1;
+  TEST_ASSERT_FALSE(PongGameStateView(buf).valid());
+}
+
+void test_size_and_throughput() {
+  static PongGameState states[1024];
+  static uint8_t wire[1024][WIRE_GAMESTATE_SIZE];
+  for (int i=0; i<1024; i++) randomState(&states[i]);
+  volatile uint32_t sink = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint32_t i=0; i<ROUNDTRIPS; i++) encodeGameState(wire[i%1024], &states[i%1024]);
+  std::chrono::steady_clock::time_point encoded = std::chrono::steady_clock::now();
+  PongGameState out;
+  for (uint32_t i=0; i<ROUNDTRIPS; i++) { PongGameStateView(wire[i%1024]).decode(&out); sink += out.posBallX; }
+  std::chrono::steady_clock::time_point decoded = std::chrono::steady_clock::now();
+  double encodeNs = std::chrono::duration<double, std::nano>(encoded-start).count()/ROUNDTRIPS;
+  double decodeNs = std::chrono::duration<double, std::nano>(decoded-encoded).count()/ROUNDTRIPS;
+  char msg[200];
+  snprintf(msg, sizeof(msg), "%d wire bytes for a %d byte state (40 with the old padding), %d states per KB of history; encode %.1f ns (%.0f MB/s), decode %.1f ns",
+           WIRE_GAMESTATE_SIZE, (int)sizeof(PongGameState), 1024/(int)sizeof(PongGameState), encodeNs, WIRE_GAMESTATE_SIZE/encodeNs*1e3, decodeNs);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(WIRE_GAMESTATE_SIZE<sizeof(PongGameState));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_layout_is_little_endian_and_packed);
+  RUN_TEST(test_random_states_round_trip);
+  RUN_TEST(test_scores_saturate_and_versions_are_checked);
+  RUN_TEST(test_size_and_throughput);
+  return UNITY_END();
+}
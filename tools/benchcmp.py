@@ -0,0 +1,45 @@
+"""
+Compares two outputs of the b2BENCHMARK build (see src/benchmark.h).
+
+  python tools/benchcmp.py baseline.json current.json [--threshold 10]
+
+Either file may also be a raw serial log, the JSON object is cut out of it.
+Exits with 1 if any benchmark got slower by more than threshold percent.
+"""
+import json
+import sys
+
+
+def load(path):
+    text = open(path).read()
+    start, end = text.index("{"), text.rindex("}")
+    results = json.loads(text[start:end + 1])["benchmarks"]
+    return dict(((r["name"], r["param"]), r["ns_per_op"]) for r in results)
+
+
+def main(argv):
+    threshold = 10.0
+    if "--threshold" in argv:
+        i = argv.index("--threshold")
+        threshold = float(argv[i + 1])
+        del argv[i:i + 2]
+    if len(argv) != 3:
+        print(__doc__.strip())
+        return 2
+    base, cur = load(argv[1]), load(argv[2])
+    regressed = False
+    print("%-24s %6s %10s %10s %8s" % ("benchmark", "param", "base ns", "now ns", "change"))
+    for key in sorted(cur):
+        if key not in base:
+            print("%-24s %6d %10s %10d %8s" % (key[0], key[1], "-", cur[key], "new"))
+            continue
+        change = (cur[key] - base[key]) * 100.0 / max(base[key], 1)
+        flag = ""
+        if change > threshold:
+            flag, regressed = " SLOWER", True
+        print("%-24s %6d %10d %10d %+7.1f%%%s" % (key[0], key[1], base[key], cur[key], change, flag))
+    return 1 if regressed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
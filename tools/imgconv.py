@@ -0,0 +1,161 @@
+"""
+Converts the images in resources/ into SSD1306 page ordered byte arrays.
+
+Runs before every build as a PlatformIO extra script (see platformio.ini) and
+only regenerates the headers in src/img/ whose source changed. It can also be
+run by hand: python tools/imgconv.py [--force]
+
+Page order is the layout of the display framebuffer: one byte covers 8 rows of
+one column, bit 0 being the top row, pages follow each other top to bottom.
+Images are RLE compressed when that makes them smaller:
+  0x00-0x7f n: n+1 literal bytes follow
+  0x80-0xff n: the next byte is repeated n-0x80+2 times
+"""
+import os
+import re
+import struct
+import sys
+import zlib
+
+# (name, source) pairs, the header is written to src/img/<name>_pages.h
+IMAGES = [
+    ("win", "resources/cup.png"),
+    ("lose", "resources/lose.png"),
+]
+
+
+def read_xbm(path):
+    text = open(path).read()
+    width = int(re.search(r"_width\s+(\d+)", text).group(1))
+    height = int(re.search(r"_height\s+(\d+)", text).group(1))
+    data = [int(v, 16) for v in re.findall(r"0x([0-9a-fA-F]{2})", text.split("{", 1)[1])]
+    stride = (width + 7) // 8
+    pixels = [[(data[y * stride + x // 8] >> (x % 8)) & 1 for x in range(width)] for y in range(height)]
+    return width, height, pixels
+
+
+def read_png(path):
+    # 8 bit grayscale/RGB/RGBA, non interlaced PNGs; a pixel is set when it is opaque and dark
+    data = open(path, "rb").read()
+    pos, idat = 8, b""
+    while pos < len(data):
+        length, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        chunk = data[pos + 8:pos + 8 + length]
+        if kind == b"IHDR":
+            width, height, depth, color, _, _, interlace = struct.unpack(">IIBBBBB", chunk)
+        elif kind == b"IDAT":
+            idat += chunk
+        pos += 12 + length
+    channels = {0: 1, 2: 3, 4: 2, 6: 4}.get(color)
+    if depth != 8 or channels is None or interlace:
+        raise ValueError("%s: unsupported PNG format" % path)
+    raw = zlib.decompress(idat)
+    stride = width * channels
+    prev, rows = bytearray(stride), []
+    for y in range(height):
+        filt, line = raw[y * (stride + 1)], bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = line[i - channels] if i >= channels else 0
+            b = prev[i]
+            c = prev[i - channels] if i >= channels else 0
+            if filt == 1:
+                line[i] = (line[i] + a) & 0xff
+            elif filt == 2:
+                line[i] = (line[i] + b) & 0xff
+            elif filt == 3:
+                line[i] = (line[i] + (a + b) // 2) & 0xff
+            elif filt == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                line[i] = (line[i] + (a if pa <= pb and pa <= pc else b if pb <= pc else c)) & 0xff
+        rows.append(line)
+        prev = line
+    pixels = []
+    for line in rows:
+        row = []
+        for x in range(width):
+            px = line[x * channels:(x + 1) * channels]
+            alpha = px[-1] if channels in (2, 4) else 255
+            lum = sum(px[:3]) // 3 if channels >= 3 else px[0]
+            row.append(1 if alpha >= 128 and lum < 128 else 0)
+        pixels.append(row)
+    return width, height, pixels
+
+
+def to_pages(width, height, pixels):
+    pages = (height + 7) // 8
+    out = bytearray(width * pages)
+    for y in range(height):
+        for x in range(width):
+            if pixels[y][x]:
+                out[(y // 8) * width + x] |= 1 << (y % 8)
+    return pages, out
+
+
+def rle(data):
+    out, i = bytearray(), 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < 129:
+            run += 1
+        if run >= 2:
+            out += bytes([0x80 + run - 2, data[i]])
+            i += run
+            continue
+        start = i
+        while i < len(data) and i - start < 128 and (i + 1 >= len(data) or data[i + 1] != data[i]):
+            i += 1
+        out += bytes([i - start - 1]) + data[start:i]
+    return out
+
+
+def unrle(data):
+    out, i = bytearray(), 0
+    while i < len(data):
+        if data[i] < 0x80:
+            out += data[i + 1:i + 2 + data[i]]
+            i += 2 + data[i]
+        else:
+            out += bytes([data[i + 1]]) * (data[i] - 0x80 + 2)
+            i += 2
+    return out
+
+
+def convert(root, name, source, force=False):
+    src = os.path.join(root, source)
+    dst = os.path.join(root, "src", "img", name + "_pages.h")
+    if not force and os.path.exists(dst) and os.path.getmtime(dst) >= os.path.getmtime(src):
+        return
+    width, height, pixels = read_png(src) if src.endswith(".png") else read_xbm(src)
+    pages, raw = to_pages(width, height, pixels)
+    packed = rle(raw)
+    assert unrle(packed) == raw
+    compressed = len(packed) < len(raw)
+    data = packed if compressed else raw
+    lines = ["// generated by tools/imgconv.py from %s, do not edit" % source,
+             "#include \"image.h\"",
+             "",
+             "const uint8_t %s_pages_data[] PROGMEM = {" % name]
+    for i in range(0, len(data), 12):
+        lines.append("   " + " ".join("0x%02x," % b for b in data[i:i + 12]))
+    lines += ["};",
+              "const PongImage %s_pages = { %d, %d, %s, sizeof(%s_pages_data), %s_pages_data };" %
+              (name, width, pages, "true" if compressed else "false", name, name),
+              ""]
+    open(dst, "w").write("\n".join(lines))
+    xbm = ((width + 7) // 8) * height
+    print("imgconv: %s -> %s: xbm %d bytes, pages %d bytes, rle %d bytes (%s)" %
+          (source, os.path.relpath(dst, root), xbm, len(raw), len(packed), "compressed" if compressed else "raw"))
+
+
+def main(root, force=False):
+    for name, source in IMAGES:
+        convert(root, name, source, force)
+
+
+try:
+    Import("env")  # noqa: F821 -- running as a PlatformIO extra script
+    main(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        main(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), "--force" in sys.argv)
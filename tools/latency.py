@@ -0,0 +1,95 @@
+"""
+Percentiles of the input latency histograms (see src/metrics.h).
+
+  python tools/latency.py dump.txt [other.txt ...]
+  python tools/latency.py /dev/ttyUSB0
+
+Send L on the serial port (115200 baud) of a board to get its histograms
+as one "latency v1 ..." line and save it, or give the serial device to ask
+the board directly. Every stage is printed with its count and the median,
+90th and 99th percentile; a value is the upper end of its log2 bucket, so
+it is at most twice the real one. The stages of one change are split over
+the two boards: send is measured on the sender, the others on the board
+that draws the change.
+"""
+import os
+import sys
+import termios
+import time
+import tty
+
+BUCKETS = 24  # LATENCY_BUCKETS in src/metrics.h
+STAGES = ["send", "wire", "queue", "apply", "draw", "total"]
+
+
+def parse(line):
+    fields = line.split()
+    if len(fields) < 2 or fields[0] != "latency" or fields[1] != "v1":
+        return None
+    hist = {}
+    for field in fields[2:]:
+        name, counts = field.split("=")
+        hist[name] = [int(c) for c in counts.split(",")]
+    return hist
+
+
+def upper(bucket):  # us, bucket 0 is everything below 1 us
+    return 1 if bucket == 0 else 1 << bucket
+
+
+def percentile(counts, p):
+    total = sum(counts)
+    seen = 0
+    for bucket, count in enumerate(counts):
+        seen += count
+        if seen * 100 >= total * p:
+            return upper(bucket)
+    return upper(BUCKETS - 1)
+
+
+def report(name, hist):
+    print(name)
+    for stage in STAGES:
+        counts = hist.get(stage, [0] * BUCKETS)
+        if not sum(counts):
+            print("  %-6s %8d" % (stage, 0))
+            continue
+        print("  %-6s %8d  p50<=%8d us  p90<=%8d us  p99<=%8d us"
+              % ((stage, sum(counts)) + tuple(percentile(counts, p) for p in (50, 90, 99))))
+
+
+def ask(device):
+    fd = os.open(device, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    attrs = termios.tcgetattr(fd)
+    attrs[4] = attrs[5] = termios.B115200
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    os.write(fd, b"L")
+    data, deadline = b"", time.time() + 3
+    while time.time() < deadline:  # the line is trickled out over a few frames
+        data += os.read(fd, 4096)
+        for line in data.split(b"\n")[:-1]:
+            hist = parse(line.decode(errors="replace"))
+            if hist:
+                return hist
+    raise TimeoutError("no latency line from %s" % device)
+
+
+def main(argv):
+    if len(argv) < 2:
+        print(__doc__.strip())
+        return 2
+    for arg in argv[1:]:
+        if arg.startswith("/dev/"):
+            report(arg, ask(arg))
+            continue
+        with open(arg) as f:
+            for line in f:
+                hist = parse(line)
+                if hist:
+                    report(arg, hist)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,443 @@
+"""
+Simulated client boards to load a match server (see src/networkWiFi.cpp).
+
+  python tools/loadgen.py [host] [--clients 1000] [--step 100] [--step-time 10]
+                          [--change-rate 2] [--port 5263]
+  python tools/loadgen.py --selftest [--clients 1000] [--step 250] [--rally 3]
+
+Opens --step more connections every --step-time seconds until there are
+--clients of them (host defaults to the access point, 192.168.4.1). Each
+runs the client side of a board: it answers the server's 20 latency pings,
+sends its own 20 and reads the session, then plays every round the server
+starts with R at 30 frames a second. Its paddle chases a new random target
+--change-rate times a second the way the AI chases the ball, so direction
+changes (C) come in bursts of steer and stop; a silent paddle sends a
+keepalive every 15 frames, and between the rounds a K every half second
+like the board. A potential score (P) is acknowledged (Q) once
+the client's frame reaches it, a final score (F) is answered with a
+ready (Y) at once, as if the player touched the win/lose screen right
+away (the server ignores it after a point that did not end the match).
+
+After every step the first client asks the server for its metrics (M) on
+the game socket, the snapshot (FLGMET, see src/metrics.h) is printed with
+the next step as name=value pairs.
+
+After every step it prints the clients playing, the connect time up to the
+session (percentiles in ms), the one-way latency of the server's C messages
+(their send stamp moved onto our clock with the offset of the fastest ping,
+as the board does it) and the errors of the step: refused, timeout (a
+handshake step took longer than 10 s), closed and bad (bytes that are no
+message). The board itself plays with a single client, the others wait in
+its accept backlog until they time out; the numbers are meant for a host
+server speaking the same protocol.
+
+--selftest starts such a stand-in server on a free local port: it plays
+the server side against every connection, scoring a point every --rally
+seconds, and answers M with its own frame and message counts. It exits
+with 1 if a client failed, the clock offset was off or a snapshot did not
+come.
+
+All clients share one event loop and one frame ticker; a client is a small
+object and one reader coroutine. Thousands of them need as many file
+descriptors, the soft limit is raised to the hard one.
+"""
+import asyncio
+import random
+import struct
+import sys
+import time
+
+from metrics import NAMES
+
+PORT = 5263
+FRAME_US = 33333  # FRAME_TIME
+CALIBRATION_COUNT = 20
+KEEPALIVE_FRAMES = 15
+KEEPALIVE_INTERVAL = 0.5  # s, K between the rounds
+HANDSHAKE_TIMEOUT = 10.0  # s for every step of the handshake, CONNECT_TIMEOUT on the board
+SCORE_ACK_TIMEOUT = 90  # frames the stand-in server waits for a Q
+BODY = {b"C": 13, b"P": 12, b"Q": 12, b"F": 5, b"R": 7, b"K": 0, b"M": 0, b"Y": 0}  # bytes after the command byte
+METRICS_HEADER = b"FLGMET"  # an F whose body reads LGMET is a snapshot (a frame ID of 1.2 billion is not)
+ERRORS = ("refused", "timeout", "closed", "bad")
+
+
+def micros():
+    return int(time.monotonic() * 1000000) & 0xffffffff
+
+
+def since(now, then):  # like the board's unsigned subtraction, as a signed difference
+    return ((now - then + 0x80000000) & 0xffffffff) - 0x80000000
+
+
+def percentiles(values, ps=(50, 90, 99)):
+    if not values:
+        return "-"
+    values = sorted(values)
+    return "/".join("%.1f" % values[min(len(values) - 1, len(values) * p // 100)] for p in ps)
+
+
+def msg_c(frame, direction, capture):
+    return b"C" + struct.pack("<IbII", frame, direction, capture, micros())
+
+
+def msg_score(cmd, frame, received, sent):
+    return cmd + struct.pack("<III", frame, received, sent)
+
+
+def msg_metrics(counters):  # like encodeMetrics, the counters not given are 0
+    values = [counters.get(name, 0) for name in NAMES]
+    return METRICS_HEADER + struct.pack("<BB%dI" % len(values), 1, len(values), *values)
+
+
+async def read_metrics(reader):  # the rest of a snapshot after its header
+    version, count = struct.unpack("<BB", await reader.readexactly(2))
+    values = struct.unpack("<%dI" % count, await reader.readexactly(count * 4))
+    names = NAMES if version == 1 else []
+    return [(names[i] if i < len(names) else "counter%d" % i, v) for i, v in enumerate(values)]
+
+
+class Step:
+    """What happened while one load step ran."""
+
+    def __init__(self, clients):
+        self.clients = clients
+        self.connect_ms = []
+        self.latency_ms = []
+        self.errors = dict.fromkeys(ERRORS, 0)
+        self.metrics = None  # the server's snapshot asked for at the end of the step before
+
+
+class Client:
+    __slots__ = ("reader", "writer", "rng", "offset", "recv_latency", "round_start", "frame",
+                 "pos", "target", "dir", "last_sent", "last_received", "ack_frame", "playing", "alive",
+                 "last_write")
+
+    change_rate = 2.0  # new targets a second, --change-rate
+
+    def __init__(self, seed):
+        self.reader = self.writer = None
+        self.rng = random.Random(seed)
+        self.offset = 0  # the server's micros() minus ours
+        self.recv_latency = 0
+        self.round_start = None
+        self.frame = 0
+        self.pos = self.target = 32000  # paddle center in 1/1000 pixel, 64 pixels high arena
+        self.dir = 0
+        self.last_sent = self.last_received = self.ack_frame = 0
+        self.playing = False
+        self.alive = True
+        self.last_write = 0.0  # time.monotonic() of the last K
+
+    async def expect(self, cmd, extra=0):
+        data = await asyncio.wait_for(self.reader.readexactly(len(cmd) + extra), HANDSHAKE_TIMEOUT)
+        if data[:len(cmd)] != cmd:
+            raise ValueError("expected %r, got %r" % (cmd, data))
+        return data[len(cmd):]
+
+    async def handshake(self):
+        # the server pings first and we answer with our clock
+        for _ in range(CALIBRATION_COUNT):
+            await self.expect(b"CALIBREQU")
+            self.writer.write(b"CALIBRESP" + struct.pack("<I", micros()))
+        await self.expect(b"CALIBDONE")
+        # then we ping, the fastest answer gives the offset of the server's clock
+        rtts, best = [], None
+        for _ in range(CALIBRATION_COUNT):
+            start = micros()
+            self.writer.write(b"CALIBREQU")
+            remote = struct.unpack("<I", await self.expect(b"CALIBRESP", 4))[0]
+            rtt = since(micros(), start)
+            if best is None or rtt < best:
+                best, self.offset = rtt, since(remote, (start + rtt // 2) & 0xffffffff)
+            rtts.append(rtt)
+        self.writer.write(b"CALIBDONE")
+        rtts.sort()
+        self.recv_latency = sum(rtts[1:-1]) // ((CALIBRATION_COUNT - 2) * 2)
+        await self.expect(b"SESSION", 4)
+
+    def tick(self, now):  # one frame, from the shared ticker
+        frame = (since(now, self.round_start) + self.recv_latency) // FRAME_US
+        while self.frame < frame:  # a late tick plays the frames it missed
+            self.frame += 1
+            if self.rng.random() * 30 < self.change_rate:
+                self.target = self.rng.randrange(4000, 60000)
+            diff = self.target - self.pos
+            direction = 0 if abs(diff) < 4000 else (1 if diff > 0 else -1)
+            self.pos += direction * 1000
+            if direction != self.dir or self.frame - self.last_sent >= KEEPALIVE_FRAMES:
+                self.dir = direction
+                self.writer.write(msg_c(self.frame, direction, now))
+                self.last_sent = self.frame
+            if self.ack_frame and self.frame >= self.ack_frame:
+                self.writer.write(msg_score(b"Q", self.frame, self.last_received, self.last_sent))
+                self.ack_frame = 0
+
+    def idle(self, now):  # between the rounds the link is kept alive
+        if now - self.last_write >= KEEPALIVE_INTERVAL:
+            self.writer.write(b"K")
+            self.last_write = now
+
+    def handle(self, cmd, body, rx, step):
+        if cmd == b"C":
+            frame, _, _, sent = struct.unpack("<IbII", body)
+            self.last_received = frame
+            step.latency_ms.append(since(rx, (sent - self.offset) & 0xffffffff) / 1000.0)
+        elif cmd == b"P":
+            self.ack_frame = struct.unpack("<I", body[:4])[0]
+        elif cmd == b"F":
+            self.playing = False  # until the next round
+            self.writer.write(b"Y")
+        elif cmd == b"R":
+            self.round_start, self.frame = rx, 0
+            self.last_sent = self.last_received = self.ack_frame = 0
+            self.pos = self.target = 32000
+            self.dir = 0
+            self.playing = True
+
+
+class LoadGenerator:
+    def __init__(self, host, port):
+        self.host, self.port = host, port
+        self.clients = []
+        self.step = Step(0)
+        self.snapshots = 0
+
+    def error(self, kind):
+        self.step.errors[kind] += 1
+
+    async def run_client(self, seed):
+        client = Client(seed)
+        self.clients.append(client)
+        start = time.monotonic()
+        try:
+            try:
+                client.reader, client.writer = await asyncio.wait_for(
+                    asyncio.open_connection(self.host, self.port), HANDSHAKE_TIMEOUT)
+            except (ConnectionRefusedError, OSError):
+                self.error("refused")
+                return
+            await client.handshake()
+            self.step.connect_ms.append((time.monotonic() - start) * 1000)
+            reader = client.reader
+            while True:
+                cmd = await reader.readexactly(1)
+                if cmd not in BODY:
+                    self.error("bad")  # the board skips it too
+                    continue
+                body = await reader.readexactly(BODY[cmd])
+                if cmd + body == METRICS_HEADER:
+                    self.step.metrics = await read_metrics(reader)
+                    self.snapshots += 1
+                    continue
+                client.handle(cmd, body, micros(), self.step)
+        except asyncio.TimeoutError:
+            self.error("timeout")
+        except (asyncio.IncompleteReadError, ConnectionError):
+            self.error("closed")
+        except ValueError:
+            self.error("bad")
+        except asyncio.CancelledError:
+            pass
+        finally:
+            client.alive = False
+            if client.writer:
+                client.writer.close()
+
+    async def ticker(self):
+        next_tick = time.monotonic()
+        while True:
+            next_tick += FRAME_US / 1000000.0
+            await asyncio.sleep(max(0, next_tick - time.monotonic()))
+            now, idle_now = micros(), time.monotonic()
+            for client in self.clients:
+                if client.alive and client.playing:
+                    client.tick(now)
+                elif client.alive and client.writer and client.round_start is not None:
+                    client.idle(idle_now)
+
+    def report(self):
+        step = self.step
+        playing = sum(1 for c in self.clients if c.alive and c.playing)
+        print("clients=%d playing=%d connect_ms=%s latency_ms=%s msgs=%d %s"
+              % (step.clients, playing, percentiles(step.connect_ms), percentiles(step.latency_ms),
+                 len(step.latency_ms), " ".join("%s=%d" % kv for kv in step.errors.items())))
+        if step.metrics:
+            print("  server " + " ".join("%s=%d" % kv for kv in step.metrics))
+        sys.stdout.flush()
+
+    def ask_metrics(self):  # the answer lands in the next step
+        for client in self.clients:
+            if client.alive and client.round_start is not None:
+                client.writer.write(b"M")
+                return
+
+    async def run(self, total, per_step, step_time):
+        ticker = asyncio.ensure_future(self.ticker())
+        tasks, seed, steps = [], 5263, []
+        print("step connect_ms and latency_ms are p50/p90/p99")
+        while len(tasks) < total:
+            count = min(per_step, total - len(tasks))
+            self.step = Step(len(tasks) + count)
+            steps.append(self.step)
+            for i in range(count):  # spread over the first second, not a single burst
+                tasks.append(asyncio.ensure_future(self.run_client(seed)))
+                seed += 1
+                await asyncio.sleep(1.0 / count)
+            await asyncio.sleep(max(0, step_time - 1))
+            self.report()
+            self.ask_metrics()
+        for task in tasks + [ticker]:
+            task.cancel()
+        await asyncio.gather(*tasks, ticker, return_exceptions=True)
+        return steps
+
+
+class StandInServer:
+    """The server side of a board against every connection, for --selftest."""
+
+    def __init__(self, rally):
+        self.rally_frames = int(rally * 1000000 / FRAME_US)
+        self.connections = set()
+        self.frames = self.rx_msgs = 0  # of all connections, for the snapshots
+
+    async def close(self):
+        for task in self.connections:
+            task.cancel()
+        await asyncio.gather(*self.connections, return_exceptions=True)
+
+    async def serve(self, reader, writer):
+        task = asyncio.current_task()
+        self.connections.add(task)
+        async def expect(cmd, extra=0):
+            data = await asyncio.wait_for(reader.readexactly(len(cmd) + extra), HANDSHAKE_TIMEOUT)
+            if data[:len(cmd)] != cmd:
+                raise ValueError("expected %r, got %r" % (cmd, data))
+        try:
+            for _ in range(CALIBRATION_COUNT):
+                writer.write(b"CALIBREQU")
+                await expect(b"CALIBRESP", 4)
+            writer.write(b"CALIBDONE")
+            for _ in range(CALIBRATION_COUNT):
+                await expect(b"CALIBREQU")
+                writer.write(b"CALIBRESP" + struct.pack("<I", micros()))
+            await expect(b"CALIBDONE")
+            writer.write(b"SESSION" + struct.pack("<I", random.getrandbits(32)))
+            await self.play(reader, writer)
+        except (asyncio.IncompleteReadError, ConnectionError, asyncio.TimeoutError, ValueError, asyncio.CancelledError):
+            pass
+        finally:
+            writer.close()
+            self.connections.discard(task)
+
+    async def play(self, reader, writer):
+        state = {"received": 0, "acked": 0}
+
+        async def receive():  # returns when the client is gone
+            try:
+                while True:
+                    cmd = await reader.readexactly(1)
+                    body = await reader.readexactly(BODY[cmd])
+                    self.rx_msgs += 1
+                    if cmd in (b"K", b"Y"):  # every round is served at once
+                        continue
+                    if cmd == b"M":
+                        writer.write(msg_metrics({"frames": self.frames, "rx_msgs": self.rx_msgs}))
+                        continue
+                    frame = struct.unpack("<I", body[:4])[0]
+                    if cmd == b"C":
+                        state["received"] = frame
+                    elif cmd == b"Q":
+                        state["acked"] = frame
+            except (asyncio.IncompleteReadError, ConnectionError, KeyError):
+                pass
+        receiver = asyncio.ensure_future(receive())
+        try:
+            rng, round_no = random.Random(), 0
+            while not receiver.done():
+                round_no += 1
+                writer.write(b"R" + struct.pack("<IBBB", round_no, 0, 0, 0))
+                state["acked"], start, frame, last_sent, score_frame = 0, time.monotonic(), 0, 0, 0
+                direction = 0
+                while not receiver.done():
+                    frame += 1
+                    self.frames += 1
+                    await asyncio.sleep(max(0, start + frame * FRAME_US / 1000000.0 - time.monotonic()))
+                    if rng.random() < 0.05:
+                        direction = rng.choice((-1, 0, 1))
+                        writer.write(msg_c(frame, direction, micros()))
+                        last_sent = frame
+                    elif frame - last_sent >= KEEPALIVE_FRAMES:
+                        writer.write(msg_c(frame, direction, micros()))
+                        last_sent = frame
+                    if not score_frame and frame >= self.rally_frames:
+                        score_frame = frame
+                        writer.write(msg_score(b"P", frame, state["received"], last_sent))
+                    if score_frame and (state["acked"] >= score_frame or frame - score_frame > SCORE_ACK_TIMEOUT):
+                        writer.write(b"F" + struct.pack("<Ib", score_frame, rng.choice((-1, 1))))
+                        break
+        finally:
+            receiver.cancel()
+
+
+async def selftest(total, per_step, step_time, rally):
+    server = StandInServer(rally)
+    srv = await asyncio.start_server(server.serve, "127.0.0.1", 0, backlog=total)
+    port = srv.sockets[0].getsockname()[1]
+    generator = LoadGenerator("127.0.0.1", port)
+    steps = await generator.run(total, per_step, step_time)
+    srv.close()
+    await server.close()
+    offsets = [abs(c.offset) for c in generator.clients if c.round_start is not None]
+    failed = sum(sum(s.errors.values()) for s in steps)
+    connected = sum(len(s.connect_ms) for s in steps)
+    print("%d of %d clients connected, %d errors, worst clock offset %d us, %d metrics snapshots"
+          % (connected, total, failed, max(offsets) if offsets else -1, generator.snapshots))
+    # the clients and the server share the clock, the offset is only the scheduling noise
+    if failed or connected != total or not offsets or max(offsets) > 5000 or generator.snapshots < len(steps) - 1:
+        print("self test failed")
+        return 1
+    return 0
+
+
+def option(argv, name, default):
+    if name not in argv:
+        return default
+    i = argv.index(name)
+    value = type(default)(argv[i + 1])
+    del argv[i:i + 2]
+    return value
+
+
+def raise_fd_limit():
+    try:
+        import resource
+        soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+        resource.setrlimit(resource.RLIMIT_NOFILE, (hard, hard))
+    except (ImportError, ValueError, OSError):
+        pass
+
+
+def main(argv):
+    if "-h" in argv or "--help" in argv:
+        print(__doc__.strip())
+        return 2
+    is_selftest = "--selftest" in argv
+    if is_selftest:
+        argv.remove("--selftest")
+    total = option(argv, "--clients", 1000)
+    per_step = option(argv, "--step", 250 if is_selftest else 100)
+    step_time = option(argv, "--step-time", 10.0)
+    rally = option(argv, "--rally", 3.0)
+    port = option(argv, "--port", PORT)
+    Client.change_rate = option(argv, "--change-rate", 2.0)
+    raise_fd_limit()
+    loop = asyncio.new_event_loop()
+    if is_selftest:
+        return loop.run_until_complete(selftest(total, per_step, step_time, rally))
+    host = argv[1] if len(argv) > 1 else "192.168.4.1"
+    loop.run_until_complete(LoadGenerator(host, port).run(total, per_step, step_time))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
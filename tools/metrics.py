@@ -0,0 +1,73 @@
+"""
+Reads the netcode health counters of the server (see src/metrics.h).
+
+  python tools/metrics.py [host] [--watch seconds]
+
+Connects to the spectator port of the access point (192.168.4.1:5264 by
+default), asks for a snapshot and prints it. The game state frames streamed
+meanwhile are skipped. With --watch it asks again every given seconds.
+"""
+import socket
+import struct
+import sys
+import time
+
+PORT = 5264
+STATE_FRAME = 6 + 25  # "FLGMST" + wire encoded game state (src/wire.h)
+NAMES = [
+    "frames", "overruns", "overrun_max_us",
+    "rollbacks", "rollback_frames", "rollback_max",
+    "late_msgs", "future_msgs", "future_max", "future_dropped",
+    "tx_bytes", "tx_msgs", "rx_bytes", "rx_msgs",
+    "scores", "score_timeouts", "score_us", "score_max_us",
+    "links_lost", "resumes", "fallbacks",
+    "idle_ms", "slept_ms", "jitter_max_us", "late_wakes",
+    "send_latency_us", "recv_latency_us", "rx_bad_frames",
+    "pred_frames", "pred_misses",
+    "serves", "serve_us", "serve_max_us",
+    "tx_resent_frames",
+]
+
+
+def read_exact(sock, n):
+    data = b""
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise EOFError("server closed the connection")
+        data += chunk
+    return data
+
+
+def snapshot(sock):
+    sock.sendall(b"M")
+    while True:
+        header = read_exact(sock, 6)
+        if header == b"FLGMST":
+            read_exact(sock, STATE_FRAME - 6)
+        elif header == b"FLGMET":
+            version, count = struct.unpack("<BB", read_exact(sock, 2))
+            values = struct.unpack("<%dI" % count, read_exact(sock, count * 4))
+            names = NAMES if version == 1 else []
+            return [(names[i] if i < len(names) else "counter%d" % i, v) for i, v in enumerate(values)]
+        else:
+            raise ValueError("unexpected frame %r" % header)
+
+
+def main(argv):
+    watch = None
+    if "--watch" in argv:
+        i = argv.index("--watch")
+        watch = float(argv[i + 1])
+        del argv[i:i + 2]
+    host = argv[1] if len(argv) > 1 else "192.168.4.1"
+    sock = socket.create_connection((host, PORT), timeout=5)
+    while True:
+        print(" ".join("%s=%d" % kv for kv in snapshot(sock)))
+        if watch is None:
+            return 0
+        time.sleep(watch)
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
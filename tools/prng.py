@@ -0,0 +1,53 @@
+"""
+Reference of the match random number generator (see src/prng.h).
+
+  python tools/prng.py [benchmark.json]
+
+Prints the first numbers drawn from the seed of the b2BENCHMARK run. Given
+the output (or serial log) of that run, it compares them with the sequence
+the board printed and exits with 1 if they differ.
+"""
+import json
+import sys
+
+SEED = 12345  # BENCH_PRNG_SEED in src/benchmark.cpp
+COUNT = 8
+MASK = 0xffffffff
+
+
+def prng_seed(seed):
+    return seed & MASK or 0x9e3779b9
+
+
+def prng_next(state):
+    state ^= (state << 13) & MASK
+    state ^= state >> 17
+    state ^= (state << 5) & MASK
+    return state
+
+
+def sequence(seed, count):
+    state, values = prng_seed(seed), []
+    for _ in range(count):
+        state = prng_next(state)
+        values.append(state)
+    return values
+
+
+def main(argv):
+    expected = sequence(SEED, COUNT)
+    if len(argv) < 2:
+        print(" ".join(str(v) for v in expected))
+        return 0
+    text = open(argv[1]).read()
+    start, end = text.index("{"), text.rindex("}")
+    board = json.loads(text[start:end + 1])["prng_sequence"]
+    if board != expected:
+        print("board: %s\nhost:  %s" % (board, expected))
+        return 1
+    print("identical: %s" % " ".join(str(v) for v in expected))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
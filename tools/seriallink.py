@@ -0,0 +1,164 @@
+"""
+Reference of the framing of the wired link (see src/serialframe.h).
+
+  python tools/seriallink.py --selftest
+  python tools/seriallink.py /dev/ttyUSB0
+
+--selftest sends frames over a pseudo-terminal pair, some of them damaged
+or cut by garbage, and checks that the receiver gets exactly the intact
+frames back; it prints the frame rate and exits with 1 on a mismatch. The
+resending of lost frames is tested on the host by test/test_serialframe.
+
+Given a serial device (a USB-UART adapter listening on the TX line of one
+board) it prints the frames going over the cable as they are decoded: the
+sequence number, the acknowledge and the message (a frame seen again is a
+resend, one without a message a bare acknowledge).
+"""
+import os
+import random
+import struct
+import sys
+import termios
+import time
+import tty
+
+SYNC = 0xB2
+MAX_PAYLOAD = 160
+OVERHEAD = 6
+BAUD = termios.B2000000  # SERIAL_LINK_BAUD in src/seriallink.h
+
+
+def crc16(data, crc=0xffff):  # CRC-16/CCITT-FALSE
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xffff
+    return crc
+
+
+def encode(payload, seq, ack):
+    assert len(payload) <= MAX_PAYLOAD
+    body = bytes([len(payload), seq, ack]) + payload
+    return bytes([SYNC]) + body + struct.pack("<H", crc16(body))
+
+
+class Decoder:
+    """Feed bytes in, get (seq, ack, payload) of the intact frames out."""
+
+    def __init__(self):
+        self.buf = b""
+        self.bad = 0
+
+    def feed(self, data):
+        self.buf += data
+        payloads = []
+        while self.buf:
+            if self.buf[0] != SYNC:
+                skip = self.buf.find(bytes([SYNC]))
+                self.buf = self.buf[skip:] if skip > 0 else b""
+                self.bad += 1
+                continue
+            if len(self.buf) < 2:
+                break
+            n = self.buf[1]
+            if n > MAX_PAYLOAD:
+                self.buf, self.bad = self.buf[1:], self.bad + 1
+                continue
+            if len(self.buf) < n + OVERHEAD:
+                break
+            if struct.unpack("<H", self.buf[n + 4:n + 6])[0] != crc16(self.buf[1:n + 4]):
+                self.buf, self.bad = self.buf[1:], self.bad + 1
+                continue
+            payloads.append((self.buf[2], self.buf[3], self.buf[4:n + 4]))
+            self.buf = self.buf[n + OVERHEAD:]
+        return payloads
+
+
+def describe(payload):  # the protocol messages of src/networkWiFi.cpp
+    kind = payload[:1]
+    if not payload:
+        return "ack"
+    if kind == b"C" and len(payload) == 14:
+        return "C frame=%d dir=%d captured=%d sent=%d" % struct.unpack("<IbII", payload[1:])
+    if kind == b"F" and len(payload) == 6:
+        return "F frame=%d scoring=%d" % struct.unpack("<Ib", payload[1:])
+    if kind in (b"P", b"Q") and len(payload) == 13:
+        return "%s frame=%d handled=%d should_receive=%d" % ((kind.decode(),) + struct.unpack("<III", payload[1:]))
+    if kind in (b"K", b"M", b"Y") and len(payload) == 1:
+        return kind.decode()
+    if payload[:6] == b"FLGMET":
+        return "FLGMET version=%d counters=%d" % struct.unpack("<BB", payload[6:8])
+    if kind == b"R" and len(payload) == 8:
+        return "R round=%d score=%d-%d lost=%d" % struct.unpack("<IBBB", payload[1:])
+    return repr(payload)
+
+
+def selftest():
+    master, slave = os.openpty()
+    for fd in (master, slave):
+        tty.setraw(fd)
+    os.set_blocking(slave, False)
+    rng = random.Random(5263)
+    sent, damaged, stream = [], 0, b""
+    for i in range(5000):
+        payload = bytes(rng.randrange(256) for _ in range(rng.randint(0, 13)))
+        ack = rng.randrange(256)
+        frame = encode(payload, i % 256, ack)
+        damage = rng.random()
+        if damage < 0.02:  # a flipped bit, the frame is lost
+            pos = rng.randrange(len(frame))
+            frame = frame[:pos] + bytes([frame[pos] ^ (1 << rng.randrange(8))]) + frame[pos + 1:]
+            damaged += 1
+        else:
+            if damage < 0.04:  # line noise in front
+                frame = bytes(rng.randrange(256) for _ in range(rng.randint(1, 5))) + frame
+            sent.append((i % 256, ack, payload))
+        stream += frame
+    decoder, received, start = Decoder(), [], time.time()
+    for pos in range(0, len(stream), 256):
+        os.write(master, stream[pos:pos + 256])
+        time.sleep(0.0001)
+        try:
+            received += decoder.feed(os.read(slave, 4096))
+        except BlockingIOError:
+            pass
+    deadline = time.time() + 1
+    while len(received) < len(sent) and time.time() < deadline:
+        try:
+            received += decoder.feed(os.read(slave, 4096))
+        except BlockingIOError:
+            time.sleep(0.01)
+    elapsed = time.time() - start
+    print("%d frames sent (%d of them damaged), %d intact received, %d bad spots skipped, %.0f frames/s"
+          % (len(sent) + damaged, damaged, len(received), decoder.bad, len(received) / elapsed))
+    if received != sent:
+        print("the received frames differ from the intact ones sent")
+        return 1
+    return 0
+
+
+def monitor(device):
+    fd = os.open(device, os.O_RDONLY | os.O_NOCTTY)
+    tty.setraw(fd)
+    attrs = termios.tcgetattr(fd)
+    attrs[4] = attrs[5] = BAUD
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    decoder, start = Decoder(), time.time()
+    while True:
+        for seq, ack, payload in decoder.feed(os.read(fd, 256)):
+            print("%10.3f %3d %3d %s" % (time.time() - start, seq, ack, describe(payload)))
+
+
+def main(argv):
+    if len(argv) < 2:
+        print(__doc__.strip())
+        return 2
+    if argv[1] == "--selftest":
+        return selftest()
+    monitor(argv[1])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))